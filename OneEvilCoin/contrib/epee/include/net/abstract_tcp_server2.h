@@ -48,7 +48,8 @@
 #include "syncobj.h"
 
 
-#define ABSTRACT_SERVER_SEND_QUE_MAX_COUNT 100
+//levin messages take one queue item each (head and body used to be queued separately)
+#define ABSTRACT_SERVER_SEND_QUE_MAX_COUNT 50
 
 namespace epee
 {
@@ -91,6 +92,7 @@ namespace net_utils
   private:
     //----------------- i_service_endpoint ---------------------
     virtual bool do_send(const void* ptr, size_t cb);
+    virtual bool do_send_shared(const void* head, size_t head_cb, const shared_buffer& body);
     virtual bool close();
     virtual bool call_run_once_service_io();
     virtual bool request_callback();
@@ -100,6 +102,8 @@ namespace net_utils
     //------------------------------------------------------
     boost::shared_ptr<connection<t_protocol_handler> > safe_shared_from_this();
     bool shutdown();
+    bool push_send_que(const void* head, size_t head_cb, const shared_buffer& body);
+    void start_write();
     /// Handle completion of a read operation.
     void handle_read(const boost::system::error_code& e,
       std::size_t bytes_transferred);
@@ -119,8 +123,15 @@ namespace net_utils
     t_connection_context context;
     volatile uint32_t m_want_close_connection;
     std::atomic<bool> m_was_shutdown;
+    /// Head copied into the queue and body shared with other connections, written with one vectored write.
+    struct send_item
+    {
+      std::string head;
+      shared_buffer body;
+    };
+
     critical_section m_send_que_lock;
-    std::list<std::string> m_send_que;
+    std::list<send_item> m_send_que;
     volatile uint32_t& m_ref_sockets_count;
     i_connection_filter* &m_pfilter;
     volatile bool m_is_multithreaded;
@@ -287,6 +287,18 @@ PRAGMA_WARNING_DISABLE_VS(4355)
   //---------------------------------------------------------------------------------
   template<class t_protocol_handler>
   bool connection<t_protocol_handler>::do_send(const void* ptr, size_t cb)
+  {
+    return push_send_que(ptr, cb, shared_buffer());
+  }
+  //---------------------------------------------------------------------------------
+  template<class t_protocol_handler>
+  bool connection<t_protocol_handler>::do_send_shared(const void* head, size_t head_cb, const shared_buffer& body)
+  {
+    return push_send_que(head, head_cb, body);
+  }
+  //---------------------------------------------------------------------------------
+  template<class t_protocol_handler>
+  bool connection<t_protocol_handler>::push_send_que(const void* head, size_t head_cb, const shared_buffer& body)
   {
     TRY_ENTRY();
     // Use safe_shared_from_this, because of this is public method and it can be called on the object being deleted
@@ -296,6 +308,7 @@ PRAGMA_WARNING_DISABLE_VS(4355)
     if(m_was_shutdown)
       return false;
 
+    size_t cb = head_cb + (body ? body->size() : 0);
     LOG_PRINT("[sock " << socket_.native_handle() << "] SEND " << cb, LOG_LEVEL_4);
     context.m_last_send = time(NULL);
     context.m_send_cnt += cb;
@@ -312,7 +325,8 @@ PRAGMA_WARNING_DISABLE_VS(4355)
     }
 
     m_send_que.resize(m_send_que.size()+1);
-    m_send_que.back().assign((const char*)ptr, cb);
+    m_send_que.back().head.assign((const char*)head, head_cb);
+    m_send_que.back().body = body;
     
     if(m_send_que.size() > 1)
     {
@@ -326,18 +340,30 @@ PRAGMA_WARNING_DISABLE_VS(4355)
         return false;
       }
 
-      boost::asio::async_write(socket_, boost::asio::buffer(m_send_que.front().data(), m_send_que.front().size()),
-        //strand_.wrap(
-        boost::bind(&connection<t_protocol_handler>::handle_write, self, _1, _2)
-        //)
-        );
-      
-      LOG_PRINT_L4("[sock " << socket_.native_handle() << "] Async send requested " << m_send_que.front().size());
+      start_write();
+      LOG_PRINT_L4("[sock " << socket_.native_handle() << "] Async send requested " << cb);
     }
 
     return true;
 
-    CATCH_ENTRY_L0("connection<t_protocol_handler>::do_send", false);
+    CATCH_ENTRY_L0("connection<t_protocol_handler>::push_send_que", false);
+  }
+  //---------------------------------------------------------------------------------
+  template<class t_protocol_handler>
+  void connection<t_protocol_handler>::start_write()
+  {
+    //called with m_send_que_lock held, the front item stays in the queue until handle_write
+    const send_item& item = m_send_que.front();
+    boost::array<boost::asio::const_buffer, 2> buffers = {{
+      boost::asio::buffer(item.head),
+      item.body ? boost::asio::buffer(*item.body) : boost::asio::const_buffer()
+    }};
+
+    boost::asio::async_write(socket_, buffers,
+      //strand_.wrap(
+      boost::bind(&connection<t_protocol_handler>::handle_write, connection<t_protocol_handler>::shared_from_this(), _1, _2)
+      //)
+      );
   }
   //---------------------------------------------------------------------------------
   template<class t_protocol_handler>
@@ -401,10 +427,7 @@ PRAGMA_WARNING_DISABLE_VS(4355)
     }else
     {
       //have more data to send
-      boost::asio::async_write(socket_, boost::asio::buffer(m_send_que.front().data(), m_send_que.front().size()),
-        //strand_.wrap(
-          boost::bind(&connection<t_protocol_handler>::handle_write, connection<t_protocol_handler>::shared_from_this(), _1, _2));
-        //);
+      start_write();
     }
     CRITICAL_REGION_END();
 
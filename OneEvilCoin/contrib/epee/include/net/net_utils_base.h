@@ -29,6 +29,8 @@
 #ifndef _NET_UTILS_BASE_H_
 #define _NET_UTILS_BASE_H_
 
+#include <memory>
+#include <string>
 #include <boost/uuid/uuid.hpp>
 #include "string_tools.h"
 
@@ -104,12 +106,20 @@ namespace net_utils
 
 	};
 
+	//immutable message body, shared by the send queues of all connections it is sent to
+	typedef std::shared_ptr<const std::string> shared_buffer;
+
 	/************************************************************************/
 	/*                                                                      */
 	/************************************************************************/
 	struct i_service_endpoint
 	{
 		virtual bool do_send(const void* ptr, size_t cb)=0;
+    //sends the head followed by the body, endpoints able to write both at once keep a reference to the body instead of copying it
+    virtual bool do_send_shared(const void* head, size_t head_cb, const shared_buffer& body)
+    {
+      return do_send(head, head_cb) && do_send(body->data(), body->size());
+    }
     virtual bool close()=0;
     virtual bool call_run_once_service_io()=0;
     virtual bool request_callback()=0;
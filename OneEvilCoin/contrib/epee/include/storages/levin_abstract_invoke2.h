@@ -45,7 +45,7 @@ namespace epee
       std::string buff_to_send, buff_to_recv;
       stg.store_to_binary(buff_to_send);
 
-      int res = transport.invoke(command, buff_to_send, buff_to_recv);
+      int res = transport.invoke(command, std::move(buff_to_send), buff_to_recv);
       if( res <=0 )
       {
         LOG_PRINT_RED("Failed to invoke command " << command << " return code " << res, LOG_LEVEL_1);
@@ -72,7 +72,7 @@ namespace epee
       std::string buff_to_send;
       stg.store_to_binary(buff_to_send);
 
-      int res = transport.notify(command, buff_to_send);
+      int res = transport.notify(command, std::move(buff_to_send));
       if(res <=0 )
       {
         LOG_ERROR("Failed to notify command " << command << " return code " << res);
@@ -90,7 +90,7 @@ namespace epee
       std::string buff_to_send, buff_to_recv;
       stg.store_to_binary(buff_to_send);
 
-      int res = transport.invoke(command, buff_to_send, buff_to_recv, conn_id);
+      int res = transport.invoke(command, std::move(buff_to_send), buff_to_recv, conn_id);
       if( res <=0 )
       {
         LOG_PRINT_L1("Failed to invoke command " << command << " return code " << res);
@@ -115,7 +115,7 @@ namespace epee
       std::string buff_to_send, buff_to_recv;
       stg.store_to_binary(buff_to_send);
 
-      int res = transport.invoke_async(command, buff_to_send, conn_id, [cb, command](int code, const std::string& buff, typename t_transport::connection_context& context)->bool 
+      int res = transport.invoke_async(command, std::move(buff_to_send), conn_id, [cb, command](int code, const std::string& buff, typename t_transport::connection_context& context)->bool 
       {
         t_result result_struct = AUTO_VAL_INIT(result_struct);
         if( code <=0 )
@@ -153,7 +153,7 @@ namespace epee
       std::string buff_to_send, buff_to_recv;
       stg.store_to_binary(buff_to_send);
 
-      int res = transport.notify(command, buff_to_send, conn_id);
+      int res = transport.notify(command, std::move(buff_to_send), conn_id);
       if(res <=0 )
       {
         LOG_PRINT_RED_L0("Failed to notify command " << command << " return code " << res);
@@ -31,7 +31,9 @@
 #define __WINH_OBJ_H__
 
 #include <condition_variable>
+#include <map>
 #include <mutex>
+#include <thread>
 
 namespace epee
 {
@@ -135,39 +137,123 @@ namespace epee
   };
 
 
-#if defined(WINDWOS_PLATFORM)
+  // Reader/writer lock. Both shared and exclusive ownership are recursive for the owning thread,
+  // and a thread that owns the lock exclusively may also take it shared. Upgrading shared
+  // ownership to exclusive is not supported. Waiting writers block new readers.
   class shared_critical_section
   {
-  public: 
-    shared_critical_section()
+  public:
+    shared_critical_section(): m_exclusive_depth(0), m_waiting_writers(0)
+    {
+    }
+
+    //to make copy fake!
+    shared_critical_section(const shared_critical_section& section): m_exclusive_depth(0), m_waiting_writers(0)
     {
-      ::InitializeSRWLock(&m_srw_lock);
     }
+
     ~shared_critical_section()
-    {}
+    {
+    }
+
+    void lock_shared()
+    {
+      std::thread::id this_id = std::this_thread::get_id();
+      std::unique_lock<std::mutex> lock(m_mutex);
+      if (m_exclusive_depth != 0 && m_exclusive_owner == this_id)
+      {
+        ++m_exclusive_depth;
+        return;
+      }
+
+      auto reader = m_readers.find(this_id);
+      if (reader != m_readers.end())
+      {
+        ++reader->second;
+        return;
+      }
+
+      m_readers_cond.wait(lock, [this] { return m_exclusive_depth == 0 && m_waiting_writers == 0; });
+      m_readers.insert(std::make_pair(this_id, 1));
+    }
+
+    void unlock_shared()
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      if (m_exclusive_depth != 0 && m_exclusive_owner == std::this_thread::get_id())
+      {
+        release_exclusive();
+        return;
+      }
+
+      auto reader = m_readers.find(std::this_thread::get_id());
+      if (reader != m_readers.end() && --reader->second == 0)
+      {
+        m_readers.erase(reader);
+        if (m_readers.empty())
+          m_writers_cond.notify_one();
+      }
+    }
+
+    void lock_exclusive()
+    {
+      std::thread::id this_id = std::this_thread::get_id();
+      std::unique_lock<std::mutex> lock(m_mutex);
+      if (m_exclusive_depth != 0 && m_exclusive_owner == this_id)
+      {
+        ++m_exclusive_depth;
+        return;
+      }
 
-    bool lock_shared()
+      ++m_waiting_writers;
+      m_writers_cond.wait(lock, [this] { return m_exclusive_depth == 0 && m_readers.empty(); });
+      --m_waiting_writers;
+      m_exclusive_owner = this_id;
+      m_exclusive_depth = 1;
+    }
+
+    void unlock_exclusive()
     {
-      AcquireSRWLockShared(&m_srw_lock);
-      return true;
+      std::unique_lock<std::mutex> lock(m_mutex);
+      release_exclusive();
     }
-    bool unlock_shared()
+
+    // critical_region_t interface, takes the lock exclusively
+    void lock()
     {
-      ReleaseSRWLockShared(&m_srw_lock);
-      return true;
+      lock_exclusive();
     }
-    bool lock_exclusive()
+
+    void unlock()
     {
-      ::AcquireSRWLockExclusive(&m_srw_lock);
-      return true;
+      unlock_exclusive();
     }
-    bool unlock_exclusive()
+
+    // to make copy fake
+    shared_critical_section& operator=(const shared_critical_section& section)
     {
-      ::ReleaseSRWLockExclusive(&m_srw_lock);
-      return true;
+      return *this;
     }
+
   private:
-    SRWLOCK m_srw_lock;
+    void release_exclusive()
+    {
+      if (--m_exclusive_depth == 0)
+      {
+        if (m_waiting_writers != 0)
+          m_writers_cond.notify_one();
+        else
+          m_readers_cond.notify_all();
+      }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_readers_cond;
+    std::condition_variable m_writers_cond;
+    std::map<std::thread::id, size_t> m_readers;
+    std::thread::id m_exclusive_owner;
+    size_t m_exclusive_depth;
+    size_t m_waiting_writers;
   };
 
 
@@ -185,6 +271,8 @@ namespace epee
     }
 
   private:
+    shared_guard(const shared_guard&);
+
     shared_critical_section& m_ref_sec;
   };
 
@@ -203,12 +291,15 @@ namespace epee
     }
 
   private:
+    exclusive_guard(const exclusive_guard&);
+
     shared_critical_section& m_ref_sec;
   };
-#endif
 
-#define  SHARED_CRITICAL_REGION_BEGIN(x) { shared_guard   critical_region_var(x)
-#define  EXCLUSIVE_CRITICAL_REGION_BEGIN(x) { exclusive_guard   critical_region_var(x)
+#define  SHARED_CRITICAL_REGION_LOCAL(x) epee::shared_guard   critical_region_var(x)
+#define  SHARED_CRITICAL_REGION_BEGIN(x) { epee::shared_guard   critical_region_var(x)
+#define  EXCLUSIVE_CRITICAL_REGION_LOCAL(x) epee::exclusive_guard   critical_region_var(x)
+#define  EXCLUSIVE_CRITICAL_REGION_BEGIN(x) { epee::exclusive_guard   critical_region_var(x)
 
 #define  CRITICAL_REGION_LOCAL(x) epee::critical_region_t<decltype(x)>   critical_region_var(x)
 #define  CRITICAL_REGION_BEGIN(x) { epee::critical_region_t<decltype(x)>   critical_region_var(x)
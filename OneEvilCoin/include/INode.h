@@ -76,6 +76,10 @@ public:
   virtual void getTransactionOutsGlobalIndices(const crypto::hash& transactionHash, std::vector<uint64_t>& outsGlobalIndices, const Callback& callback) = 0;
   virtual void queryBlocks(std::list<crypto::hash>&& knownBlockIds, uint64_t timestamp, std::list<BlockCompleteEntry>& newBlocks, uint64_t& startHeight, const Callback& callback) = 0;
   virtual void getPoolSymmetricDifference(std::vector<crypto::hash>&& known_pool_tx_ids, crypto::hash known_block_id, bool& is_bc_actual, std::vector<cryptonote::Transaction>& new_txs, std::vector<crypto::hash>& deleted_tx_ids, const Callback& callback) = 0;
+  // pool changes since the pool had knownPoolVersion, isPoolVersionActual is false if the node can't tell them
+  // and the caller should fall back to getPoolSymmetricDifference. poolVersion is the current pool version
+  virtual void getPoolChanges(crypto::hash knownBlockId, uint64_t knownPoolVersion, bool& isBcActual, bool& isPoolVersionActual, uint64_t& poolVersion,
+    std::vector<cryptonote::Transaction>& newTxs, std::vector<crypto::hash>& deletedTxIds, const Callback& callback) = 0;
 };
 
 }
@@ -139,6 +139,13 @@ bool print_COMMAND_REQUEST_STAT_INFO(const COMMAND_REQUEST_STAT_INFO::response&
   std::cout << "Tx pool size:        " << si.payload_info.tx_pool_size << ENDL;
   std::cout << "BC height:           " << si.payload_info.blockchain_height << ENDL;
   std::cout << "Mining speed:          " << si.payload_info.mining_speed << ENDL;
+  if (!si.payload_info.mining_thread_speeds.empty()) {
+    std::cout << "Mining thread speeds:  ";
+    for (uint64_t speed : si.payload_info.mining_thread_speeds) {
+      std::cout << speed << " ";
+    }
+    std::cout << ENDL;
+  }
   std::cout << "Alternative blocks:  " << si.payload_info.alternative_blocks << ENDL;
   std::cout << "Top block id:        " << si.payload_info.top_block_id_str << ENDL;
   return true;
@@ -194,6 +201,8 @@ bool handle_get_daemon_info(po::variables_map& vm)
   << "difficulty: " << res.difficulty << ENDL
   << "tx_count: " << res.tx_count << ENDL
   << "tx_pool_size: " << res.tx_pool_size << ENDL
+  << "tx_pool_bytes: " << res.tx_pool_bytes << ENDL
+  << "tx_pool_evicted: " << res.tx_pool_evicted << ENDL
   << "alt_blocks_count: " << res.alt_blocks_count << ENDL
   << "outgoing_connections_count: " << res.outgoing_connections_count << ENDL
   << "incoming_connections_count: " << res.incoming_connections_count << ENDL
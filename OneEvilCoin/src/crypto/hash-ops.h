@@ -64,12 +64,18 @@ void hash_process(union hash_state *state, const uint8_t *buf, size_t count);
 enum {
   HASH_SIZE = 32,
   HASH_DATA_AREA = 136,
-  SLOW_HASH_CONTEXT_SIZE = 2097552
+  SLOW_HASH_CONTEXT_SIZE = 2097552,
+  SLOW_HASH_MAX_WAYS = 4
 };
 
 void cn_fast_hash(const void *data, size_t length, char *hash);
 
 void cn_slow_hash_f(void *, const void *, size_t, void *);
+// context holds ways scratchpads of SLOW_HASH_CONTEXT_SIZE bytes each, hash receives ways consecutive hashes
+void cn_slow_hash_multi_f(void *context, size_t ways, const void *const *data, const size_t *length, void *hash);
+size_t cn_slow_hash_preferred_ways(void);
+// name of the slow hash implementation selected for this CPU
+const char *cn_slow_hash_variant(void);
 
 void hash_extra_blake(const void *data, size_t length, char *hash);
 void hash_extra_groestl(const void *data, size_t length, char *hash);
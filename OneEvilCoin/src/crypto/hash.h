@@ -50,6 +50,16 @@ namespace crypto {
     return h;
   }
 
+  // pages backing a scratchpad, the scratchpad is accessed at random so larger pages save TLB misses
+  enum class scratchpad_pages {
+    normal,
+    transparent_huge,
+    huge
+  };
+
+  // huge pages, transparent huge pages or 4 KB pages
+  const char *scratchpad_pages_name(scratchpad_pages pages);
+
   class cn_context {
   public:
 
@@ -60,9 +70,13 @@ namespace crypto {
     void operator=(const cn_context &) = delete;
 #endif
 
+    scratchpad_pages pages() const { return m_pages; }
+
   private:
 
     void *data;
+    std::size_t size;
+    scratchpad_pages m_pages;
     friend inline void cn_slow_hash(cn_context &, const void *, std::size_t, hash &);
   };
 
@@ -70,6 +84,34 @@ namespace crypto {
     (*cn_slow_hash_f)(context.data, data, length, reinterpret_cast<void *>(&hash));
   }
 
+  // Scratchpads for up to SLOW_HASH_MAX_WAYS slow hashes computed in lockstep
+  class cn_multi_context {
+  public:
+
+    explicit cn_multi_context(std::size_t ways = cn_slow_hash_preferred_ways());
+    ~cn_multi_context();
+#if !defined(_MSC_VER) || _MSC_VER >= 1800
+    cn_multi_context(const cn_multi_context &) = delete;
+    void operator=(const cn_multi_context &) = delete;
+#endif
+
+    std::size_t ways() const { return m_ways; }
+    scratchpad_pages pages() const { return m_pages; }
+
+  private:
+
+    void *data;
+    std::size_t size;
+    std::size_t m_ways;
+    scratchpad_pages m_pages;
+    friend inline void cn_slow_hash_multi(cn_multi_context &, const void *const *, const std::size_t *, hash *);
+  };
+
+  // hashes context.ways() blobs, every result is the same as cn_slow_hash() of the corresponding blob
+  inline void cn_slow_hash_multi(cn_multi_context &context, const void *const *data, const std::size_t *length, hash *hashes) {
+    (*cn_slow_hash_multi_f)(context.data, context.m_ways, data, length, reinterpret_cast<void *>(hashes));
+  }
+
   inline void tree_hash(const hash *hashes, std::size_t count, hash &root_hash) {
     tree_hash(reinterpret_cast<const char (*)[HASH_SIZE]>(hashes), count, reinterpret_cast<char *>(&root_hash));
   }
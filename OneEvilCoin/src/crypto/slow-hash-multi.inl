@@ -0,0 +1,234 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+// Computes several independent slow hashes in lockstep. Every lane has its own scratchpad, the lanes are laid out
+// one after another in the context with a stride of SLOW_HASH_CONTEXT_SIZE. Interleaving the main loops of the
+// lanes lets the memory accesses of one lane overlap with the AES and multiplication latency of the others.
+static FORCE_INLINE void
+#if defined(AESNI)
+cn_slow_hash_multi_aesni
+#else
+cn_slow_hash_multi_noaesni
+#endif
+(void *restrict context, const size_t ways, const void *const *data, const size_t *length, void *restrict hash)
+{
+  struct cn_ctx *lane[SLOW_HASH_MAX_WAYS];
+  ALIGNED_DECL(uint8_t ExpandedKey[SLOW_HASH_MAX_WAYS][256], 16);
+  ALIGNED_DECL(uint64_t a[SLOW_HASH_MAX_WAYS][2], 16);
+  __m128i b_x[SLOW_HASH_MAX_WAYS];
+  __m128i *longoutput[SLOW_HASH_MAX_WAYS], *expkey[SLOW_HASH_MAX_WAYS], *xmminput[SLOW_HASH_MAX_WAYS];
+  size_t i, j, k;
+
+  for (k = 0; k < ways; k++)
+  {
+    lane[k] = (struct cn_ctx *) ((uint8_t *) context + k * SLOW_HASH_CONTEXT_SIZE);
+    hash_process(&lane[k]->state.hs, (const uint8_t*) data[k], length[k]);
+
+    memcpy(lane[k]->text, lane[k]->state.init, INIT_SIZE_BYTE);
+#if defined(AESNI)
+    memcpy(ExpandedKey[k], lane[k]->state.hs.b, AES_KEY_SIZE);
+    ExpandAESKey256(ExpandedKey[k]);
+#else
+    lane[k]->aes_ctx = oaes_alloc();
+    oaes_key_import_data(lane[k]->aes_ctx, lane[k]->state.hs.b, AES_KEY_SIZE);
+    memcpy(ExpandedKey[k], lane[k]->aes_ctx->key->exp_data, lane[k]->aes_ctx->key->exp_data_len);
+#endif
+
+    longoutput[k] = (__m128i *) lane[k]->long_state;
+    expkey[k] = (__m128i *) ExpandedKey[k];
+    xmminput[k] = (__m128i *) lane[k]->text;
+  }
+
+  for (i = 0; likely(i < MEMORY); i += INIT_SIZE_BYTE)
+  {
+    for (k = 0; k < ways; k++)
+    {
+#if defined(AESNI)
+      for(j = 0; j < 10; j++)
+      {
+        xmminput[k][0] = _mm_aesenc_si128(xmminput[k][0], expkey[k][j]);
+        xmminput[k][1] = _mm_aesenc_si128(xmminput[k][1], expkey[k][j]);
+        xmminput[k][2] = _mm_aesenc_si128(xmminput[k][2], expkey[k][j]);
+        xmminput[k][3] = _mm_aesenc_si128(xmminput[k][3], expkey[k][j]);
+        xmminput[k][4] = _mm_aesenc_si128(xmminput[k][4], expkey[k][j]);
+        xmminput[k][5] = _mm_aesenc_si128(xmminput[k][5], expkey[k][j]);
+        xmminput[k][6] = _mm_aesenc_si128(xmminput[k][6], expkey[k][j]);
+        xmminput[k][7] = _mm_aesenc_si128(xmminput[k][7], expkey[k][j]);
+      }
+#else
+      for(j = 0; j < 8; j++)
+      {
+        aesb_pseudo_round((uint8_t *) &xmminput[k][j], (uint8_t *) &xmminput[k][j], (uint8_t *) expkey[k]);
+      }
+#endif
+      for(j = 0; j < 8; j++)
+      {
+        _mm_store_si128(&(longoutput[k][(i >> 4) + j]), xmminput[k][j]);
+      }
+    }
+  }
+
+  for (k = 0; k < ways; k++)
+  {
+    for (i = 0; i < 2; i++)
+    {
+      lane[k]->a[i] = ((uint64_t *)lane[k]->state.k)[i] ^  ((uint64_t *)lane[k]->state.k)[i+4];
+      lane[k]->b[i] = ((uint64_t *)lane[k]->state.k)[i+2] ^  ((uint64_t *)lane[k]->state.k)[i+6];
+    }
+
+    b_x[k] = _mm_load_si128((__m128i *)lane[k]->b);
+    a[k][0] = lane[k]->a[0];
+    a[k][1] = lane[k]->a[1];
+  }
+
+  for(i = 0; likely(i < 0x80000); i++)
+  {
+    for (k = 0; k < ways; k++)
+    {
+      uint8_t *long_state = lane[k]->long_state;
+      __m128i c_x = _mm_load_si128((__m128i *)&long_state[a[k][0] & 0x1FFFF0]);
+      __m128i a_x = _mm_load_si128((__m128i *)a[k]);
+      ALIGNED_DECL(uint64_t c[2], 16);
+      ALIGNED_DECL(uint64_t b[2], 16);
+      uint64_t *nextblock, *dst;
+
+#if defined(AESNI)
+      c_x = _mm_aesenc_si128(c_x, a_x);
+#else
+      aesb_single_round((uint8_t *) &c_x, (uint8_t *) &c_x, (uint8_t *) &a_x);
+#endif
+
+      _mm_store_si128((__m128i *)c, c_x);
+
+      b_x[k] = _mm_xor_si128(b_x[k], c_x);
+      _mm_store_si128((__m128i *)&long_state[a[k][0] & 0x1FFFF0], b_x[k]);
+
+      nextblock = (uint64_t *)&long_state[c[0] & 0x1FFFF0];
+      b[0] = nextblock[0];
+      b[1] = nextblock[1];
+
+      {
+        uint64_t hi, lo;
+        // hi,lo = 64bit x 64bit multiply of c[0] and b[0]
+
+#if defined(__GNUC__) && defined(__x86_64__)
+        __asm__("mulq %3\n\t"
+          : "=d" (hi),
+          "=a" (lo)
+          : "%a" (c[0]),
+          "rm" (b[0])
+          : "cc" );
+#else
+        lo = mul128(c[0], b[0], &hi);
+#endif
+
+        a[k][0] += hi;
+        a[k][1] += lo;
+      }
+      dst = (uint64_t *) &long_state[c[0] & 0x1FFFF0];
+      dst[0] = a[k][0];
+      dst[1] = a[k][1];
+
+      a[k][0] ^= b[0];
+      a[k][1] ^= b[1];
+      b_x[k] = c_x;
+    }
+  }
+
+  for (k = 0; k < ways; k++)
+  {
+    memcpy(lane[k]->text, lane[k]->state.init, INIT_SIZE_BYTE);
+#if defined(AESNI)
+    memcpy(ExpandedKey[k], &lane[k]->state.hs.b[32], AES_KEY_SIZE);
+    ExpandAESKey256(ExpandedKey[k]);
+#else
+    oaes_key_import_data(lane[k]->aes_ctx, &lane[k]->state.hs.b[32], AES_KEY_SIZE);
+    memcpy(ExpandedKey[k], lane[k]->aes_ctx->key->exp_data, lane[k]->aes_ctx->key->exp_data_len);
+#endif
+  }
+
+  for (i = 0; likely(i < MEMORY); i += INIT_SIZE_BYTE)
+  {
+    for (k = 0; k < ways; k++)
+    {
+      for(j = 0; j < 8; j++)
+      {
+        xmminput[k][j] = _mm_xor_si128(longoutput[k][(i >> 4) + j], xmminput[k][j]);
+      }
+
+#if defined(AESNI)
+      for(j = 0; j < 10; j++)
+      {
+        xmminput[k][0] = _mm_aesenc_si128(xmminput[k][0], expkey[k][j]);
+        xmminput[k][1] = _mm_aesenc_si128(xmminput[k][1], expkey[k][j]);
+        xmminput[k][2] = _mm_aesenc_si128(xmminput[k][2], expkey[k][j]);
+        xmminput[k][3] = _mm_aesenc_si128(xmminput[k][3], expkey[k][j]);
+        xmminput[k][4] = _mm_aesenc_si128(xmminput[k][4], expkey[k][j]);
+        xmminput[k][5] = _mm_aesenc_si128(xmminput[k][5], expkey[k][j]);
+        xmminput[k][6] = _mm_aesenc_si128(xmminput[k][6], expkey[k][j]);
+        xmminput[k][7] = _mm_aesenc_si128(xmminput[k][7], expkey[k][j]);
+      }
+#else
+      for(j = 0; j < 8; j++)
+      {
+        aesb_pseudo_round((uint8_t *) &xmminput[k][j], (uint8_t *) &xmminput[k][j], (uint8_t *) expkey[k]);
+      }
+#endif
+    }
+  }
+
+  for (k = 0; k < ways; k++)
+  {
+#if !defined(AESNI)
+    oaes_free((OAES_CTX **) &lane[k]->aes_ctx);
+#endif
+
+    memcpy(lane[k]->state.init, lane[k]->text, INIT_SIZE_BYTE);
+    hash_permutation(&lane[k]->state.hs);
+    extra_hashes[lane[k]->state.hs.b[0] & 3](&lane[k]->state, 200, (char *) hash + k * HASH_SIZE);
+  }
+}
+
+static void
+#if defined(AESNI)
+cn_slow_hash_2way_aesni
+#else
+cn_slow_hash_2way_noaesni
+#endif
+(void *restrict context, const void *const *data, const size_t *length, void *restrict hash)
+{
+#if defined(AESNI)
+  cn_slow_hash_multi_aesni(context, 2, data, length, hash);
+#else
+  cn_slow_hash_multi_noaesni(context, 2, data, length, hash);
+#endif
+}
+
+static void
+#if defined(AESNI)
+cn_slow_hash_4way_aesni
+#else
+cn_slow_hash_4way_noaesni
+#endif
+(void *restrict context, const void *const *data, const size_t *length, void *restrict hash)
+{
+#if defined(AESNI)
+  cn_slow_hash_multi_aesni(context, 4, data, length, hash);
+#else
+  cn_slow_hash_multi_noaesni(context, 4, data, length, hash);
+#endif
+}
@@ -36,10 +36,41 @@
 
 void (*cn_slow_hash_fp)(void *, const void *, size_t, void *);
 
+void (*cn_slow_hash_2way_fp)(void *, const void *const *, const size_t *, void *);
+void (*cn_slow_hash_4way_fp)(void *, const void *const *, const size_t *, void *);
+static size_t cn_slow_hash_preferred_ways_value = 1;
+static const char *cn_slow_hash_variant_name = "sse2";
+
 void cn_slow_hash_f(void * a, const void * b, size_t c, void * d){
 (*cn_slow_hash_fp)(a, b, c, d);
 }
 
+void cn_slow_hash_multi_f(void *context, size_t ways, const void *const *data, const size_t *length, void *hash) {
+  size_t done = 0;
+  while (done < ways) {
+    void *lane_context = (uint8_t *) context + done * SLOW_HASH_CONTEXT_SIZE;
+    void *lane_hash = (uint8_t *) hash + done * HASH_SIZE;
+    if (ways - done >= 4) {
+      (*cn_slow_hash_4way_fp)(lane_context, data + done, length + done, lane_hash);
+      done += 4;
+    } else if (ways - done >= 2) {
+      (*cn_slow_hash_2way_fp)(lane_context, data + done, length + done, lane_hash);
+      done += 2;
+    } else {
+      (*cn_slow_hash_fp)(lane_context, data[done], length[done], lane_hash);
+      done += 1;
+    }
+  }
+}
+
+size_t cn_slow_hash_preferred_ways(void) {
+  return cn_slow_hash_preferred_ways_value;
+}
+
+const char *cn_slow_hash_variant(void) {
+  return cn_slow_hash_variant_name;
+}
+
 #if defined(__GNUC__)
 #define likely(x) (__builtin_expect(!!(x), 1))
 #define unlikely(x) (__builtin_expect(!!(x), 0))
@@ -51,6 +82,9 @@ void cn_slow_hash_f(void * a, const void * b, size_t c, void * d){
 
 #if defined(_MSC_VER)
 #define restrict
+#define FORCE_INLINE __forceinline
+#else
+#define FORCE_INLINE inline __attribute__((always_inline))
 #endif
 
 #define MEMORY         (1 << 21) /* 2 MiB */
@@ -176,8 +210,10 @@ static void (*const extra_hashes[4])(const void *, size_t, char *) =
 };
 
 #include "slow-hash.inl"
+#include "slow-hash-multi.inl"
 #define AESNI
 #include "slow-hash.inl"
+#include "slow-hash-multi.inl"
 
 INITIALIZER(detect_aes) {
   int ecx;
@@ -189,5 +225,18 @@ INITIALIZER(detect_aes) {
   int a, b, d;
   __cpuid(1, a, b, ecx, d);
 #endif
-  cn_slow_hash_fp = (ecx & (1 << 25)) ? &cn_slow_hash_aesni : &cn_slow_hash_noaesni;
+  if (ecx & (1 << 25)) {
+    cn_slow_hash_fp = &cn_slow_hash_aesni;
+    cn_slow_hash_2way_fp = &cn_slow_hash_2way_aesni;
+    cn_slow_hash_4way_fp = &cn_slow_hash_4way_aesni;
+    // the software AES rounds keep the core busy, interleaving only pays off with hardware AES
+    cn_slow_hash_preferred_ways_value = 2;
+    cn_slow_hash_variant_name = "aes-ni";
+  } else {
+    cn_slow_hash_fp = &cn_slow_hash_noaesni;
+    cn_slow_hash_2way_fp = &cn_slow_hash_2way_noaesni;
+    cn_slow_hash_4way_fp = &cn_slow_hash_4way_noaesni;
+    cn_slow_hash_preferred_ways_value = 1;
+    cn_slow_hash_variant_name = "sse2";
+  }
 }
@@ -15,7 +15,9 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <cstdint>
 #include <new>
+#include <stdexcept>
 
 #include "hash.h"
 
@@ -26,48 +28,151 @@
 #endif
 
 using std::bad_alloc;
+using std::invalid_argument;
 
 namespace crypto {
 
-  enum {
-    MAP_SIZE = SLOW_HASH_CONTEXT_SIZE + ((-SLOW_HASH_CONTEXT_SIZE) & 0xfff)
-  };
+  namespace {
+
+    std::size_t round_up(std::size_t size, std::size_t page_size) {
+      return size + ((-size) & (page_size - 1));
+    }
 
 #if defined(WIN32)
 
-  cn_context::cn_context() {
-    data = VirtualAlloc(nullptr, MAP_SIZE, MEM_COMMIT, PAGE_READWRITE);
-    if (data == nullptr) {
-      throw bad_alloc();
+    void *allocate_scratchpad(std::size_t size, std::size_t &mapped_size, scratchpad_pages &pages) {
+      std::size_t large_page_size = GetLargePageMinimum();
+      if (large_page_size != 0) {
+        mapped_size = round_up(size, large_page_size);
+        void *data = VirtualAlloc(nullptr, mapped_size, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (data != nullptr) {
+          pages = scratchpad_pages::huge;
+          return data;
+        }
+      }
+
+      mapped_size = round_up(size, 0x1000);
+      void *data = VirtualAlloc(nullptr, mapped_size, MEM_COMMIT, PAGE_READWRITE);
+      if (data == nullptr) {
+        throw bad_alloc();
+      }
+
+      pages = scratchpad_pages::normal;
+      return data;
     }
-  }
 
-  cn_context::~cn_context() {
-    if (!VirtualFree(data, 0, MEM_RELEASE)) {
-      throw bad_alloc();
+    void free_scratchpad(void *data, std::size_t) {
+      if (!VirtualFree(data, 0, MEM_RELEASE)) {
+        throw bad_alloc();
+      }
     }
-  }
 
 #else
 
-  cn_context::cn_context() {
+    const std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+#if defined(MADV_HUGEPAGE)
+    // transparent huge pages are only used for 2 MB aligned ranges, mmap only guarantees 4 KB alignment
+    void *map_huge_page_aligned(std::size_t size) {
+      void *raw = mmap(nullptr, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (raw == MAP_FAILED) {
+        return MAP_FAILED;
+      }
+
+      uintptr_t begin = reinterpret_cast<uintptr_t>(raw);
+      uintptr_t aligned = round_up(begin, HUGE_PAGE_SIZE);
+      if (aligned != begin) {
+        munmap(raw, aligned - begin);
+      }
+
+      if (begin + HUGE_PAGE_SIZE != aligned) {
+        munmap(reinterpret_cast<void *>(aligned + size), begin + HUGE_PAGE_SIZE - aligned);
+      }
+
+      return reinterpret_cast<void *>(aligned);
+    }
+#endif
+
+    void *allocate_scratchpad(std::size_t size, std::size_t &mapped_size, scratchpad_pages &pages) {
+      void *data;
+#if defined(MAP_HUGETLB)
+      mapped_size = round_up(size, HUGE_PAGE_SIZE);
+      data = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+      if (data != MAP_FAILED) {
+        mlock(data, mapped_size);
+        pages = scratchpad_pages::huge;
+        return data;
+      }
+#endif
+
+#if defined(MADV_HUGEPAGE)
+      mapped_size = round_up(size, HUGE_PAGE_SIZE);
+      data = map_huge_page_aligned(mapped_size);
+      if (data != MAP_FAILED) {
+        if (madvise(data, mapped_size, MADV_HUGEPAGE) == 0) {
+          // mlock faults the pages in, the kernel backs them with huge pages where it can
+          mlock(data, mapped_size);
+          pages = scratchpad_pages::transparent_huge;
+          return data;
+        }
+
+        munmap(data, mapped_size);
+      }
+#endif
+
+      mapped_size = round_up(size, 0x1000);
 #if !defined(__APPLE__)
-    data = mmap(nullptr, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+      data = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
 #else
-    data = mmap(nullptr, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+      data = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
 #endif
-    if (data == MAP_FAILED) {
-      throw bad_alloc();
+      if (data == MAP_FAILED) {
+        throw bad_alloc();
+      }
+      mlock(data, mapped_size);
+      pages = scratchpad_pages::normal;
+      return data;
     }
-    mlock(data, MAP_SIZE);
+
+    void free_scratchpad(void *data, std::size_t mapped_size) {
+      if (munmap(data, mapped_size) != 0) {
+        throw bad_alloc();
+      }
+    }
+
+#endif
+
+  }
+
+  cn_context::cn_context() {
+    data = allocate_scratchpad(SLOW_HASH_CONTEXT_SIZE, size, m_pages);
   }
 
   cn_context::~cn_context() {
-    if (munmap(data, MAP_SIZE) != 0) {
-      throw bad_alloc();
+    free_scratchpad(data, size);
+  }
+
+  cn_multi_context::cn_multi_context(std::size_t ways) : m_ways(ways) {
+    if (ways == 0 || ways > SLOW_HASH_MAX_WAYS) {
+      throw invalid_argument("Invalid number of slow hash ways");
     }
+
+    data = allocate_scratchpad(ways * SLOW_HASH_CONTEXT_SIZE, size, m_pages);
   }
 
-#endif
+  cn_multi_context::~cn_multi_context() {
+    free_scratchpad(data, size);
+  }
+
+  const char *scratchpad_pages_name(scratchpad_pages pages) {
+    switch (pages) {
+    case scratchpad_pages::huge:
+      return "huge pages";
+    case scratchpad_pages::transparent_huge:
+      return "transparent huge pages";
+    default:
+      return "4 KB pages";
+    }
+  }
 
 }
@@ -62,6 +62,9 @@ const uint64_t CRYPTONOTE_LOCKED_TX_ALLOWED_DELTA_SECONDS    = DIFFICULTY_TARGET
 
 const uint64_t CRYPTONOTE_MEMPOOL_TX_LIVETIME                = 60 * 60 * 24;     //seconds, one day
 const uint64_t CRYPTONOTE_MEMPOOL_TX_FROM_ALT_BLOCK_LIVETIME = 60 * 60 * 24 * 7; //seconds, one week
+const uint64_t CRYPTONOTE_MEMPOOL_DEFAULT_MAX_SIZE           = 256 * 1024 * 1024; //bytes of memory used by pool transactions
+const size_t   CRYPTONOTE_MEMPOOL_CHANGE_LOG_SIZE            = 10000;             //added and removed transactions a client can ask about by pool version
+const uint64_t CRYPTONOTE_MEMPOOL_READINESS_TIME_STEP        = DIFFICULTY_TARGET / 4; //seconds, transactions found not ready are checked again after it
 
 const uint64_t UPGRADE_HEIGHT                                = 745900;
 const unsigned UPGRADE_VOTING_THRESHOLD                      = 90;               // percent
@@ -74,6 +77,7 @@ const char     CRYPTONOTE_BLOCKCHAINDATA_FILENAME[]          = "blockchain.bin";
 const char     CRYPTONOTE_BLOCKS_FILENAME[]                  = "blocks.dat";
 const char     CRYPTONOTE_BLOCKINDEXES_FILENAME[]            = "blockindexes.dat";
 const char     CRYPTONOTE_BLOCKSCACHE_FILENAME[]             = "blockscache.dat";
+const char     CRYPTONOTE_BLOCKSCACHE_JOURNAL_FILENAME[]     = "blockscachejournal.dat";
 const char     CRYPTONOTE_POOLDATA_FILENAME[]                = "poolstate.bin";
 const char     P2P_NET_DATA_FILENAME[]                       = "p2pstate.bin";
 const char     MINER_CONFIG_FILE_NAME[]                      = "miner_conf.json";
@@ -89,6 +93,17 @@ const uint8_t  BLOCK_MINOR_VERSION_1                         =  1;
 
 const size_t   BLOCKS_IDS_SYNCHRONIZING_DEFAULT_COUNT        =  10000;  //by default, blocks ids count in synchronizing
 const size_t   BLOCKS_SYNCHRONIZING_DEFAULT_COUNT            =  200;    //by default, blocks count in blocks downloading
+const size_t   BLOCKS_SYNCHRONIZING_WINDOW                   =  8;      //spans of blocks downloaded from different peers at once
+const uint32_t BLOCKS_SYNCHRONIZING_SPAN_TIMEOUT             =  60;     //seconds before a span requested from a peer is requested from another one
+const size_t   BLOCK_HEADERS_SYNCHRONIZING_DEFAULT_COUNT     =  1000;   //block headers count in headers downloading
+const size_t   BLOCK_HEADERS_SYNCHRONIZING_AHEAD_COUNT       =  4000;   //checked block headers ahead of the blockchain in a shared download, more than its window of blocks
+const size_t   TX_ADMISSION_MAX_PENDING_BATCHES              =  64;     //transaction relay batches waiting for verification, further ones are dropped
+const size_t   TX_ADMISSION_MAX_PEER_PENDING_BATCHES         =  4;      //transaction relay batches of one peer waiting for or under verification
+const size_t   TX_INVENTORY_MAX_COUNT                        =  1000;   //transaction hashes in one inventory or request
+const size_t   TX_INVENTORY_KNOWN_LIMIT                      =  10000;  //transaction hashes remembered as known by each peer
+const size_t   TX_INVENTORY_QUEUE_LIMIT                      =  10000;  //transaction hashes queued for announcing to each peer
+const uint32_t TX_INVENTORY_REQUEST_TIMEOUT                  =  10;     //seconds before an announced transaction is requested from another peer
+const size_t   TX_INVENTORY_SERVED_PER_SECOND                =  1000;   //transactions sent to each peer on its requests, on average
 const size_t   COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT         =  1000;
 
 const int      P2P_DEFAULT_PORT                              = 7620;
@@ -97,6 +112,11 @@ const int      RPC_DEFAULT_PORT                              = 8666;
 const size_t   P2P_LOCAL_WHITE_PEERLIST_LIMIT                =  1000;
 const size_t   P2P_LOCAL_GRAY_PEERLIST_LIMIT                 =  5000;
 
+const uint8_t  P2P_PROTOCOL_VERSION_1                        = 1;             // compact block relay
+const uint8_t  P2P_PROTOCOL_VERSION_2                        = 2;             // transaction inventories
+const uint8_t  P2P_PROTOCOL_VERSION_3                        = 3;             // headers-first synchronization
+const uint8_t  P2P_CURRENT_PROTOCOL_VERSION                  = P2P_PROTOCOL_VERSION_3;
+
 const uint32_t P2P_DEFAULT_CONNECTIONS_COUNT                 = 8;
 const uint32_t P2P_DEFAULT_HANDSHAKE_INTERVAL                = 60;            // seconds
 const uint32_t P2P_DEFAULT_PACKET_MAX_SIZE                   = 50000000;      // 50000000 bytes maximum packet size
@@ -0,0 +1,43 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BlockBlobIndex.h"
+
+namespace CryptoNote
+{
+  void BlockBlobIndex::push(uint32_t blockBlobSize, const std::vector<uint32_t>& transactionOffsets, const std::vector<uint32_t>& transactionSizes) {
+    m_blockBlobSizes.push_back(blockBlobSize);
+    m_firstTransactions.push_back(m_transactionOffsets.size());
+    m_transactionOffsets.insert(m_transactionOffsets.end(), transactionOffsets.begin(), transactionOffsets.end());
+    m_transactionSizes.insert(m_transactionSizes.end(), transactionSizes.begin(), transactionSizes.end());
+  }
+
+  void BlockBlobIndex::pop() {
+    size_t firstTransaction = static_cast<size_t>(m_firstTransactions.back());
+    m_transactionOffsets.resize(firstTransaction);
+    m_transactionSizes.resize(firstTransaction);
+    m_firstTransactions.pop_back();
+    m_blockBlobSizes.pop_back();
+  }
+
+  void BlockBlobIndex::clear() {
+    m_blockBlobSizes.clear();
+    m_firstTransactions.clear();
+    m_transactionOffsets.clear();
+    m_transactionSizes.clear();
+  }
+}
@@ -0,0 +1,75 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace CryptoNote
+{
+  // Per-height location of the block and transaction blobs inside the serialized block entries, so that raw blobs
+  // can be copied out of the swapped block storage without deserializing the entries.
+  class BlockBlobIndex {
+
+  public:
+
+    // transactionOffsets and transactionSizes start with the miner transaction, which lies inside the block blob
+    void push(uint32_t blockBlobSize, const std::vector<uint32_t>& transactionOffsets, const std::vector<uint32_t>& transactionSizes);
+    void pop();
+    void clear();
+
+    uint64_t size() const {
+      return m_blockBlobSizes.size();
+    }
+
+    uint32_t blockBlobSize(uint64_t height) const {
+      return m_blockBlobSizes[static_cast<size_t>(height)];
+    }
+
+    size_t transactionCount(uint64_t height) const {
+      return static_cast<size_t>(transactionsEnd(height) - m_firstTransactions[static_cast<size_t>(height)]);
+    }
+
+    uint32_t transactionBlobOffset(uint64_t height, size_t transaction) const {
+      return m_transactionOffsets[static_cast<size_t>(m_firstTransactions[static_cast<size_t>(height)]) + transaction];
+    }
+
+    uint32_t transactionBlobSize(uint64_t height, size_t transaction) const {
+      return m_transactionSizes[static_cast<size_t>(m_firstTransactions[static_cast<size_t>(height)]) + transaction];
+    }
+
+    template <class Archive> void serialize(Archive& ar, const unsigned int version) {
+      ar & m_blockBlobSizes;
+      ar & m_firstTransactions;
+      ar & m_transactionOffsets;
+      ar & m_transactionSizes;
+    }
+
+  private:
+
+    uint64_t transactionsEnd(uint64_t height) const {
+      return height + 1 < m_firstTransactions.size() ? m_firstTransactions[static_cast<size_t>(height) + 1] : m_transactionOffsets.size();
+    }
+
+    std::vector<uint32_t> m_blockBlobSizes;
+    std::vector<uint64_t> m_firstTransactions; // position of the first transaction of each block in the columns below
+    std::vector<uint32_t> m_transactionOffsets;
+    std::vector<uint32_t> m_transactionSizes;
+
+  };
+}
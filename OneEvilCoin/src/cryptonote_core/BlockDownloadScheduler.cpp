@@ -0,0 +1,280 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BlockDownloadScheduler.h"
+
+#include <algorithm>
+
+namespace CryptoNote
+{
+  BlockDownloadScheduler::BlockDownloadScheduler(size_t spanSize, size_t windowSpans, std::chrono::seconds spanTimeout) :
+    m_spanSize(spanSize), m_windowSpans(windowSpans), m_spanTimeout(spanTimeout), m_feeding(false) {
+  }
+
+  bool BlockDownloadScheduler::addChain(const PeerId& peer, uint64_t startHeight, const std::vector<crypto::hash>& ids) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t offset = 0;
+
+    if (!m_spans.empty()) {
+      uint64_t frontHeight = m_spans.front().startHeight;
+      uint64_t endHeight = m_spans.back().startHeight + m_spans.back().ids.size();
+      if (startHeight > endHeight) {
+        return false;
+      }
+
+      // blocks below the first span are already handed out
+      if (startHeight < frontHeight) {
+        if (startHeight + ids.size() <= frontHeight) {
+          return true;
+        }
+
+        offset = frontHeight - startHeight;
+      }
+
+      if (offset < ids.size() && startHeight + offset < endHeight) {
+        auto span = findSpan(startHeight + offset);
+        for (; offset < ids.size() && startHeight + offset < endHeight; ++offset) {
+          uint64_t height = startHeight + offset;
+          if (height >= span->startHeight + span->ids.size()) {
+            ++span;
+          }
+
+          if (span->ids[height - span->startHeight] != ids[offset]) {
+            return false;
+          }
+        }
+      }
+    }
+
+    for (; offset < ids.size(); ++offset) {
+      if (m_spans.empty() || m_spans.back().ids.size() >= m_spanSize || m_spans.back().state != SpanState::pending) {
+        Span span;
+        span.startHeight = startHeight + offset;
+        span.state = SpanState::pending;
+        m_spans.push_back(std::move(span));
+      }
+
+      m_spans.back().ids.push_back(ids[offset]);
+    }
+
+    if (!ids.empty()) {
+      uint64_t& maxHeight = m_peerHeights[peer];
+      maxHeight = std::max(maxHeight, startHeight + ids.size() - 1);
+    }
+
+    return true;
+  }
+
+  BlockDownloadScheduler::Reservation BlockDownloadScheduler::reserveSpan(const PeerId& peer, uint64_t maxHeight, std::vector<crypto::hash>& ids) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto now = std::chrono::steady_clock::now();
+    if (m_failedPeers.count(peer) != 0) {
+      m_waitingPeers.erase(peer);
+      return Reservation::unreachable;
+    }
+
+    m_peerHeights[peer] = maxHeight;
+    size_t window = std::min(m_windowSpans, m_spans.size());
+    for (size_t i = 0; i < window; ++i) {
+      Span& span = m_spans[i];
+      if (span.startHeight + span.ids.size() - 1 > maxHeight) {
+        break;
+      }
+
+      if (isReservable(span, now)) {
+        span.state = SpanState::requested;
+        span.peer = peer;
+        span.requestTime = now;
+        m_assignments[peer] = span.startHeight;
+        m_waitingPeers.erase(peer);
+        ids = span.ids;
+        return Reservation::reserved;
+      }
+    }
+
+    if (!isReachable(maxHeight)) {
+      m_waitingPeers.erase(peer);
+      return Reservation::unreachable;
+    }
+
+    m_waitingPeers[peer] = maxHeight;
+    return Reservation::waiting;
+  }
+
+  bool BlockDownloadScheduler::hasSpan(const PeerId& peer) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_assignments.count(peer) != 0;
+  }
+
+  BlockDownloadScheduler::Delivery BlockDownloadScheduler::deliverSpan(const PeerId& peer, std::list<cryptonote::block_complete_entry>&& blocks) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto assignment = m_assignments.find(peer);
+    if (assignment == m_assignments.end()) {
+      return Delivery::notScheduled;
+    }
+
+    uint64_t height = assignment->second;
+    m_assignments.erase(assignment);
+    if (m_spans.empty() || height < m_spans.front().startHeight) {
+      return Delivery::late;
+    }
+
+    auto span = findSpan(height);
+    if (span->startHeight != height || span->state != SpanState::requested || span->peer != peer) {
+      return Delivery::late;
+    }
+
+    span->state = SpanState::delivered;
+    span->blocks = std::move(blocks);
+    return Delivery::accepted;
+  }
+
+  bool BlockDownloadScheduler::takeReady(bool& feeding, std::list<cryptonote::block_complete_entry>& blocks, PeerId& deliverer) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_feeding && !feeding) {
+      return false;
+    }
+
+    if (m_spans.empty() || m_spans.front().state != SpanState::delivered) {
+      m_feeding = false;
+      feeding = false;
+      return false;
+    }
+
+    m_feeding = true;
+    feeding = true;
+    blocks = std::move(m_spans.front().blocks);
+    deliverer = m_spans.front().peer;
+    m_taken = std::move(m_spans.front());
+    m_spans.pop_front();
+    return true;
+  }
+
+  void BlockDownloadScheduler::retryTaken() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_feeding = false;
+    if (m_taken.ids.empty()) {
+      return;
+    }
+
+    m_failedPeers.insert(m_taken.peer);
+    // the spans after it are kept, unless the download was reset meanwhile
+    if (m_spans.empty() || m_spans.front().startHeight == m_taken.startHeight + m_taken.ids.size()) {
+      m_taken.state = SpanState::pending;
+      m_spans.push_front(std::move(m_taken));
+    }
+
+    m_taken.ids.clear();
+  }
+
+  std::vector<BlockDownloadScheduler::PeerId> BlockDownloadScheduler::takeWaitingPeers() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<PeerId> peers;
+    if (m_waitingPeers.empty()) {
+      return peers;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (!m_spans.empty()) {
+      // a span left to download that no peer reaches is never downloaded
+      size_t window = std::min(m_windowSpans, m_spans.size());
+      for (size_t i = 0; i < window; ++i) {
+        const Span& span = m_spans[i];
+        uint64_t lastHeight = span.startHeight + span.ids.size() - 1;
+        if (span.state != SpanState::delivered && std::none_of(m_peerHeights.begin(), m_peerHeights.end(),
+          [&](const std::pair<const PeerId, uint64_t>& peer) { return peer.second >= lastHeight && m_failedPeers.count(peer.first) == 0; })) {
+          endDownload();
+          break;
+        }
+      }
+    }
+
+    bool active = !m_spans.empty() || m_feeding;
+    for (auto it = m_waitingPeers.begin(); it != m_waitingPeers.end();) {
+      if (!active || hasReservableSpan(it->second, now)) {
+        peers.push_back(it->first);
+        it = m_waitingPeers.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    return peers;
+  }
+
+  void BlockDownloadScheduler::releasePeer(const PeerId& peer) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_assignments.erase(peer);
+    m_waitingPeers.erase(peer);
+    m_peerHeights.erase(peer);
+    m_failedPeers.erase(peer);
+    for (Span& span : m_spans) {
+      if (span.state == SpanState::requested && span.peer == peer) {
+        span.state = SpanState::pending;
+      }
+    }
+  }
+
+  // Waiting peers and assignments survive a reset, so waiting peers are still woken up
+  // and spans requested before it are recognized as late when they arrive
+  void BlockDownloadScheduler::reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    endDownload();
+  }
+
+  bool BlockDownloadScheduler::isActive() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return !m_spans.empty() || m_feeding;
+  }
+
+  std::deque<BlockDownloadScheduler::Span>::iterator BlockDownloadScheduler::findSpan(uint64_t height) {
+    auto span = std::upper_bound(m_spans.begin(), m_spans.end(), height,
+      [](uint64_t h, const Span& s) { return h < s.startHeight; });
+    return --span;
+  }
+
+  bool BlockDownloadScheduler::isReservable(const Span& span, std::chrono::steady_clock::time_point now) const {
+    return span.state == SpanState::pending || (span.state == SpanState::requested && now - span.requestTime >= m_spanTimeout);
+  }
+
+  bool BlockDownloadScheduler::hasReservableSpan(uint64_t maxHeight, std::chrono::steady_clock::time_point now) const {
+    size_t window = std::min(m_windowSpans, m_spans.size());
+    for (size_t i = 0; i < window && m_spans[i].startHeight + m_spans[i].ids.size() - 1 <= maxHeight; ++i) {
+      if (isReservable(m_spans[i], now)) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  bool BlockDownloadScheduler::isReachable(uint64_t maxHeight) const {
+    for (const Span& span : m_spans) {
+      if (span.state != SpanState::delivered) {
+        return span.startHeight + span.ids.size() - 1 <= maxHeight;
+      }
+    }
+
+    return false;
+  }
+
+  void BlockDownloadScheduler::endDownload() {
+    m_spans.clear();
+    m_taken.ids.clear();
+    m_feeding = false;
+  }
+}
@@ -0,0 +1,127 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include <boost/uuid/uuid.hpp>
+
+#include "crypto/hash.h"
+#include "cryptonote_protocol/cryptonote_protocol_defs.h"
+
+namespace CryptoNote
+{
+  // Downloads the blocks of one chain from many peers at once. The chain is split into spans of spanSize blocks, peers
+  // get spans from a window of windowSpans spans ahead of the first block not yet added, and delivered spans are
+  // buffered until every span before them is delivered, so blocks are handed out in height order. A span that isn't
+  // delivered within spanTimeout is given to the next peer asking for work whose chain reaches it, and the download ends
+  // once no peer taking part in it reaches a span left to download.
+  class BlockDownloadScheduler {
+
+  public:
+
+    typedef boost::uuids::uuid PeerId;
+
+    enum class Delivery {
+      accepted,
+      // the span was given to another peer or was already delivered
+      late,
+      // the peer has no span, its request wasn't scheduled
+      notScheduled
+    };
+
+    enum class Reservation {
+      reserved,
+      // the peer is remembered as waiting and woken up once there is a span for it
+      waiting,
+      // the peer's chain doesn't reach the spans left to download, or the peer delivered blocks that failed
+      unreachable
+    };
+
+    BlockDownloadScheduler(size_t spanSize, size_t windowSpans, std::chrono::seconds spanTimeout);
+
+    // schedules the blocks of the peer's chain starting at startHeight, returns false if they disagree with the chain
+    // already scheduled or don't continue it
+    bool addChain(const PeerId& peer, uint64_t startHeight, const std::vector<crypto::hash>& ids);
+    // gives the peer the next span not above maxHeight
+    Reservation reserveSpan(const PeerId& peer, uint64_t maxHeight, std::vector<crypto::hash>& ids);
+    // true if the peer was given a span and hasn't delivered it yet
+    bool hasSpan(const PeerId& peer) const;
+    Delivery deliverSpan(const PeerId& peer, std::list<cryptonote::block_complete_entry>&& blocks);
+    // Takes the next delivered span in height order. Only one caller feeds blocks at a time: while a caller is
+    // feeding, calls with feeding == false get nothing, and the feeder stops being one when it gets nothing.
+    bool takeReady(bool& feeding, std::list<cryptonote::block_complete_entry>& blocks, PeerId& deliverer);
+    // puts the span taken last back to be downloaded from a peer other than its deliverer, when its blocks failed to be
+    // added, and stops feeding
+    void retryTaken();
+    // returns and forgets the waiting peers there is a span for, or all of them once the download is over
+    std::vector<PeerId> takeWaitingPeers();
+    void releasePeer(const PeerId& peer);
+    void reset();
+    // true while scheduled blocks are not yet taken
+    bool isActive() const;
+
+  private:
+
+    enum class SpanState {
+      pending,
+      requested,
+      delivered
+    };
+
+    struct Span {
+      uint64_t startHeight;
+      std::vector<crypto::hash> ids;
+      SpanState state;
+      PeerId peer;
+      std::chrono::steady_clock::time_point requestTime;
+      std::list<cryptonote::block_complete_entry> blocks;
+    };
+
+    std::deque<Span>::iterator findSpan(uint64_t height);
+    bool isReservable(const Span& span, std::chrono::steady_clock::time_point now) const;
+    bool hasReservableSpan(uint64_t maxHeight, std::chrono::steady_clock::time_point now) const;
+    bool isReachable(uint64_t maxHeight) const;
+    void endDownload();
+
+    const size_t m_spanSize;
+    const size_t m_windowSpans;
+    const std::chrono::seconds m_spanTimeout;
+
+    mutable std::mutex m_mutex;
+    std::deque<Span> m_spans;
+    // start height of the span each peer was given last, kept after the span is given to another peer
+    std::map<PeerId, uint64_t> m_assignments;
+    // height of the chain of each peer that asked for a span, of the waiting ones and of all of them
+    std::map<PeerId, uint64_t> m_waitingPeers;
+    std::map<PeerId, uint64_t> m_peerHeights;
+    std::set<PeerId> m_failedPeers;
+    // the span taken last, without its blocks
+    Span m_taken;
+    bool m_feeding;
+
+  };
+}
@@ -0,0 +1,92 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BlockHashingTemplate.h"
+
+#include "cryptonote_core/cryptonote_format_utils.h"
+
+namespace CryptoNote
+{
+  BlockHashingTemplate::BlockHashingTemplate() : m_nonceOffset(0) {
+  }
+
+  bool BlockHashingTemplate::init(const cryptonote::Block& block) {
+    m_blob.clear();
+    m_laneBlobs.clear();
+
+    // the nonce offset depends on the varint encoded fields before it, find it by serializing two blobs with
+    // nonces which differ in every byte
+    cryptonote::Block probe(block);
+    cryptonote::blobdata lowBlob;
+    cryptonote::blobdata highBlob;
+    probe.nonce = 0;
+    if (!cryptonote::get_block_longhash_blob(probe, lowBlob)) {
+      return false;
+    }
+
+    probe.nonce = UINT32_MAX;
+    if (!cryptonote::get_block_longhash_blob(probe, highBlob)) {
+      return false;
+    }
+
+    if (lowBlob.size() != highBlob.size()) {
+      return false;
+    }
+
+    size_t offset = 0;
+    while (offset < lowBlob.size() && lowBlob[offset] == highBlob[offset]) {
+      ++offset;
+    }
+
+    if (offset + sizeof(uint32_t) > lowBlob.size() ||
+        lowBlob.compare(offset + sizeof(uint32_t), std::string::npos, highBlob, offset + sizeof(uint32_t), std::string::npos) != 0) {
+      return false;
+    }
+
+    m_blob.swap(lowBlob);
+    m_nonceOffset = offset;
+    return true;
+  }
+
+  void BlockHashingTemplate::hash(crypto::cn_context& context, uint32_t nonce, crypto::hash& result) {
+    setNonce(m_blob, nonce);
+    crypto::cn_slow_hash(context, m_blob.data(), m_blob.size(), result);
+  }
+
+  void BlockHashingTemplate::hash(crypto::cn_multi_context& context, const uint32_t* nonces, crypto::hash* results) {
+    if (m_laneBlobs.size() < context.ways()) {
+      m_laneBlobs.resize(context.ways(), m_blob);
+    }
+
+    const void* data[crypto::SLOW_HASH_MAX_WAYS];
+    size_t length[crypto::SLOW_HASH_MAX_WAYS];
+    for (size_t i = 0; i < context.ways(); ++i) {
+      setNonce(m_laneBlobs[i], nonces[i]);
+      data[i] = m_laneBlobs[i].data();
+      length[i] = m_laneBlobs[i].size();
+    }
+
+    crypto::cn_slow_hash_multi(context, data, length, results);
+  }
+
+  void BlockHashingTemplate::setNonce(cryptonote::blobdata& blob, uint32_t nonce) const {
+    // same byte order as the binary archive
+    for (size_t i = 0; i < sizeof(nonce); ++i) {
+      blob[m_nonceOffset + i] = static_cast<char>((nonce >> (8 * i)) & 0xff);
+    }
+  }
+}
@@ -0,0 +1,57 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "crypto/hash.h"
+#include "cryptonote_core/cryptonote_basic.h"
+#include "cryptonote_protocol/blobdatatype.h"
+
+namespace CryptoNote
+{
+  // Hashing blob of a block template that is serialized only once. The nonce is the only part of the blob that
+  // changes between hash attempts, so every attempt patches these 4 bytes in place and hashes the blob. Works for
+  // both BLOCK_MAJOR_VERSION_1 blocks and merge mined BLOCK_MAJOR_VERSION_2 blocks hashed through the parent block.
+  // The blob is modified by hash(), so every thread must use its own copy.
+  class BlockHashingTemplate {
+
+  public:
+
+    BlockHashingTemplate();
+
+    bool init(const cryptonote::Block& block);
+    bool isInitialized() const { return !m_blob.empty(); }
+
+    // the same value as cryptonote::get_block_longhash() of the block with the given nonce
+    void hash(crypto::cn_context& context, uint32_t nonce, crypto::hash& result);
+    // hashes context.ways() nonces in lockstep, results must have room for context.ways() hashes
+    void hash(crypto::cn_multi_context& context, const uint32_t* nonces, crypto::hash* results);
+
+  private:
+
+    void setNonce(cryptonote::blobdata& blob, uint32_t nonce) const;
+
+    cryptonote::blobdata m_blob;
+    std::vector<cryptonote::blobdata> m_laneBlobs;
+    size_t m_nonceOffset;
+
+  };
+}
@@ -0,0 +1,53 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BlockHeaderCache.h"
+
+#include <algorithm>
+
+namespace CryptoNote
+{
+  void BlockHeaderCache::push(uint64_t timestamp, cryptonote::difficulty_type cumulativeDifficulty, uint64_t blockCumulativeSize, uint64_t alreadyGeneratedCoins) {
+    m_timestamps.push_back(timestamp);
+    m_cumulativeDifficulties.push_back(cumulativeDifficulty);
+    m_blockCumulativeSizes.push_back(blockCumulativeSize);
+    m_alreadyGeneratedCoins.push_back(alreadyGeneratedCoins);
+  }
+
+  void BlockHeaderCache::pop() {
+    m_timestamps.pop_back();
+    m_cumulativeDifficulties.pop_back();
+    m_blockCumulativeSizes.pop_back();
+    m_alreadyGeneratedCoins.pop_back();
+  }
+
+  void BlockHeaderCache::clear() {
+    m_timestamps.clear();
+    m_cumulativeDifficulties.clear();
+    m_blockCumulativeSizes.clear();
+    m_alreadyGeneratedCoins.clear();
+  }
+
+  uint64_t BlockHeaderCache::timestampLowerBound(uint64_t startHeight, uint64_t timestamp) const {
+    if (startHeight >= m_timestamps.size()) {
+      return m_timestamps.size();
+    }
+
+    auto bound = std::lower_bound(m_timestamps.begin() + startHeight, m_timestamps.end(), timestamp);
+    return std::distance(m_timestamps.begin(), bound);
+  }
+}
@@ -0,0 +1,80 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "cryptonote_core/difficulty.h"
+
+namespace CryptoNote
+{
+  // Per-height columns of the block fields used by consensus checks (difficulty, timestamp median, block reward),
+  // kept in memory so that these checks don't have to load whole blocks from the swapped block storage.
+  class BlockHeaderCache {
+
+  public:
+
+    void push(uint64_t timestamp, cryptonote::difficulty_type cumulativeDifficulty, uint64_t blockCumulativeSize, uint64_t alreadyGeneratedCoins);
+    void pop();
+    void clear();
+
+    bool empty() const {
+      return m_timestamps.empty();
+    }
+
+    uint64_t size() const {
+      return m_timestamps.size();
+    }
+
+    uint64_t timestamp(uint64_t height) const {
+      return m_timestamps[static_cast<size_t>(height)];
+    }
+
+    cryptonote::difficulty_type cumulativeDifficulty(uint64_t height) const {
+      return m_cumulativeDifficulties[static_cast<size_t>(height)];
+    }
+
+    uint64_t blockCumulativeSize(uint64_t height) const {
+      return m_blockCumulativeSizes[static_cast<size_t>(height)];
+    }
+
+    uint64_t alreadyGeneratedCoins(uint64_t height) const {
+      return m_alreadyGeneratedCoins[static_cast<size_t>(height)];
+    }
+
+    // returns height of the first block at or after startHeight with timestamp not less than given one,
+    // or size() if there is no such block
+    uint64_t timestampLowerBound(uint64_t startHeight, uint64_t timestamp) const;
+
+    template <class Archive> void serialize(Archive& ar, const unsigned int version) {
+      ar & m_timestamps;
+      ar & m_cumulativeDifficulties;
+      ar & m_blockCumulativeSizes;
+      ar & m_alreadyGeneratedCoins;
+    }
+
+  private:
+
+    std::vector<uint64_t> m_timestamps;
+    std::vector<cryptonote::difficulty_type> m_cumulativeDifficulties;
+    std::vector<uint64_t> m_blockCumulativeSizes;
+    std::vector<uint64_t> m_alreadyGeneratedCoins;
+
+  };
+}
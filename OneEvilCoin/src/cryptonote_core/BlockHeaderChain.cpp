@@ -0,0 +1,177 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#include "BlockHeaderChain.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "include_base_utils.h"
+#include "misc_language.h"
+
+#include "cryptonote_core/cryptonote_format_utils.h"
+
+namespace CryptoNote
+{
+  BlockHeaderChain::BlockHeaderChain(const cryptonote::Currency& currency) : m_currency(currency), m_height(0),
+    m_tailId(cryptonote::null_hash), m_idsHeight(0), m_windowHeight(0) {
+  }
+
+  void BlockHeaderChain::reset(uint64_t height, const crypto::hash& prevId, const std::vector<uint64_t>& timestamps,
+    const std::vector<cryptonote::difficulty_type>& cumulativeDifficulties) {
+    assert(timestamps.size() == cumulativeDifficulties.size() && timestamps.size() <= height);
+    size_t count = std::min(timestamps.size(), windowSize());
+
+    m_height = height;
+    m_tailId = prevId;
+    m_idsHeight = height;
+    m_ids.clear();
+    m_windowHeight = height - count;
+    m_timestamps.assign(timestamps.end() - count, timestamps.end());
+    m_cumulativeDifficulties.assign(cumulativeDifficulties.end() - count, cumulativeDifficulties.end());
+  }
+
+  size_t BlockHeaderChain::windowSize() const {
+    return std::max(m_currency.difficultyBlocksCount(), m_currency.timestampCheckWindow());
+  }
+
+  size_t BlockHeaderChain::countChecked(uint64_t startHeight, const std::vector<crypto::hash>& ids) const {
+    size_t count = 0;
+    for (uint64_t height = startHeight; count < ids.size() && height >= m_idsHeight && height < m_height; ++height, ++count) {
+      if (m_ids[static_cast<size_t>(height - m_idsHeight)] != ids[count]) {
+        break;
+      }
+    }
+
+    return count;
+  }
+
+  void BlockHeaderChain::forgetBelow(uint64_t height) {
+    while (!m_ids.empty() && m_idsHeight < height) {
+      m_ids.pop_front();
+      ++m_idsHeight;
+    }
+  }
+
+  size_t BlockHeaderChain::check(const std::vector<cryptonote::Block>& headers, const cryptonote::checkpoints& checkpoints,
+    uint64_t adjustedTime, std::vector<cryptonote::difficulty_type>& difficulties) const {
+    // the headers are appended to a copy of the window, without the ids of the headers checked before
+    BlockHeaderChain chain(m_currency);
+    chain.m_height = m_height;
+    chain.m_tailId = m_tailId;
+    chain.m_idsHeight = m_height;
+    chain.m_windowHeight = m_windowHeight;
+    chain.m_timestamps = m_timestamps;
+    chain.m_cumulativeDifficulties = m_cumulativeDifficulties;
+
+    difficulties.clear();
+    for (const cryptonote::Block& header : headers) {
+      crypto::hash id = cryptonote::get_block_hash(header);
+      if (header.prevId != chain.m_tailId || cryptonote::get_block_height(header) != chain.m_height) {
+        LOG_PRINT_L1("Header " << id << " doesn't continue the header chain at height " << chain.m_height);
+        break;
+      }
+
+      if (!chain.checkTimestamp(header, adjustedTime)) {
+        LOG_PRINT_L1("Header " << id << " has invalid timestamp " << header.timestamp);
+        break;
+      }
+
+      cryptonote::difficulty_type difficulty = chain.nextDifficulty();
+      if (difficulty == 0) {
+        LOG_PRINT_L1("Difficulty overflow at header " << id);
+        break;
+      }
+
+      if (checkpoints.is_in_checkpoint_zone(chain.m_height) && !checkpoints.check_block(chain.m_height, id)) {
+        LOG_PRINT_L1("Header " << id << " doesn't match the checkpoint at height " << chain.m_height);
+        break;
+      }
+
+      difficulties.push_back(difficulty);
+      chain.push(id, header.timestamp, difficulty);
+    }
+
+    return difficulties.size();
+  }
+
+  bool BlockHeaderChain::append(const std::vector<cryptonote::Block>& headers, const std::vector<cryptonote::difficulty_type>& difficulties,
+    const std::vector<crypto::hash>& longHashes, const cryptonote::checkpoints& checkpoints) {
+    assert(difficulties.size() <= headers.size() && difficulties.size() <= longHashes.size());
+    for (size_t i = 0; i < difficulties.size(); ++i) {
+      const cryptonote::Block& header = headers[i];
+      crypto::hash id = cryptonote::get_block_hash(header);
+      assert(header.prevId == m_tailId);
+      if (!checkpoints.is_in_checkpoint_zone(m_height) && !m_currency.checkProofOfWork(header, difficulties[i], longHashes[i])) {
+        LOG_PRINT_L1("Header " << id << " has not enough proof of work for difficulty " << difficulties[i]);
+        return false;
+      }
+
+      push(id, header.timestamp, difficulties[i]);
+    }
+
+    return true;
+  }
+
+  void BlockHeaderChain::push(const crypto::hash& id, uint64_t timestamp, cryptonote::difficulty_type difficulty) {
+    cryptonote::difficulty_type cumulativeDifficulty = difficulty;
+    if (!m_cumulativeDifficulties.empty()) {
+      cumulativeDifficulty += m_cumulativeDifficulties.back();
+    }
+
+    m_timestamps.push_back(timestamp);
+    m_cumulativeDifficulties.push_back(cumulativeDifficulty);
+    if (m_timestamps.size() > windowSize()) {
+      m_timestamps.pop_front();
+      m_cumulativeDifficulties.pop_front();
+      ++m_windowHeight;
+    }
+
+    m_ids.push_back(id);
+    m_tailId = id;
+    ++m_height;
+  }
+
+  bool BlockHeaderChain::checkTimestamp(const cryptonote::Block& header, uint64_t adjustedTime) const {
+    if (header.timestamp > adjustedTime + m_currency.blockFutureTimeLimit()) {
+      return false;
+    }
+
+    // same rule as for blocks: not below the median of the last timestampCheckWindow blocks, when there are as many
+    uint64_t window = m_currency.timestampCheckWindow();
+    uint64_t begin = std::max(m_height > window ? m_height - window : 0, m_windowHeight);
+    if (m_height - begin < window) {
+      return true;
+    }
+
+    std::vector<uint64_t> timestamps(m_timestamps.begin() + static_cast<size_t>(begin - m_windowHeight), m_timestamps.end());
+    return header.timestamp >= epee::misc_utils::median(timestamps);
+  }
+
+  cryptonote::difficulty_type BlockHeaderChain::nextDifficulty() const {
+    // same window as for blocks, the genesis block is never part of it
+    uint64_t count = m_currency.difficultyBlocksCount();
+    uint64_t begin = std::max<uint64_t>(std::max<uint64_t>(m_height > count ? m_height - count : 0, 1), m_windowHeight);
+    std::vector<uint64_t> timestamps;
+    std::vector<cryptonote::difficulty_type> cumulativeDifficulties;
+    for (uint64_t height = begin; height < m_height; ++height) {
+      timestamps.push_back(m_timestamps[static_cast<size_t>(height - m_windowHeight)]);
+      cumulativeDifficulties.push_back(m_cumulativeDifficulties[static_cast<size_t>(height - m_windowHeight)]);
+    }
+
+    return m_currency.nextDifficulty(std::move(timestamps), std::move(cumulativeDifficulties));
+  }
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "crypto/hash.h"
+#include "cryptonote_core/checkpoints.h"
+#include "cryptonote_core/Currency.h"
+#include "cryptonote_core/difficulty.h"
+
+namespace CryptoNote
+{
+  // Checks a chain of block headers ahead of the blockchain. Headers are checked for linkage, timestamps and proof of
+  // work against the difficulty computed from the chain itself, so a peer's chain is verified before its block bodies
+  // are downloaded. Only the window of timestamps and cumulative difficulties needed for the next header is kept, along
+  // with the ids of checked headers whose blocks aren't in the blockchain yet.
+  class BlockHeaderChain {
+
+  public:
+
+    explicit BlockHeaderChain(const cryptonote::Currency& currency);
+
+    // starts the chain after the block prevId at height - 1, given the timestamps and cumulative difficulties of the
+    // blocks up to it, oldest first
+    void reset(uint64_t height, const crypto::hash& prevId, const std::vector<uint64_t>& timestamps,
+      const std::vector<cryptonote::difficulty_type>& cumulativeDifficulties);
+    // number of blocks the next header needs timestamps and cumulative difficulties of
+    size_t windowSize() const;
+    // height of the next header
+    uint64_t height() const { return m_height; }
+    // returns how many leading ids, the first one at startHeight, are ids of checked headers
+    size_t countChecked(uint64_t startHeight, const std::vector<crypto::hash>& ids) const;
+    // forgets the ids of headers below height, their blocks are in the blockchain
+    void forgetBelow(uint64_t height);
+
+    // checks the headers continuing the chain for everything but proof of work, which needs their long hashes, and
+    // returns how many leading headers pass. Headers in the checkpoint zone are compared with the checkpoints.
+    // difficulties get the difficulty each passing header has to meet.
+    size_t check(const std::vector<cryptonote::Block>& headers, const cryptonote::checkpoints& checkpoints,
+      uint64_t adjustedTime, std::vector<cryptonote::difficulty_type>& difficulties) const;
+    // checks the proof of work of the leading headers passing check, as many as there are difficulties, and appends
+    // them up to the first invalid one. longHashes are the long hashes of the headers outside the checkpoint zone.
+    bool append(const std::vector<cryptonote::Block>& headers, const std::vector<cryptonote::difficulty_type>& difficulties,
+      const std::vector<crypto::hash>& longHashes, const cryptonote::checkpoints& checkpoints);
+
+  private:
+
+    bool checkTimestamp(const cryptonote::Block& header, uint64_t adjustedTime) const;
+    cryptonote::difficulty_type nextDifficulty() const;
+    void push(const crypto::hash& id, uint64_t timestamp, cryptonote::difficulty_type difficulty);
+
+    const cryptonote::Currency& m_currency;
+    uint64_t m_height;
+    crypto::hash m_tailId;
+
+    uint64_t m_idsHeight;
+    std::deque<crypto::hash> m_ids;
+
+    uint64_t m_windowHeight;
+    std::deque<uint64_t> m_timestamps;
+    std::deque<cryptonote::difficulty_type> m_cumulativeDifficulties;
+
+  };
+}
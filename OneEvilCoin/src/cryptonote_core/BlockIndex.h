@@ -32,6 +32,14 @@ namespace CryptoNote
     BlockIndex() : 
       m_index(m_container.get<1>()) {}
 
+    BlockIndex(const BlockIndex& other) :
+      m_container(other.m_container), m_index(m_container.get<1>()) {}
+
+    BlockIndex& operator=(const BlockIndex& other) {
+      m_container = other.m_container;
+      return *this;
+    }
+
     void pop() {
       m_container.pop_back();
     }
@@ -0,0 +1,104 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BlockTemplateCache.h"
+
+#include <cstring>
+
+#include "misc_log_ex.h"
+#include "cryptonote_core/cryptonote_format_utils.h"
+#include "cryptonote_core/tx_extra.h"
+
+namespace CryptoNote
+{
+  const size_t BlockTemplateCache::INSTANCE_TAG_SIZE;
+
+  BlockTemplateCache::BlockTemplateCache(const TemplateBuilder& builder, std::chrono::seconds maxAge) :
+    m_builder(builder), m_maxAge(maxAge), m_version(0), m_nextTag(0) {
+  }
+
+  bool BlockTemplateCache::getTemplate(const cryptonote::AccountPublicAddress& address, size_t reserveSize, uint64_t version,
+    BlockTemplateInstance& instance) {
+    if (reserveSize > TX_EXTRA_NONCE_MAX_COUNT - INSTANCE_TAG_SIZE) {
+      LOG_ERROR("Too big reserve size " << reserveSize);
+      return false;
+    }
+
+    TemplateKey key(std::string(reinterpret_cast<const char*>(&address), sizeof(address)), reserveSize);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (version != m_version) {
+      m_templates.clear();
+      m_version = version;
+    }
+
+    auto it = m_templates.find(key);
+    if (it == m_templates.end() || std::chrono::steady_clock::now() - it->second.created > m_maxAge) {
+      CachedTemplate cached;
+      if (!buildTemplate(address, reserveSize, cached)) {
+        return false;
+      }
+
+      m_templates[key] = std::move(cached);
+      it = m_templates.find(key);
+    }
+
+    const CachedTemplate& cached = it->second;
+    instance.blob = cached.blob;
+    instance.difficulty = cached.difficulty;
+    instance.height = cached.height;
+    instance.version = m_version;
+    instance.reservedOffset = reserveSize > 0 ? cached.tagOffset + INSTANCE_TAG_SIZE : 0;
+
+    uint32_t tag = m_nextTag++;
+    for (size_t i = 0; i < INSTANCE_TAG_SIZE; ++i) {
+      instance.blob[cached.tagOffset + i] = static_cast<char>(tag >> (8 * i));
+    }
+
+    return true;
+  }
+
+  bool BlockTemplateCache::buildTemplate(const cryptonote::AccountPublicAddress& address, size_t reserveSize, CachedTemplate& cached) {
+    cryptonote::Block block;
+    cryptonote::blobdata extraNonce(INSTANCE_TAG_SIZE + reserveSize, 0);
+    if (!m_builder(block, address, cached.difficulty, cached.height, extraNonce)) {
+      LOG_ERROR("Failed to create block template");
+      return false;
+    }
+
+    cached.blob = cryptonote::t_serializable_object_to_blob(block);
+
+    // the extra nonce follows the transaction public key: TX_EXTRA_NONCE tag, size, nonce bytes
+    crypto::public_key txPublicKey = cryptonote::get_tx_pub_key_from_extra(block.minerTx);
+    size_t keyOffset = cached.blob.find(std::string(reinterpret_cast<const char*>(&txPublicKey), sizeof(txPublicKey)));
+    if (txPublicKey == cryptonote::null_pkey || keyOffset == std::string::npos) {
+      LOG_ERROR("Failed to find tx pub key in block template blob");
+      return false;
+    }
+
+    cached.tagOffset = keyOffset + sizeof(txPublicKey) + 2;
+    if (cached.tagOffset + extraNonce.size() > cached.blob.size() ||
+        static_cast<uint8_t>(cached.blob[cached.tagOffset - 2]) != TX_EXTRA_NONCE ||
+        static_cast<uint8_t>(cached.blob[cached.tagOffset - 1]) != extraNonce.size()) {
+      LOG_ERROR("Failed to find extra nonce in block template blob");
+      return false;
+    }
+
+    cached.created = std::chrono::steady_clock::now();
+    return true;
+  }
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "crypto/hash.h"
+#include "cryptonote_core/cryptonote_basic.h"
+#include "cryptonote_core/difficulty.h"
+#include "cryptonote_protocol/blobdatatype.h"
+
+namespace CryptoNote
+{
+  struct BlockTemplateInstance {
+    cryptonote::blobdata blob;
+    cryptonote::difficulty_type difficulty;
+    uint64_t height;
+    uint64_t version;
+    // offset of the reserve bytes requested by the caller, 0 if none were requested
+    size_t reservedOffset;
+  };
+
+  // Block templates built once per template version and handed out to any number of callers. Every template
+  // reserves INSTANCE_TAG_SIZE extra nonce bytes in front of the bytes requested by the caller and every issued
+  // instance gets a distinct tag there, so callers never hash the same work. Templates are rebuilt when the
+  // version changes or when they get older than maxAge.
+  class BlockTemplateCache {
+
+  public:
+
+    static const size_t INSTANCE_TAG_SIZE = sizeof(uint32_t);
+
+    typedef std::function<bool(cryptonote::Block& block, const cryptonote::AccountPublicAddress& address,
+      cryptonote::difficulty_type& difficulty, uint64_t& height, const cryptonote::blobdata& extraNonce)> TemplateBuilder;
+
+    BlockTemplateCache(const TemplateBuilder& builder, std::chrono::seconds maxAge);
+
+    bool getTemplate(const cryptonote::AccountPublicAddress& address, size_t reserveSize, uint64_t version, BlockTemplateInstance& instance);
+
+  private:
+
+    struct CachedTemplate {
+      cryptonote::blobdata blob;
+      cryptonote::difficulty_type difficulty;
+      uint64_t height;
+      size_t tagOffset;
+      std::chrono::steady_clock::time_point created;
+    };
+
+    // raw address keys and the reserve size
+    typedef std::pair<std::string, size_t> TemplateKey;
+
+    bool buildTemplate(const cryptonote::AccountPublicAddress& address, size_t reserveSize, CachedTemplate& cached);
+
+    TemplateBuilder m_builder;
+    std::chrono::seconds m_maxAge;
+
+    mutable std::mutex m_mutex;
+    uint64_t m_version;
+    std::map<TemplateKey, CachedTemplate> m_templates;
+    uint32_t m_nextTag;
+
+  };
+}
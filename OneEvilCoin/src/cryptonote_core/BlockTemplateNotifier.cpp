@@ -0,0 +1,72 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BlockTemplateNotifier.h"
+
+namespace CryptoNote
+{
+  BlockTemplateNotifier::BlockTemplateNotifier(uint64_t feeThreshold) :
+    m_version(1), m_feeThreshold(feeThreshold), m_pendingFees(0) {
+  }
+
+  uint64_t BlockTemplateNotifier::version() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_version;
+  }
+
+  void BlockTemplateNotifier::setFeeThreshold(uint64_t feeThreshold) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_feeThreshold = feeThreshold;
+  }
+
+  void BlockTemplateNotifier::blockchainUpdated() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    changeVersion();
+  }
+
+  void BlockTemplateNotifier::transactionsRemoved() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    changeVersion();
+  }
+
+  bool BlockTemplateNotifier::transactionAdded(uint64_t fee) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_feeThreshold == 0) {
+      return false;
+    }
+
+    m_pendingFees += fee;
+    if (m_pendingFees < m_feeThreshold) {
+      return false;
+    }
+
+    changeVersion();
+    return true;
+  }
+
+  uint64_t BlockTemplateNotifier::waitForChange(uint64_t knownVersion, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_changed.wait_for(lock, timeout, [&] { return m_version != knownVersion; });
+    return m_version;
+  }
+
+  void BlockTemplateNotifier::changeVersion() {
+    ++m_version;
+    m_pendingFees = 0;
+    m_changed.notify_all();
+  }
+}
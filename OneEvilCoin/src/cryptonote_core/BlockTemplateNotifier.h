@@ -0,0 +1,58 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace CryptoNote
+{
+  // Version of the block template contents. It changes when a new block extends the main chain, when
+  // transactions leave the pool, and when the fees of transactions added to the pool since the last change
+  // reach the threshold. Threshold 0 disables refreshing for fees. Waiters are woken up on every change.
+  class BlockTemplateNotifier {
+
+  public:
+
+    explicit BlockTemplateNotifier(uint64_t feeThreshold);
+
+    uint64_t version() const;
+    void setFeeThreshold(uint64_t feeThreshold);
+
+    void blockchainUpdated();
+    void transactionsRemoved();
+    // returns true if the added fees changed the version
+    bool transactionAdded(uint64_t fee);
+
+    // returns the current version as soon as it differs from knownVersion, or when the timeout expires
+    uint64_t waitForChange(uint64_t knownVersion, std::chrono::milliseconds timeout);
+
+  private:
+
+    void changeVersion();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_changed;
+    uint64_t m_version;
+    uint64_t m_feeThreshold;
+    uint64_t m_pendingFees;
+
+  };
+}
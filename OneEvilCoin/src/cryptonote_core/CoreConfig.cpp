@@ -19,18 +19,28 @@
 
 #include "common/util.h"
 #include "common/command_line.h"
+#include "cryptonote_config.h"
 
 namespace cryptonote {
 
+namespace {
+const command_line::arg_descriptor<uint64_t> arg_mempool_max_size = {"mempool-max-size", "Maximum memory used by the transaction pool, in bytes. The cheapest transactions per byte are evicted above it", parameters::CRYPTONOTE_MEMPOOL_DEFAULT_MAX_SIZE};
+}
+
 CoreConfig::CoreConfig() {
   configFolder = tools::get_default_data_dir();
+  mempoolMaxSize = parameters::CRYPTONOTE_MEMPOOL_DEFAULT_MAX_SIZE;
 }
 
 void CoreConfig::init(const boost::program_options::variables_map& options) {
   configFolder = command_line::get_arg(options, command_line::arg_data_dir);
+  if (command_line::has_arg(options, arg_mempool_max_size)) {
+    mempoolMaxSize = command_line::get_arg(options, arg_mempool_max_size);
+  }
 }
 
 void CoreConfig::initOptions(boost::program_options::options_description& desc) {
+  command_line::add_arg(desc, arg_mempool_max_size);
 }
 } //namespace cryptonote
 
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 #include <boost/program_options.hpp>
@@ -31,6 +32,7 @@ public:
   void init(const boost::program_options::variables_map& options);
 
   std::string configFolder;
+  uint64_t mempoolMaxSize;
 };
 
 } //namespace cryptonote
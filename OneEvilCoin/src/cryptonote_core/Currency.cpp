@@ -43,6 +43,7 @@ namespace cryptonote {
       m_upgradeHeight = 0;
       m_blocksFileName       = "testnet_" + m_blocksFileName;
       m_blocksCacheFileName  = "testnet_" + m_blocksCacheFileName;
+      m_blocksCacheJournalFileName = "testnet_" + m_blocksCacheJournalFileName;
       m_blockIndexesFileName = "testnet_" + m_blockIndexesFileName;
       m_txPoolFileName       = "testnet_" + m_txPoolFileName;
     }
@@ -285,29 +286,21 @@ namespace cryptonote {
     return (low + timeSpan - 1) / timeSpan;
   }
 
-  bool Currency::checkProofOfWorkV1(crypto::cn_context& context, const Block& block, difficulty_type currentDiffic,
-                                    crypto::hash& proofOfWork) const {
+  bool Currency::checkProofOfWorkV1(const Block& block, difficulty_type currentDiffic,
+                                    const crypto::hash& proofOfWork) const {
     if (BLOCK_MAJOR_VERSION_1 != block.majorVersion) {
       return false;
     }
 
-    if (!get_block_longhash(context, block, proofOfWork)) {
-      return false;
-    }
-
     return check_hash(proofOfWork, currentDiffic);
   }
 
-  bool Currency::checkProofOfWorkV2(crypto::cn_context& context, const Block& block, difficulty_type currentDiffic,
-                                    crypto::hash& proofOfWork) const {
+  bool Currency::checkProofOfWorkV2(const Block& block, difficulty_type currentDiffic,
+                                    const crypto::hash& proofOfWork) const {
     if (BLOCK_MAJOR_VERSION_2 != block.majorVersion) {
       return false;
     }
 
-    if (!get_block_longhash(context, block, proofOfWork)) {
-      return false;
-    }
-
     if (!check_hash(proofOfWork, currentDiffic)) {
       return false;
     }
@@ -335,15 +328,22 @@ namespace cryptonote {
     return true;
   }
 
-  bool Currency::checkProofOfWork(crypto::cn_context& context, const Block& block, difficulty_type currentDiffic, crypto::hash& proofOfWork) const {
+  bool Currency::checkProofOfWork(const Block& block, difficulty_type currentDiffic, const crypto::hash& proofOfWork) const {
     switch (block.majorVersion) {
-    case BLOCK_MAJOR_VERSION_1: return checkProofOfWorkV1(context, block, currentDiffic, proofOfWork);
-    case BLOCK_MAJOR_VERSION_2: return checkProofOfWorkV2(context, block, currentDiffic, proofOfWork);
+    case BLOCK_MAJOR_VERSION_1: return checkProofOfWorkV1(block, currentDiffic, proofOfWork);
+    case BLOCK_MAJOR_VERSION_2: return checkProofOfWorkV2(block, currentDiffic, proofOfWork);
     }
 
     CHECK_AND_ASSERT_MES(false, false, "Unknown block major version: " << block.majorVersion << "." << block.minorVersion);
   }
 
+  bool Currency::checkProofOfWork(crypto::cn_context& context, const Block& block, difficulty_type currentDiffic, crypto::hash& proofOfWork) const {
+    bool r = get_block_longhash(context, block, proofOfWork);
+    CHECK_AND_ASSERT_MES(r, false, "Failed to compute long hash of block with version " << block.majorVersion << "." << block.minorVersion);
+
+    return checkProofOfWork(block, currentDiffic, proofOfWork);
+  }
+
   CurrencyBuilder::CurrencyBuilder() {
     maxBlockNumber(parameters::CRYPTONOTE_MAX_BLOCK_NUMBER);
     maxBlockBlobSize(parameters::CRYPTONOTE_MAX_BLOCK_BLOB_SIZE);
@@ -388,6 +388,7 @@ namespace cryptonote {
 
     blocksFileName(parameters::CRYPTONOTE_BLOCKS_FILENAME);
     blocksCacheFileName(parameters::CRYPTONOTE_BLOCKSCACHE_FILENAME);
+    blocksCacheJournalFileName(parameters::CRYPTONOTE_BLOCKSCACHE_JOURNAL_FILENAME);
     blockIndexesFileName(parameters::CRYPTONOTE_BLOCKINDEXES_FILENAME);
     txPoolFileName(parameters::CRYPTONOTE_POOLDATA_FILENAME);
 
@@ -81,6 +81,7 @@ namespace cryptonote
 
     const std::string& blocksFileName() const { return m_blocksFileName; }
     const std::string& blocksCacheFileName() const { return m_blocksCacheFileName; }
+    const std::string& blocksCacheJournalFileName() const { return m_blocksCacheJournalFileName; }
     const std::string& blockIndexesFileName() const { return m_blockIndexesFileName; }
     const std::string& txPoolFileName() const { return m_txPoolFileName; }
 
@@ -105,8 +106,10 @@ namespace cryptonote
 
     difficulty_type nextDifficulty(std::vector<uint64_t> timestamps, std::vector<difficulty_type> cumulativeDifficulties) const;
 
-    bool checkProofOfWorkV1(crypto::cn_context& context, const Block& block, difficulty_type currentDiffic, crypto::hash& proofOfWork) const;
-    bool checkProofOfWorkV2(crypto::cn_context& context, const Block& block, difficulty_type currentDiffic, crypto::hash& proofOfWork) const;
+    bool checkProofOfWorkV1(const Block& block, difficulty_type currentDiffic, const crypto::hash& proofOfWork) const;
+    bool checkProofOfWorkV2(const Block& block, difficulty_type currentDiffic, const crypto::hash& proofOfWork) const;
+    // checks proof of work given the block long hash, that was computed in advance by get_block_longhash
+    bool checkProofOfWork(const Block& block, difficulty_type currentDiffic, const crypto::hash& proofOfWork) const;
     bool checkProofOfWork(crypto::cn_context& context, const Block& block, difficulty_type currentDiffic, crypto::hash& proofOfWork) const;
 
   private:
@@ -162,6 +165,7 @@ namespace cryptonote
 
     std::string m_blocksFileName;
     std::string m_blocksCacheFileName;
+    std::string m_blocksCacheJournalFileName;
     std::string m_blockIndexesFileName;
     std::string m_txPoolFileName;
 
@@ -227,6 +231,7 @@ namespace cryptonote
 
     CurrencyBuilder& blocksFileName(const std::string& val) { m_currency.m_blocksFileName = val; return *this; }
     CurrencyBuilder& blocksCacheFileName(const std::string& val) { m_currency.m_blocksCacheFileName = val; return *this; }
+    CurrencyBuilder& blocksCacheJournalFileName(const std::string& val) { m_currency.m_blocksCacheJournalFileName = val; return *this; }
     CurrencyBuilder& blockIndexesFileName(const std::string& val) { m_currency.m_blockIndexesFileName = val; return *this; }
     CurrencyBuilder& txPoolFileName(const std::string& val) { m_currency.m_txPoolFileName = val; return *this; }
 
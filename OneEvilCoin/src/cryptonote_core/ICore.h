@@ -52,6 +52,8 @@ public:
   virtual i_cryptonote_protocol* get_protocol() = 0;
   virtual bool handle_incoming_tx(const blobdata& tx_blob, tx_verification_context& tvc, bool keeped_by_block) = 0;
   virtual bool getPoolSymmetricDifference(const std::vector<crypto::hash>& known_pool_tx_ids, const crypto::hash& known_block_id, bool& isBcActual, std::vector<Transaction>& new_txs, std::vector<crypto::hash>& deleted_tx_ids) = 0;
+  virtual bool getPoolChanges(const crypto::hash& knownBlockId, uint64_t knownPoolVersion, bool& isBcActual, bool& isPoolVersionActual, uint64_t& poolVersion,
+      std::vector<Transaction>& newTxs, std::vector<crypto::hash>& deletedTxIds) = 0;
   virtual bool queryBlocks(const std::list<crypto::hash>& block_ids, uint64_t timestamp,
       uint64_t& start_height, uint64_t& current_height, uint64_t& full_offset, std::list<BlockFullInfo>& entries) = 0;
 
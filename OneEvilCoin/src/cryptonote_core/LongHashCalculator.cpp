@@ -0,0 +1,192 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "LongHashCalculator.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "cryptonote_core/cryptonote_format_utils.h"
+
+namespace CryptoNote
+{
+  LongHashCalculator::LongHashCalculator(size_t maxWorkers, size_t maxHashes, std::chrono::milliseconds idleTimeout) :
+    m_maxWorkers(maxWorkers), m_maxHashes(maxHashes), m_idleTimeout(idleTimeout), m_stopped(false) {
+  }
+
+  LongHashCalculator::~LongHashCalculator() {
+    std::vector<std::thread> workers;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_stopped = true;
+      m_jobQueued.notify_all();
+      m_hashComputed.notify_all();
+      for (auto& worker : m_workers) {
+        workers.push_back(std::move(worker.second));
+      }
+
+      m_workers.clear();
+      std::move(m_exitedWorkers.begin(), m_exitedWorkers.end(), std::back_inserter(workers));
+      m_exitedWorkers.clear();
+    }
+
+    for (std::thread& worker : workers) {
+      worker.join();
+    }
+  }
+
+  void LongHashCalculator::submit(const std::vector<cryptonote::Block>& blocks) {
+    std::vector<Job> jobs;
+    jobs.reserve(blocks.size());
+    for (const cryptonote::Block& block : blocks) {
+      Job job;
+      job.blockHash = cryptonote::get_block_hash(block);
+      if (cryptonote::get_block_longhash_blob(block, job.blob)) {
+        jobs.push_back(std::move(job));
+      }
+    }
+
+    std::vector<std::thread> exitedWorkers;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      if (m_maxWorkers == 0) {
+        return;
+      }
+
+      for (Job& job : jobs) {
+        if (m_hashes.push_back(Hash{ job.blockHash, cryptonote::null_hash, false }).second) {
+          m_jobs.push_back(std::move(job));
+        }
+      }
+
+      while (m_workers.size() < std::min(m_maxWorkers, m_jobs.size())) {
+        std::thread worker(&LongHashCalculator::workerLoop, this);
+        std::thread::id id = worker.get_id();
+        m_workers.emplace(id, std::move(worker));
+      }
+
+      exitedWorkers.swap(m_exitedWorkers);
+      m_jobQueued.notify_all();
+    }
+
+    for (std::thread& worker : exitedWorkers) {
+      worker.join();
+    }
+  }
+
+  size_t LongHashCalculator::workerCount() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_workers.size();
+  }
+
+  bool LongHashCalculator::get(const crypto::hash& blockHash, crypto::hash& longHash) {
+    return wait(blockHash, longHash, false);
+  }
+
+  bool LongHashCalculator::take(const crypto::hash& blockHash, crypto::hash& longHash) {
+    return wait(blockHash, longHash, true);
+  }
+
+  void LongHashCalculator::workerLoop() {
+    // the scratchpads of a worker are allocated once
+    crypto::cn_multi_context context;
+    const void* data[crypto::SLOW_HASH_MAX_WAYS];
+    size_t length[crypto::SLOW_HASH_MAX_WAYS];
+    crypto::hash hashes[crypto::SLOW_HASH_MAX_WAYS];
+    std::vector<Job> jobs;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stopped && m_jobs.empty()) {
+          if (m_jobQueued.wait_for(lock, m_idleTimeout) == std::cv_status::timeout && m_jobs.empty()) {
+            exitWorker();
+            return;
+          }
+        }
+
+        if (m_stopped) {
+          return;
+        }
+
+        size_t count = std::min(context.ways(), m_jobs.size());
+        jobs.assign(std::make_move_iterator(m_jobs.begin()), std::make_move_iterator(m_jobs.begin() + count));
+        m_jobs.erase(m_jobs.begin(), m_jobs.begin() + count);
+      }
+
+      // pad the remaining lanes with the last blob, their results are ignored
+      for (size_t lane = 0; lane < context.ways(); ++lane) {
+        const cryptonote::blobdata& blob = jobs[std::min(lane, jobs.size() - 1)].blob;
+        data[lane] = blob.data();
+        length[lane] = blob.size();
+      }
+
+      crypto::cn_slow_hash_multi(context, data, length, hashes);
+
+      std::unique_lock<std::mutex> lock(m_mutex);
+      auto& index = m_hashes.get<1>();
+      for (size_t i = 0; i < jobs.size(); ++i) {
+        auto it = index.find(jobs[i].blockHash);
+        if (it != index.end()) {
+          it->longHash = hashes[i];
+          it->computed = true;
+        }
+      }
+
+      // only computed hashes are dropped, the ones waited for are always there
+      while (m_hashes.size() > m_maxHashes && m_hashes.front().computed) {
+        m_hashes.pop_front();
+      }
+
+      m_hashComputed.notify_all();
+    }
+  }
+
+  void LongHashCalculator::exitWorker() {
+    // called with m_mutex held, the destructor joins the workers it took out of m_workers itself
+    auto it = m_workers.find(std::this_thread::get_id());
+    if (it != m_workers.end()) {
+      m_exitedWorkers.push_back(std::move(it->second));
+      m_workers.erase(it);
+    }
+  }
+
+  bool LongHashCalculator::wait(const crypto::hash& blockHash, crypto::hash& longHash, bool forget) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto& index = m_hashes.get<1>();
+    for (;;) {
+      auto it = index.find(blockHash);
+      if (it == index.end()) {
+        return false;
+      }
+
+      if (it->computed) {
+        longHash = it->longHash;
+        if (forget) {
+          index.erase(it);
+        }
+
+        return true;
+      }
+
+      if (m_stopped) {
+        return false;
+      }
+
+      m_hashComputed.wait(lock);
+    }
+  }
+}
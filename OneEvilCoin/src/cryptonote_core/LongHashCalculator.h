@@ -0,0 +1,103 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+
+#include "crypto/hash.h"
+#include "cryptonote_core/cryptonote_basic.h"
+#include "cryptonote_protocol/blobdatatype.h"
+
+namespace CryptoNote
+{
+  // Pool of up to maxWorkers threads that computes long hashes of blocks ahead of adding them, several blocks per worker
+  // at once. Submitting returns at once and the hashes are waited for when they are needed. Hashes of blocks that never
+  // get added are dropped, oldest first, beyond maxHashes.
+  // Workers and their scratchpads are created only when blocks are submitted and go away after idleTimeout without
+  // work, so a synchronized node doesn't keep them.
+  class LongHashCalculator {
+
+  public:
+
+    LongHashCalculator(size_t maxWorkers, size_t maxHashes, std::chrono::milliseconds idleTimeout = std::chrono::seconds(30));
+    ~LongHashCalculator();
+
+    LongHashCalculator(const LongHashCalculator&) = delete;
+    LongHashCalculator& operator=(const LongHashCalculator&) = delete;
+
+    // queues the blocks that aren't queued or hashed yet
+    void submit(const std::vector<cryptonote::Block>& blocks);
+    // waits for the long hash of a submitted block, returns false if it wasn't submitted or its hash was dropped
+    bool get(const crypto::hash& blockHash, crypto::hash& longHash);
+    // same as get, but forgets the hash
+    bool take(const crypto::hash& blockHash, crypto::hash& longHash);
+    // number of running workers
+    size_t workerCount();
+
+  private:
+
+    struct Hash {
+      crypto::hash blockHash;
+      mutable crypto::hash longHash;
+      mutable bool computed;
+    };
+
+    // hashes oldest first, looked up by block hash
+    typedef boost::multi_index_container<
+      Hash,
+      boost::multi_index::indexed_by<
+        boost::multi_index::sequenced<>,
+        boost::multi_index::hashed_unique<boost::multi_index::member<Hash, crypto::hash, &Hash::blockHash>>
+      >
+    > Hashes;
+
+    struct Job {
+      crypto::hash blockHash;
+      cryptonote::blobdata blob;
+    };
+
+    void workerLoop();
+    void exitWorker();
+    bool wait(const crypto::hash& blockHash, crypto::hash& longHash, bool forget);
+
+    const size_t m_maxWorkers;
+    const size_t m_maxHashes;
+    const std::chrono::milliseconds m_idleTimeout;
+    std::map<std::thread::id, std::thread> m_workers;
+    std::vector<std::thread> m_exitedWorkers; // joined by the next submit or the destructor
+
+    std::mutex m_mutex;
+    std::condition_variable m_jobQueued;
+    std::condition_variable m_hashComputed;
+    std::deque<Job> m_jobs;
+    Hashes m_hashes;
+    bool m_stopped;
+
+  };
+}
@@ -18,6 +18,7 @@
 #include "MinerConfig.h"
 
 #include "common/command_line.h"
+#include "cryptonote_config.h"
 
 namespace cryptonote {
 
@@ -25,16 +26,27 @@ namespace {
 const command_line::arg_descriptor<std::string> arg_extra_messages =  {"extra-messages-file", "Specify file for extra messages to include into coinbase transactions", "", true};
 const command_line::arg_descriptor<std::string> arg_start_mining =    {"start-mining", "Specify wallet address to mining for", "", true};
 const command_line::arg_descriptor<uint32_t>    arg_mining_threads =  {"mining-threads", "Specify mining threads count", 0, true};
+const command_line::arg_descriptor<uint32_t>    arg_hashes_per_thread = {"mining-hashes-per-thread", "Specify how many hashes every mining thread computes at once (1, 2 or 4), 0 to detect", 0, true};
+const command_line::arg_descriptor<std::string> arg_thread_affinity = {"mining-thread-affinity", "Pin mining threads to CPUs: \"auto\" to use every physical core before SMT siblings, or a CPU list like 0-3,8", "", true};
+const command_line::arg_descriptor<std::string> arg_thread_priority = {"mining-thread-priority", "Specify mining threads priority: normal, low or idle", "normal", true};
+const command_line::arg_descriptor<uint64_t>    arg_template_fee_threshold = {"mining-template-fee-threshold", "Rebuild block templates when the fees of new pool transactions reach this amount, 0 to rebuild only on new blocks", parameters::MINIMUM_FEE, true};
 }
 
 MinerConfig::MinerConfig() {
   miningThreads = 0;
+  hashesPerThread = 0;
+  threadPriority = "normal";
+  templateFeeThreshold = parameters::MINIMUM_FEE;
 }
 
 void MinerConfig::initOptions(boost::program_options::options_description& desc) {
   command_line::add_arg(desc, arg_extra_messages);
   command_line::add_arg(desc, arg_start_mining);
   command_line::add_arg(desc, arg_mining_threads);
+  command_line::add_arg(desc, arg_hashes_per_thread);
+  command_line::add_arg(desc, arg_thread_affinity);
+  command_line::add_arg(desc, arg_thread_priority);
+  command_line::add_arg(desc, arg_template_fee_threshold);
 }
 
 void MinerConfig::init(const boost::program_options::variables_map& options) {
@@ -49,6 +61,22 @@ void MinerConfig::init(const boost::program_options::variables_map& options) {
   if (command_line::has_arg(options, arg_mining_threads)) {
     miningThreads = command_line::get_arg(options, arg_mining_threads);
   }
+
+  if (command_line::has_arg(options, arg_hashes_per_thread)) {
+    hashesPerThread = command_line::get_arg(options, arg_hashes_per_thread);
+  }
+
+  if (command_line::has_arg(options, arg_thread_affinity)) {
+    threadAffinity = command_line::get_arg(options, arg_thread_affinity);
+  }
+
+  if (command_line::has_arg(options, arg_thread_priority)) {
+    threadPriority = command_line::get_arg(options, arg_thread_priority);
+  }
+
+  if (command_line::has_arg(options, arg_template_fee_threshold)) {
+    templateFeeThreshold = command_line::get_arg(options, arg_template_fee_threshold);
+  }
 }
 
 } //namespace cryptonote
@@ -34,6 +34,10 @@ public:
   std::string extraMessages;
   std::string startMining;
   uint32_t miningThreads;
+  uint32_t hashesPerThread;
+  std::string threadAffinity;
+  std::string threadPriority;
+  uint64_t templateFeeThreshold;
 };
 
 } //namespace cryptonote
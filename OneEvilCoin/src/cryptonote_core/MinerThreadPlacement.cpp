@@ -0,0 +1,182 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "MinerThreadPlacement.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <thread>
+#include <tuple>
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/lexical_cast.hpp>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace CryptoNote
+{
+  namespace {
+#if defined(__linux__)
+    bool readTopologyValue(uint32_t cpu, const char* name, uint32_t& value) {
+      std::ifstream file("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/" + name);
+      return static_cast<bool>(file >> value);
+    }
+#endif
+  }
+
+  std::vector<LogicalCpu> detectCpuTopology() {
+    std::vector<LogicalCpu> cpus;
+    uint32_t count = std::max(std::thread::hardware_concurrency(), 1u);
+    for (uint32_t cpu = 0; cpu < count; ++cpu) {
+      LogicalCpu logicalCpu = { cpu, cpu, 0 };
+#if defined(__linux__)
+      uint32_t core;
+      uint32_t package;
+      if (readTopologyValue(cpu, "core_id", core) && readTopologyValue(cpu, "physical_package_id", package)) {
+        logicalCpu.core = core;
+        logicalCpu.package = package;
+      }
+#endif
+      cpus.push_back(logicalCpu);
+    }
+
+    return cpus;
+  }
+
+  std::vector<uint32_t> spreadOverPhysicalCores(const std::vector<LogicalCpu>& cpus) {
+    // siblings[package][core] lists the logical CPUs of every physical core
+    std::map<uint32_t, std::map<uint32_t, std::vector<uint32_t>>> siblings;
+    for (const LogicalCpu& cpu : cpus) {
+      siblings[cpu.package][cpu.core].push_back(cpu.cpu);
+    }
+
+    // (sibling rank, core rank inside the package, package) orders every core before any of the SMT siblings
+    std::vector<std::tuple<size_t, size_t, uint32_t, uint32_t>> order;
+    for (const auto& package : siblings) {
+      size_t coreRank = 0;
+      for (const auto& core : package.second) {
+        for (size_t siblingRank = 0; siblingRank < core.second.size(); ++siblingRank) {
+          order.emplace_back(siblingRank, coreRank, package.first, core.second[siblingRank]);
+        }
+
+        ++coreRank;
+      }
+    }
+
+    std::sort(order.begin(), order.end());
+    std::vector<uint32_t> result;
+    for (const auto& entry : order) {
+      result.push_back(std::get<3>(entry));
+    }
+
+    return result;
+  }
+
+  bool parseCpuList(const std::string& list, std::vector<uint32_t>& cpus) {
+    cpus.clear();
+    std::vector<std::string> ranges;
+    boost::split(ranges, list, boost::is_any_of(","));
+    for (const std::string& range : ranges) {
+      size_t dash = range.find('-');
+      try {
+        if (dash == std::string::npos) {
+          cpus.push_back(boost::lexical_cast<uint32_t>(range));
+        } else {
+          uint32_t first = boost::lexical_cast<uint32_t>(range.substr(0, dash));
+          uint32_t last = boost::lexical_cast<uint32_t>(range.substr(dash + 1));
+          if (first > last) {
+            return false;
+          }
+
+          for (uint32_t cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+          }
+        }
+      } catch (boost::bad_lexical_cast&) {
+        return false;
+      }
+    }
+
+    return !cpus.empty();
+  }
+
+  bool parseMinerThreadPriority(const std::string& name, MinerThreadPriority& priority) {
+    if (name == "normal") {
+      priority = MinerThreadPriority::NORMAL;
+    } else if (name == "low") {
+      priority = MinerThreadPriority::LOW;
+    } else if (name == "idle") {
+      priority = MinerThreadPriority::IDLE;
+    } else {
+      return false;
+    }
+
+    return true;
+  }
+
+  bool setCurrentThreadAffinity(uint32_t cpu) {
+#if defined(_WIN32)
+    if (cpu >= sizeof(DWORD_PTR) * 8) {
+      return false;
+    }
+
+    return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << cpu) != 0;
+#elif defined(__linux__)
+    if (cpu >= CPU_SETSIZE) {
+      return false;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+  }
+
+  bool setCurrentThreadPriority(MinerThreadPriority priority) {
+    if (priority == MinerThreadPriority::NORMAL) {
+      return true;
+    }
+
+#if defined(_WIN32)
+    int value = priority == MinerThreadPriority::LOW ? THREAD_PRIORITY_BELOW_NORMAL : THREAD_PRIORITY_IDLE;
+    return SetThreadPriority(GetCurrentThread(), value) != 0;
+#elif defined(__linux__)
+    if (priority == MinerThreadPriority::IDLE) {
+      sched_param param = {};
+      return pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) == 0;
+    }
+
+    // on Linux the nice value of a thread id only affects that thread
+    return setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10) == 0;
+#else
+    return false;
+#endif
+  }
+}
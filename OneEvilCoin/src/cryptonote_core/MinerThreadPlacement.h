@@ -0,0 +1,49 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace CryptoNote
+{
+  struct LogicalCpu {
+    uint32_t cpu;
+    uint32_t core;
+    uint32_t package;
+  };
+
+  enum class MinerThreadPriority {
+    NORMAL,
+    LOW,
+    IDLE
+  };
+
+  // Logical CPUs with their physical core and package. Where the topology is unknown every CPU is reported as
+  // a separate core of package 0.
+  std::vector<LogicalCpu> detectCpuTopology();
+  // One CPU of every physical core first, round robin over the packages, then the SMT siblings in the same order
+  std::vector<uint32_t> spreadOverPhysicalCores(const std::vector<LogicalCpu>& cpus);
+  // parses lists like "0-3,8,10"
+  bool parseCpuList(const std::string& list, std::vector<uint32_t>& cpus);
+  bool parseMinerThreadPriority(const std::string& name, MinerThreadPriority& priority);
+
+  bool setCurrentThreadAffinity(uint32_t cpu);
+  bool setCurrentThreadPriority(MinerThreadPriority priority);
+}
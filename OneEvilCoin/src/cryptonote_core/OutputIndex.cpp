@@ -0,0 +1,62 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "OutputIndex.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace CryptoNote
+{
+  size_t OutputIndex::push(uint64_t amount, uint32_t block, uint16_t transaction, uint16_t output, const crypto::public_key& key, uint64_t unlockTime) {
+    AmountOutputs& amountOutputs = m_outputs[amount];
+    assert(amountOutputs.outputs.empty() || amountOutputs.outputs.back().block <= block);
+    Output entry = { block, transaction, output };
+    amountOutputs.outputs.push_back(entry);
+    OutputKey outputKey = { key, unlockTime };
+    amountOutputs.keys.push_back(outputKey);
+    return amountOutputs.outputs.size() - 1;
+  }
+
+  void OutputIndex::pop(uint64_t amount) {
+    auto it = m_outputs.find(amount);
+    assert(it != m_outputs.end() && !it->second.outputs.empty());
+    it->second.outputs.pop_back();
+    it->second.keys.pop_back();
+    if (it->second.outputs.empty()) {
+      m_outputs.erase(it);
+    }
+  }
+
+  void OutputIndex::clear() {
+    m_outputs.clear();
+  }
+
+  size_t OutputIndex::countUpToBlock(uint64_t amount, uint64_t maxBlock) const {
+    auto it = m_outputs.find(amount);
+    if (it == m_outputs.end()) {
+      return 0;
+    }
+
+    const Outputs& outputs = it->second.outputs;
+    auto bound = std::upper_bound(outputs.begin(), outputs.end(), maxBlock, [](uint64_t block, const Output& output) {
+      return block < output.block;
+    });
+
+    return std::distance(outputs.begin(), bound);
+  }
+}
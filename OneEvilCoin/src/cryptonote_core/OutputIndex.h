@@ -0,0 +1,109 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "crypto/crypto.h"
+
+namespace CryptoNote
+{
+  // Global index of key outputs: for every amount, the outputs with this amount in the order they appear in the blockchain.
+  // Entries are packed into 8 bytes and stored contiguously per amount, so appending and popping are O(1) and
+  // entries of the same amount are always sorted by block.
+  // Public key and unlock time of every output are kept in a parallel column, so that ring members can be
+  // resolved without loading the blocks that contain them.
+  class OutputIndex {
+
+  public:
+
+    struct Output {
+      uint32_t block;
+      uint16_t transaction;
+      uint16_t output;
+
+      template <class Archive> void serialize(Archive& ar, const unsigned int version) {
+        ar & block;
+        ar & transaction;
+        ar & output;
+      }
+    };
+
+    struct OutputKey {
+      crypto::public_key key;
+      uint64_t unlockTime;
+
+      template <class Archive> void serialize(Archive& ar, const unsigned int version) {
+        ar & key;
+        ar & unlockTime;
+      }
+    };
+
+    typedef std::vector<Output> Outputs;
+    typedef std::vector<OutputKey> OutputKeys;
+
+    struct AmountOutputs {
+      Outputs outputs;
+      OutputKeys keys;
+
+      template <class Archive> void serialize(Archive& ar, const unsigned int version) {
+        ar & outputs;
+        ar & keys;
+      }
+    };
+
+    typedef std::unordered_map<uint64_t, AmountOutputs> Container;
+    typedef Container::const_iterator const_iterator;
+
+    // returns global index of the new output among outputs with the same amount
+    size_t push(uint64_t amount, uint32_t block, uint16_t transaction, uint16_t output, const crypto::public_key& key, uint64_t unlockTime);
+    // removes the last output with given amount, the amount must have outputs
+    void pop(uint64_t amount);
+    void clear();
+
+    // returns nullptr if there are no outputs with given amount
+    const AmountOutputs* find(uint64_t amount) const {
+      auto it = m_outputs.find(amount);
+      return it == m_outputs.end() ? nullptr : &it->second;
+    }
+
+    // returns number of outputs with given amount that belong to blocks at or below maxBlock,
+    // these outputs form a prefix of the amount outputs
+    size_t countUpToBlock(uint64_t amount, uint64_t maxBlock) const;
+
+    const_iterator begin() const {
+      return m_outputs.begin();
+    }
+
+    const_iterator end() const {
+      return m_outputs.end();
+    }
+
+    template <class Archive> void serialize(Archive& ar, const unsigned int version) {
+      ar & m_outputs;
+    }
+
+  private:
+
+    Container m_outputs;
+
+  };
+}
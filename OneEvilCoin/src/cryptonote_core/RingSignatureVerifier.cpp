@@ -0,0 +1,139 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "RingSignatureVerifier.h"
+
+#include <algorithm>
+
+namespace CryptoNote
+{
+  namespace {
+    // Batches with fewer checks are verified by the calling thread alone, waking workers would cost more
+    const size_t MIN_PARALLEL_CHECKS = 4;
+
+    bool checkRingSignature(const RingSignatureVerifier::Check& check) {
+      std::vector<const crypto::public_key*> keys;
+      keys.reserve(check.keys.size());
+      for (const crypto::public_key& key : check.keys) {
+        keys.push_back(&key);
+      }
+
+      return check.signatures.size() == keys.size() && crypto::check_ring_signature(check.prefixHash, check.keyImage, keys, check.signatures.data());
+    }
+  }
+
+  RingSignatureVerifier::RingSignatureVerifier(size_t workerCount) : m_stopped(false) {
+    for (size_t i = 0; i < workerCount; ++i) {
+      m_workers.emplace_back(&RingSignatureVerifier::workerLoop, this);
+    }
+  }
+
+  RingSignatureVerifier::~RingSignatureVerifier() {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_stopped = true;
+      m_batchQueued.notify_all();
+    }
+
+    for (std::thread& worker : m_workers) {
+      worker.join();
+    }
+  }
+
+  bool RingSignatureVerifier::verify(const std::vector<Check>& checks) {
+    if (m_workers.empty() || checks.size() < MIN_PARALLEL_CHECKS) {
+      for (const Check& check : checks) {
+        if (!checkRingSignature(check)) {
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+    Batch batch;
+    batch.checks = &checks;
+    batch.nextCheck = 0;
+    batch.failed = false;
+    batch.activeWorkers = 0;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_batches.push_back(&batch);
+      m_batchQueued.notify_all();
+    }
+
+    runChecks(batch);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto it = std::find(m_batches.begin(), m_batches.end(), &batch);
+    if (it != m_batches.end()) {
+      m_batches.erase(it);
+    }
+
+    while (batch.activeWorkers != 0) {
+      m_batchFinished.wait(lock);
+    }
+
+    return !batch.failed;
+  }
+
+  void RingSignatureVerifier::workerLoop() {
+    for (;;) {
+      Batch* batch;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stopped && m_batches.empty()) {
+          m_batchQueued.wait(lock);
+        }
+
+        if (m_stopped) {
+          return;
+        }
+
+        batch = m_batches.front();
+        ++batch->activeWorkers;
+      }
+
+      runChecks(*batch);
+
+      std::unique_lock<std::mutex> lock(m_mutex);
+      // a worker runs out of checks only when the batch has none left to hand out
+      auto it = std::find(m_batches.begin(), m_batches.end(), batch);
+      if (it != m_batches.end()) {
+        m_batches.erase(it);
+      }
+
+      if (--batch->activeWorkers == 0) {
+        m_batchFinished.notify_all();
+      }
+    }
+  }
+
+  void RingSignatureVerifier::runChecks(Batch& batch) {
+    const std::vector<Check>& checks = *batch.checks;
+    while (!batch.failed) {
+      size_t index = batch.nextCheck++;
+      if (index >= checks.size()) {
+        break;
+      }
+
+      if (!checkRingSignature(checks[index])) {
+        batch.failed = true;
+      }
+    }
+  }
+}
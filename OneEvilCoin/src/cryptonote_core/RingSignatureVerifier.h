@@ -0,0 +1,77 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+
+namespace CryptoNote
+{
+  // Fixed pool of worker threads that verifies batches of ring signatures in parallel.
+  // The calling thread takes part in verification, so a pool without workers verifies sequentially. Batches of
+  // concurrent callers are queued, idle workers help with the oldest one.
+  class RingSignatureVerifier {
+
+  public:
+
+    struct Check {
+      crypto::hash prefixHash;
+      crypto::key_image keyImage;
+      std::vector<crypto::public_key> keys;
+      std::vector<crypto::signature> signatures;
+    };
+
+    explicit RingSignatureVerifier(size_t workerCount);
+    ~RingSignatureVerifier();
+
+    RingSignatureVerifier(const RingSignatureVerifier&) = delete;
+    RingSignatureVerifier& operator=(const RingSignatureVerifier&) = delete;
+
+    // returns true if all signatures are valid
+    bool verify(const std::vector<Check>& checks);
+
+  private:
+
+    struct Batch {
+      const std::vector<Check>* checks;
+      std::atomic<size_t> nextCheck;
+      std::atomic<bool> failed;
+      // workers verifying the batch, guarded by m_mutex
+      size_t activeWorkers;
+    };
+
+    void workerLoop();
+    static void runChecks(Batch& batch);
+
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_mutex;
+    std::condition_variable m_batchQueued;
+    std::condition_variable m_batchFinished;
+    std::deque<Batch*> m_batches;
+    bool m_stopped;
+
+  };
+}
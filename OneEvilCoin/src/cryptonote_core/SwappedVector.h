@@ -17,26 +17,46 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
+#include <boost/filesystem/operations.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include "serialization/binary_archive.h"
 
+// Items are appended to the items file through std::fstream, while reads go through a read-only
+// memory mapping of that file (unless disabled in open()), so a cache miss is parsed straight from
+// the mapped bytes and the serialized form of any item can be obtained without copying. With mapping
+// enabled the items file is extended ahead of the items in geometrically growing steps, so appending
+// remaps only when that capacity runs out; bytes past the logical end are ignored on open.
 template<class T> class SwappedVector {
 public:
   typedef T value_type;
+  // Cached items are shared with the readers holding them, so an item evicted from the cache by another
+  // reader stays alive until the last reader releases it.
+  typedef std::shared_ptr<const T> ItemPtr;
+
+  // Serialized bytes of a single item inside the mapped items file.
+  struct ItemSpan {
+    const char* data;
+    size_t size;
+  };
 
   class const_iterator {
   public:
     typedef ptrdiff_t difference_type;
     typedef std::random_access_iterator_tag iterator_category;
-    typedef const T* pointer;
-    typedef const T& reference;
+    typedef ItemPtr pointer;
+    typedef ItemPtr reference;
     typedef T value_type;
 
     const_iterator() {
@@ -117,15 +137,15 @@ public:
       return const_iterator(m_swappedVector, m_index - n);
     }
 
-    const T& operator*() const {
+    ItemPtr operator*() const {
       return (*m_swappedVector)[m_index];
     }
 
-    const T* operator->() const {
-      return &(*m_swappedVector)[m_index];
+    ItemPtr operator->() const {
+      return (*m_swappedVector)[m_index];
     }
 
-    const T& operator[](difference_type offset) const {
+    ItemPtr operator[](difference_type offset) const {
       return (*m_swappedVector)[m_index + offset];
     }
 
@@ -143,16 +163,25 @@ public:
   ~SwappedVector();
   //SwappedVector& operator=(const SwappedVector&) = delete;
 
-  bool open(const std::string& itemFileName, const std::string& indexFileName, size_t poolSize);
+  bool open(const std::string& itemFileName, const std::string& indexFileName, size_t poolSize, bool useMapping = true);
   void close();
 
   bool empty() const;
   uint64_t size() const;
+  // Number of items read from the items file, each one deserialized
+  uint64_t cacheMisses() const {
+    return m_cacheMisses;
+  }
+
   const_iterator begin();
   const_iterator end();
-  const T& operator[](uint64_t index);
-  const T& front();
-  const T& back();
+  // Safe to call from several threads at once as long as nothing modifies the vector concurrently.
+  ItemPtr operator[](uint64_t index);
+  // Same thread safety as operator[]. The span stays valid until the next modification of the vector.
+  // Requires the vector to be opened with useMapping.
+  ItemSpan itemSpan(uint64_t index);
+  ItemPtr front();
+  ItemPtr back();
   void clear();
   void pop_back();
   void push_back(const T& item);
@@ -163,7 +192,7 @@ private:
 
   struct ItemEntry {
   public:
-    T item;
+    ItemPtr item;
     typename std::list<CacheEntry>::iterator cacheIter;
   };
 
@@ -172,17 +201,49 @@ private:
     typename std::map<uint64_t, ItemEntry>::iterator itemIter;
   };
 
+  class MemoryBuffer : public std::streambuf {
+  public:
+    MemoryBuffer(const char* data, size_t size) {
+      char* begin = const_cast<char*>(data);
+      setg(begin, begin, begin + size);
+    }
+
+  protected:
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode mode) override {
+      char* base = direction == std::ios_base::beg ? eback() : direction == std::ios_base::cur ? gptr() : egptr();
+      if ((mode & std::ios_base::in) == 0 || offset < eback() - base || offset > egptr() - base) {
+        return pos_type(off_type(-1));
+      }
+
+      setg(eback(), base + offset, egptr());
+      return pos_type(gptr() - eback());
+    }
+
+    pos_type seekpos(pos_type position, std::ios_base::openmode mode) override {
+      return seekoff(off_type(position), std::ios_base::beg, mode);
+    }
+  };
+
+  std::mutex m_mutex;
+  std::string m_itemsFileName;
   std::fstream m_itemsFile;
+  bool m_useMapping;
+  boost::interprocess::file_mapping m_itemsMapping;
+  boost::interprocess::mapped_region m_itemsRegion;
   std::fstream m_indexesFile;
   size_t m_poolSize;
   std::vector<uint64_t> m_offsets;
   uint64_t m_itemsFileSize;
+  uint64_t m_itemsCapacity;
   std::map<uint64_t, ItemEntry> m_items;
   std::list<CacheEntry> m_cache;
   uint64_t m_cacheHits;
   uint64_t m_cacheMisses;
 
-  T* prepare(uint64_t index);
+  ItemPtr& prepare(uint64_t index);
+  void reserve(uint64_t size);
+  void remap();
+  ItemSpan getItemSpan(uint64_t index) const;
 };
 
 template<class T> SwappedVector<T>::SwappedVector() {
@@ -192,7 +253,7 @@ template<class T> SwappedVector<T>::~SwappedVector() {
   close();
 }
 
-template<class T> bool SwappedVector<T>::open(const std::string& itemFileName, const std::string& indexFileName, size_t poolSize) {
+template<class T> bool SwappedVector<T>::open(const std::string& itemFileName, const std::string& indexFileName, size_t poolSize, bool useMapping) {
   if (poolSize == 0) {
     return false;
   }
@@ -219,8 +280,14 @@ template<class T> bool SwappedVector<T>::open(const std::string& itemFileName, c
       itemsFileSize += itemSize;
     }
 
+    m_itemsFile.seekg(0, std::ios::end);
+    if (!m_itemsFile || static_cast<uint64_t>(m_itemsFile.tellg()) < itemsFileSize) {
+      return false;
+    }
+
     m_offsets.swap(offsets);
     m_itemsFileSize = itemsFileSize;
+    m_itemsCapacity = m_itemsFile.tellg();
   } else {
     m_itemsFile.open(itemFileName, std::ios::out | std::ios::binary);
     m_itemsFile.close();
@@ -236,6 +303,19 @@ template<class T> bool SwappedVector<T>::open(const std::string& itemFileName, c
     m_indexesFile.open(indexFileName, std::ios::in | std::ios::out | std::ios::binary);
     m_offsets.clear();
     m_itemsFileSize = 0;
+    m_itemsCapacity = 0;
+  }
+
+  m_itemsFileName = itemFileName;
+  m_useMapping = useMapping;
+  m_itemsRegion = boost::interprocess::mapped_region();
+  if (m_useMapping) {
+    try {
+      m_itemsMapping = boost::interprocess::file_mapping(itemFileName.c_str(), boost::interprocess::read_only);
+      remap();
+    } catch (std::exception&) {
+      return false;
+    }
   }
 
   m_poolSize = poolSize;
@@ -266,7 +346,8 @@ template<class T> typename SwappedVector<T>::const_iterator SwappedVector<T>::en
   return const_iterator(this, m_offsets.size());
 }
 
-template<class T> const T& SwappedVector<T>::operator[](uint64_t index) {
+template<class T> typename SwappedVector<T>::ItemPtr SwappedVector<T>::operator[](uint64_t index) {
+  std::lock_guard<std::mutex> lock(m_mutex);
   auto itemIter = m_items.find(index);
   if (itemIter != m_items.end()) {
     if (itemIter->second.cacheIter != --m_cache.end()) {
@@ -281,32 +362,52 @@ template<class T> const T& SwappedVector<T>::operator[](uint64_t index) {
     throw std::runtime_error("SwappedVector::operator[]");
   }
 
-  if (!m_itemsFile) {
-    throw std::runtime_error("SwappedVector::operator[]");
-  }
+  std::shared_ptr<T> tempItem = std::make_shared<T>();
+  if (m_useMapping) {
+    ItemSpan span = getItemSpan(index);
+    MemoryBuffer buffer(span.data, span.size);
+    std::istream stream(&buffer);
+    binary_archive<false> archive(stream);
+    if (!do_serialize(archive, *tempItem)) {
+      throw std::runtime_error("SwappedVector::operator[]");
+    }
+  } else {
+    if (!m_itemsFile) {
+      throw std::runtime_error("SwappedVector::operator[]");
+    }
 
-  m_itemsFile.seekg(m_offsets[index]);
-  T tempItem;
-  binary_archive<false> archive(m_itemsFile);
-  if (!do_serialize(archive, tempItem)) {
-    throw std::runtime_error("SwappedVector::operator[]");
+    m_itemsFile.seekg(m_offsets[index]);
+    binary_archive<false> archive(m_itemsFile);
+    if (!do_serialize(archive, *tempItem)) {
+      throw std::runtime_error("SwappedVector::operator[]");
+    }
   }
 
-  T* item = prepare(index);
-  std::swap(tempItem, *item);
+  ItemPtr& item = prepare(index);
+  item = std::move(tempItem);
   ++m_cacheMisses;
-  return *item;
+  return item;
 }
 
-template<class T> const T& SwappedVector<T>::front() {
+template<class T> typename SwappedVector<T>::ItemSpan SwappedVector<T>::itemSpan(uint64_t index) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_useMapping || index >= m_offsets.size()) {
+    throw std::runtime_error("SwappedVector::itemSpan");
+  }
+
+  return getItemSpan(index);
+}
+
+template<class T> typename SwappedVector<T>::ItemPtr SwappedVector<T>::front() {
   return operator[](0);
 }
 
-template<class T> const T& SwappedVector<T>::back() {
+template<class T> typename SwappedVector<T>::ItemPtr SwappedVector<T>::back() {
   return operator[](m_offsets.size() - 1);
 }
 
 template<class T> void SwappedVector<T>::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
   if (!m_indexesFile) {
     throw std::runtime_error("SwappedVector::clear");
   }
@@ -325,6 +426,7 @@ template<class T> void SwappedVector<T>::clear() {
 }
 
 template<class T> void SwappedVector<T>::pop_back() {
+  std::lock_guard<std::mutex> lock(m_mutex);
   if (!m_indexesFile) {
     throw std::runtime_error("SwappedVector::pop_back");
   }
@@ -346,6 +448,7 @@ template<class T> void SwappedVector<T>::pop_back() {
 }
 
 template<class T> void SwappedVector<T>::push_back(const T& item) {
+  std::lock_guard<std::mutex> lock(m_mutex);
   uint64_t itemsFileSize;
 
   {
@@ -360,6 +463,9 @@ template<class T> void SwappedVector<T>::push_back(const T& item) {
     }
 
     itemsFileSize = m_itemsFile.tellp();
+    if (m_useMapping && !m_itemsFile.flush()) {
+      throw std::runtime_error("SwappedVector::push_back");
+    }
   }
 
   {
@@ -384,12 +490,14 @@ template<class T> void SwappedVector<T>::push_back(const T& item) {
 
   m_offsets.push_back(m_itemsFileSize);
   m_itemsFileSize = itemsFileSize;
+  if (m_useMapping && m_itemsFileSize > m_itemsCapacity) {
+    reserve(m_itemsFileSize);
+  }
 
-  T* newItem = prepare(m_offsets.size() - 1);
-  *newItem = item;
+  prepare(m_offsets.size() - 1) = std::make_shared<T>(item);
 }
 
-template<class T> T* SwappedVector<T>::prepare(uint64_t index) {
+template<class T> typename SwappedVector<T>::ItemPtr& SwappedVector<T>::prepare(uint64_t index) {
   if (m_items.size() == m_poolSize) {
     auto cacheIter = m_cache.begin();
     m_items.erase(cacheIter->itemIter);
@@ -400,5 +508,31 @@ template<class T> T* SwappedVector<T>::prepare(uint64_t index) {
   CacheEntry cacheEntry = { itemIter.first };
   auto cacheIter = m_cache.insert(m_cache.end(), cacheEntry);
   itemIter.first->second.cacheIter = cacheIter;
-  return &itemIter.first->second.item;
+  return itemIter.first->second.item;
+}
+
+template<class T> void SwappedVector<T>::reserve(uint64_t size) {
+  const uint64_t minCapacity = 1 << 20;
+  uint64_t capacity = std::max(std::max(size, m_itemsCapacity * 2), minCapacity);
+  try {
+    boost::filesystem::resize_file(m_itemsFileName, capacity);
+    m_itemsCapacity = capacity;
+    remap();
+  } catch (std::exception&) {
+    throw std::runtime_error("SwappedVector::push_back");
+  }
+}
+
+template<class T> void SwappedVector<T>::remap() {
+  if (m_itemsCapacity == 0) {
+    m_itemsRegion = boost::interprocess::mapped_region();
+  } else {
+    m_itemsRegion = boost::interprocess::mapped_region(m_itemsMapping, boost::interprocess::read_only, 0, m_itemsCapacity);
+  }
+}
+
+template<class T> typename SwappedVector<T>::ItemSpan SwappedVector<T>::getItemSpan(uint64_t index) const {
+  uint64_t end = index + 1 < m_offsets.size() ? m_offsets[index + 1] : m_itemsFileSize;
+  ItemSpan span = { static_cast<const char*>(m_itemsRegion.get_address()) + m_offsets[index], static_cast<size_t>(end - m_offsets[index]) };
+  return span;
 }
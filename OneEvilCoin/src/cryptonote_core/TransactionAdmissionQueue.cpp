@@ -0,0 +1,108 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "TransactionAdmissionQueue.h"
+
+#include "misc_log_ex.h"
+
+namespace CryptoNote
+{
+  TransactionAdmissionQueue::TransactionAdmissionQueue(size_t workerCount, size_t maxPendingBatches, size_t maxPeerPendingBatches) :
+    m_maxPendingBatches(maxPendingBatches),
+    m_maxPeerPendingBatches(maxPeerPendingBatches),
+    m_stopped(false) {
+    for (size_t i = 0; i < workerCount; ++i) {
+      m_workers.emplace_back(&TransactionAdmissionQueue::workerLoop, this);
+    }
+  }
+
+  TransactionAdmissionQueue::~TransactionAdmissionQueue() {
+    stop();
+  }
+
+  bool TransactionAdmissionQueue::push(const PeerId& peer, Batch&& batch) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_stopped || m_batches.size() >= m_maxPendingBatches) {
+      return false;
+    }
+
+    size_t& peerPending = m_peerPendingBatches[peer];
+    if (peerPending >= m_maxPeerPendingBatches) {
+      return false;
+    }
+
+    ++peerPending;
+    m_batches.push_back(PendingBatch{peer, std::move(batch)});
+    m_haveBatches.notify_one();
+    return true;
+  }
+
+  void TransactionAdmissionQueue::stop() {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_stopped = true;
+      while (!m_batches.empty()) {
+        releasePeerBatch(m_batches.front().peer);
+        m_batches.pop_front();
+      }
+
+      m_haveBatches.notify_all();
+    }
+
+    for (std::thread& worker : m_workers) {
+      if (worker.joinable()) {
+        worker.join();
+      }
+    }
+  }
+
+  void TransactionAdmissionQueue::workerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+      while (m_batches.empty() && !m_stopped) {
+        m_haveBatches.wait(lock);
+      }
+
+      if (m_stopped) {
+        return;
+      }
+
+      PendingBatch pending = std::move(m_batches.front());
+      m_batches.pop_front();
+
+      lock.unlock();
+      try {
+        pending.batch();
+      } catch (std::exception& e) {
+        LOG_ERROR("Transaction admission batch failed: " << e.what());
+      } catch (...) {
+        LOG_ERROR("Transaction admission batch failed with unknown exception");
+      }
+      lock.lock();
+
+      // the peer's batch counts against its limit until it's processed
+      releasePeerBatch(pending.peer);
+    }
+  }
+
+  void TransactionAdmissionQueue::releasePeerBatch(const PeerId& peer) {
+    auto it = m_peerPendingBatches.find(peer);
+    if (--it->second == 0) {
+      m_peerPendingBatches.erase(it);
+    }
+  }
+}
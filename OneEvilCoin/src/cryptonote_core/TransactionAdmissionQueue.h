@@ -0,0 +1,74 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/uuid/uuid.hpp>
+
+namespace CryptoNote
+{
+  // Worker threads that admit relayed transactions into the pool off the network threads. push() never blocks: a batch
+  // is rejected while maxPendingBatches batches are waiting or maxPeerPendingBatches batches of the same peer are
+  // waiting or running, so a flooding peer loses its own batches without slowing the other peers down.
+  // stop() waits for the running batches and drops the waiting ones.
+  class TransactionAdmissionQueue {
+
+  public:
+
+    typedef boost::uuids::uuid PeerId;
+    typedef std::function<void()> Batch;
+
+    TransactionAdmissionQueue(size_t workerCount, size_t maxPendingBatches, size_t maxPeerPendingBatches);
+    ~TransactionAdmissionQueue();
+
+    TransactionAdmissionQueue(const TransactionAdmissionQueue&) = delete;
+    TransactionAdmissionQueue& operator=(const TransactionAdmissionQueue&) = delete;
+
+    // returns false if the queue is stopped or the batch is rejected
+    bool push(const PeerId& peer, Batch&& batch);
+    void stop();
+
+  private:
+
+    struct PendingBatch {
+      PeerId peer;
+      Batch batch;
+    };
+
+    void workerLoop();
+    void releasePeerBatch(const PeerId& peer);
+
+    const size_t m_maxPendingBatches;
+    const size_t m_maxPeerPendingBatches;
+
+    std::mutex m_mutex;
+    std::condition_variable m_haveBatches;
+    std::deque<PendingBatch> m_batches;
+    std::map<PeerId, size_t> m_peerPendingBatches;
+    bool m_stopped;
+    std::vector<std::thread> m_workers;
+
+  };
+}
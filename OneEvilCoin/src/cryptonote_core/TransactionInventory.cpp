@@ -0,0 +1,173 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "TransactionInventory.h"
+
+#include <algorithm>
+
+namespace {
+  // Other peers announcing a requested transaction remembered, to request it from them when the request expires
+  const size_t MAX_ANNOUNCERS = 8;
+}
+
+namespace CryptoNote
+{
+  TransactionInventory::TransactionInventory(size_t knownLimit, size_t queueLimit, std::chrono::seconds requestTimeout, size_t servedPerSecond) :
+    m_knownLimit(knownLimit), m_queueLimit(queueLimit), m_requestTimeout(requestTimeout), m_servedPerSecond(servedPerSecond) {
+  }
+
+  void TransactionInventory::addKnown(const PeerId& peer, const std::vector<crypto::hash>& ids) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Peer& state = getPeer(peer);
+    for (const crypto::hash& id : ids) {
+      addKnown(state, id);
+    }
+  }
+
+  void TransactionInventory::queue(const PeerId& peer, const std::vector<crypto::hash>& ids) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Peer& state = getPeer(peer);
+    for (const crypto::hash& id : ids) {
+      if (addKnown(state, id)) {
+        state.queued.push_back(id);
+      }
+    }
+
+    // a peer that doesn't take the announcements as fast as they come misses the oldest ones
+    while (state.queued.size() > m_queueLimit) {
+      state.queued.pop_front();
+    }
+  }
+  std::vector<crypto::hash> TransactionInventory::takeQueued(const PeerId& peer, size_t maxCount) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<crypto::hash> ids;
+    auto it = m_peers.find(peer);
+    if (it == m_peers.end()) {
+      return ids;
+    }
+
+    std::deque<crypto::hash>& queued = it->second.queued;
+    size_t count = std::min(maxCount, queued.size());
+    ids.assign(queued.begin(), queued.begin() + count);
+    queued.erase(queued.begin(), queued.begin() + count);
+    return ids;
+  }
+
+  void TransactionInventory::removePeer(const PeerId& peer) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_peers.erase(peer);
+  }
+
+  std::vector<crypto::hash> TransactionInventory::startRequests(const PeerId& peer, const std::vector<crypto::hash>& ids) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto now = std::chrono::steady_clock::now();
+    std::vector<crypto::hash> requested;
+    for (const crypto::hash& id : ids) {
+      auto it = m_requests.find(id);
+      if (it == m_requests.end()) {
+        Request& request = m_requests[id];
+        request.peer = peer;
+        request.time = now;
+        requested.push_back(id);
+      } else if (now - it->second.time >= m_requestTimeout) {
+        it->second.peer = peer;
+        it->second.time = now;
+        requested.push_back(id);
+      } else if (it->second.peer != peer && it->second.announcers.size() < MAX_ANNOUNCERS &&
+        std::find(it->second.announcers.begin(), it->second.announcers.end(), peer) == it->second.announcers.end()) {
+        it->second.announcers.push_back(peer);
+      }
+    }
+
+    return requested;
+  }
+
+  void TransactionInventory::finishRequests(const std::vector<crypto::hash>& ids) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const crypto::hash& id : ids) {
+      m_requests.erase(id);
+    }
+  }
+
+  std::map<TransactionInventory::PeerId, std::vector<crypto::hash>> TransactionInventory::expireRequests() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto now = std::chrono::steady_clock::now();
+    std::map<PeerId, std::vector<crypto::hash>> requests;
+    for (auto it = m_requests.begin(); it != m_requests.end();) {
+      Request& request = it->second;
+      if (now - request.time < m_requestTimeout) {
+        ++it;
+        continue;
+      }
+
+      // announcers that disconnected meanwhile are skipped
+      while (!request.announcers.empty() && m_peers.count(request.announcers.front()) == 0) {
+        request.announcers.pop_front();
+      }
+
+      if (request.announcers.empty()) {
+        it = m_requests.erase(it);
+      } else {
+        request.peer = request.announcers.front();
+        request.time = now;
+        request.announcers.pop_front();
+        requests[request.peer].push_back(it->first);
+        ++it;
+      }
+    }
+
+    return requests;
+  }
+
+  size_t TransactionInventory::takeServed(const PeerId& peer, size_t count) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Peer& state = getPeer(peer);
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - state.servedTime).count();
+    state.servable = std::min(state.servable + elapsed * m_servedPerSecond, 2.0 * m_servedPerSecond);
+    state.servedTime = now;
+
+    size_t served = std::min(count, static_cast<size_t>(state.servable));
+    state.servable -= served;
+    return served;
+  }
+
+  bool TransactionInventory::addKnown(Peer& peer, const crypto::hash& id) {
+    if (!peer.known.insert(id).second) {
+      return false;
+    }
+
+    peer.knownOrder.push_back(id);
+    if (peer.knownOrder.size() > m_knownLimit) {
+      peer.known.erase(peer.knownOrder.front());
+      peer.knownOrder.pop_front();
+    }
+
+    return true;
+  }
+
+  TransactionInventory::Peer& TransactionInventory::getPeer(const PeerId& peer) {
+    auto it = m_peers.find(peer);
+    if (it == m_peers.end()) {
+      it = m_peers.emplace(peer, Peer()).first;
+      it->second.servable = 2.0 * m_servedPerSecond;
+      it->second.servedTime = std::chrono::steady_clock::now();
+    }
+
+    return it->second;
+  }
+}
@@ -0,0 +1,91 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <boost/uuid/uuid.hpp>
+
+#include "crypto/hash.h"
+
+namespace CryptoNote
+{
+  // Tracks which transactions every peer knows, the announcements queued for it and the transactions requested
+  // from peers, so a transaction is announced to a peer and downloaded by this node only once. Other peers announcing
+  // a requested transaction are remembered, it is requested from the next one of them if the request expires.
+  class TransactionInventory {
+
+  public:
+
+    typedef boost::uuids::uuid PeerId;
+
+    TransactionInventory(size_t knownLimit, size_t queueLimit, std::chrono::seconds requestTimeout, size_t servedPerSecond);
+
+    // remembers that the peer has the transactions, the oldest ones are forgotten beyond knownLimit per peer
+    void addKnown(const PeerId& peer, const std::vector<crypto::hash>& ids);
+    // queues announcements of the transactions the peer doesn't know yet, the oldest ones are dropped beyond queueLimit
+    void queue(const PeerId& peer, const std::vector<crypto::hash>& ids);
+    std::vector<crypto::hash> takeQueued(const PeerId& peer, size_t maxCount);
+    void removePeer(const PeerId& peer);
+
+    // returns the transactions the peer announced that aren't requested from any peer within requestTimeout, they
+    // count as requested from it from now on
+    std::vector<crypto::hash> startRequests(const PeerId& peer, const std::vector<crypto::hash>& ids);
+    void finishRequests(const std::vector<crypto::hash>& ids);
+    // returns the transactions to request again from the next peers that announced them, by peer
+    std::map<PeerId, std::vector<crypto::hash>> expireRequests();
+    // returns how many of count requested transactions may be sent to the peer, servedPerSecond on average
+    size_t takeServed(const PeerId& peer, size_t count);
+
+  private:
+
+    struct Peer {
+      std::unordered_set<crypto::hash> known;
+      std::deque<crypto::hash> knownOrder;
+      std::deque<crypto::hash> queued;
+      double servable;
+      std::chrono::steady_clock::time_point servedTime;
+    };
+
+    struct Request {
+      PeerId peer;
+      std::chrono::steady_clock::time_point time;
+      std::deque<PeerId> announcers;
+    };
+
+    bool addKnown(Peer& peer, const crypto::hash& id);
+    Peer& getPeer(const PeerId& peer);
+
+    const size_t m_knownLimit;
+    const size_t m_queueLimit;
+    const std::chrono::seconds m_requestTimeout;
+    const size_t m_servedPerSecond;
+
+    std::mutex m_mutex;
+    std::map<PeerId, Peer> m_peers;
+    std::unordered_map<crypto::hash, Request> m_requests;
+
+  };
+}
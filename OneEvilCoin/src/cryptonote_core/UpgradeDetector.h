@@ -20,6 +20,8 @@
 #include <algorithm>
 #include <cstdint>
 #include <ctime>
+#include <iterator>
+#include <memory>
 
 // epee
 #include "include_base_utils.h"
@@ -52,12 +54,12 @@ namespace cryptonote {
         if (m_blockchain.empty()) {
           m_votingCompleteHeight = UNDEF_HEIGHT;
 
-        } else if (m_targetVersion - 1 == m_blockchain.back().bl.majorVersion) {
+        } else if (m_targetVersion - 1 == blockOf(m_blockchain.back()).majorVersion) {
           m_votingCompleteHeight = findVotingCompleteHeight(m_blockchain.size() - 1);
 
-        } else if (m_targetVersion <= m_blockchain.back().bl.majorVersion) {
+        } else if (m_targetVersion <= blockOf(m_blockchain.back()).majorVersion) {
           auto it = std::lower_bound(m_blockchain.begin(), m_blockchain.end(), m_targetVersion,
-            [](const typename BC::value_type& b, uint8_t v) { return b.bl.majorVersion < v; });
+            [](typename std::iterator_traits<typename BC::const_iterator>::reference b, uint8_t v) { return blockOf(b).majorVersion < v; });
           CHECK_AND_ASSERT_MES(it != m_blockchain.end() && it->bl.majorVersion == m_targetVersion, false,
             "Internal error: upgrade height isn't found");
           uint64_t upgradeHeight = it - m_blockchain.begin();
@@ -70,16 +72,16 @@ namespace cryptonote {
         }
       } else if (!m_blockchain.empty()) {
         if (m_blockchain.size() <= m_currency.upgradeHeight() + 1) {
-          CHECK_AND_ASSERT_MES(m_blockchain.back().bl.majorVersion == m_targetVersion - 1, false,
+          CHECK_AND_ASSERT_MES(blockOf(m_blockchain.back()).majorVersion == m_targetVersion - 1, false,
             "Internal error: block at height " << (m_blockchain.size() - 1) << " has invalid version " <<
-            static_cast<int>(m_blockchain.back().bl.majorVersion) << ", expected " << static_cast<int>(m_targetVersion));
+            static_cast<int>(blockOf(m_blockchain.back()).majorVersion) << ", expected " << static_cast<int>(m_targetVersion));
         } else {
-          int blockVersionAtUpgradeHeight = m_blockchain[m_currency.upgradeHeight()].bl.majorVersion;
+          int blockVersionAtUpgradeHeight = blockOf(m_blockchain[m_currency.upgradeHeight()]).majorVersion;
           CHECK_AND_ASSERT_MES(blockVersionAtUpgradeHeight == m_targetVersion - 1, false,
             "Internal error: block at height " << m_currency.upgradeHeight() << " has invalid version " <<
             blockVersionAtUpgradeHeight << ", expected " << static_cast<int>(m_targetVersion - 1));
 
-          int blockVersionAfterUpgradeHeight = m_blockchain[m_currency.upgradeHeight() + 1].bl.majorVersion;
+          int blockVersionAfterUpgradeHeight = blockOf(m_blockchain[m_currency.upgradeHeight() + 1]).majorVersion;
           CHECK_AND_ASSERT_MES(blockVersionAfterUpgradeHeight == m_targetVersion, false,
             "Internal error: block at height " << (m_currency.upgradeHeight() + 1) << " has invalid version " <<
             blockVersionAfterUpgradeHeight << ", expected " << static_cast<int>(m_targetVersion));
@@ -105,27 +107,27 @@ namespace cryptonote {
 
       if (m_currency.upgradeHeight() != UNDEF_HEIGHT) {
         if (m_blockchain.size() <= m_currency.upgradeHeight() + 1) {
-          assert(m_blockchain.back().bl.majorVersion == m_targetVersion - 1);
+          assert(blockOf(m_blockchain.back()).majorVersion == m_targetVersion - 1);
         } else {
-          assert(m_blockchain.back().bl.majorVersion == m_targetVersion);
+          assert(blockOf(m_blockchain.back()).majorVersion == m_targetVersion);
         }
 
       } else if (m_votingCompleteHeight != UNDEF_HEIGHT) {
         assert(m_blockchain.size() > m_votingCompleteHeight);
 
         if (m_blockchain.size() <= upgradeHeight()) {
-          assert(m_blockchain.back().bl.majorVersion == m_targetVersion - 1);
+          assert(blockOf(m_blockchain.back()).majorVersion == m_targetVersion - 1);
 
           if (m_blockchain.size() % (60 * 60 / m_currency.difficultyTarget()) == 0) {
             LOG_PRINT_GREEN("###### UPGRADE is going to happen after height " << upgradeHeight() << "!", LOG_LEVEL_2);
           }
         } else if (m_blockchain.size() == upgradeHeight() + 1) {
-          assert(m_blockchain.back().bl.majorVersion == m_targetVersion - 1);
+          assert(blockOf(m_blockchain.back()).majorVersion == m_targetVersion - 1);
 
           LOG_PRINT_GREEN("###### UPGRADE has happened! Starting from height " << (upgradeHeight() + 1) <<
             " blocks with major version below " << static_cast<int>(m_targetVersion) << " will be rejected!", LOG_LEVEL_2);
         } else {
-          assert(m_blockchain.back().bl.majorVersion == m_targetVersion);
+          assert(blockOf(m_blockchain.back()).majorVersion == m_targetVersion);
         }
 
       } else {
@@ -152,6 +154,17 @@ namespace cryptonote {
     }
 
   private:
+    // blockchains holding their blocks in shared pointers are supported too
+    template <typename T>
+    static const Block& blockOf(const T& item) {
+      return item.bl;
+    }
+
+    template <typename T>
+    static const Block& blockOf(const std::shared_ptr<T>& item) {
+      return item->bl;
+    }
+
     uint64_t findVotingCompleteHeight(uint64_t probableUpgradeHeight) {
       assert(m_currency.upgradeHeight() == UNDEF_HEIGHT);
 
@@ -177,7 +190,8 @@ namespace cryptonote {
 
       unsigned int voteCounter = 0;
       for (size_t i = height + 1 - m_currency.upgradeVotingWindow(); i <= height; ++i) {
-        const auto& b = m_blockchain[i].bl;
+        const auto& item = m_blockchain[i];
+        const auto& b = blockOf(item);
         voteCounter += (b.majorVersion == m_targetVersion - 1) && (b.minorVersion == BLOCK_MINOR_VERSION_1) ? 1 : 0;
       }
 
@@ -0,0 +1,56 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "VerifiedTransactionCache.h"
+
+namespace CryptoNote
+{
+  VerifiedTransactionCache::VerifiedTransactionCache(size_t capacity) : m_capacity(capacity) {
+  }
+
+  void VerifiedTransactionCache::add(const crypto::hash& transactionHash, const BlockInfo& maxUsedBlock) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto result = m_transactions.insert(std::make_pair(transactionHash, maxUsedBlock));
+    if (!result.second) {
+      result.first->second = maxUsedBlock;
+      return;
+    }
+
+    m_insertionOrder.push_back(transactionHash);
+    if (m_insertionOrder.size() > m_capacity) {
+      m_transactions.erase(m_insertionOrder.front());
+      m_insertionOrder.pop_front();
+    }
+  }
+
+  bool VerifiedTransactionCache::find(const crypto::hash& transactionHash, BlockInfo& maxUsedBlock) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_transactions.find(transactionHash);
+    if (it == m_transactions.end()) {
+      return false;
+    }
+
+    maxUsedBlock = it->second;
+    return true;
+  }
+
+  void VerifiedTransactionCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_transactions.clear();
+    m_insertionOrder.clear();
+  }
+}
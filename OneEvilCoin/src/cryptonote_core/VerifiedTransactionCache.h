@@ -0,0 +1,51 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+#include "crypto/hash.h"
+#include "cryptonote_core/ITransactionValidator.h"
+
+namespace CryptoNote
+{
+  // Bounded cache of transactions whose ring signatures have been verified. Every transaction is stored with
+  // the highest block its ring members belong to: while this block stays in the main chain, the ring members
+  // are the same and the signatures don't need to be verified again. The oldest entries are evicted first.
+  class VerifiedTransactionCache {
+
+  public:
+
+    explicit VerifiedTransactionCache(size_t capacity);
+
+    void add(const crypto::hash& transactionHash, const BlockInfo& maxUsedBlock);
+    // returns false if the transaction is not in the cache
+    bool find(const crypto::hash& transactionHash, BlockInfo& maxUsedBlock) const;
+    void clear();
+
+  private:
+
+    const size_t m_capacity;
+    mutable std::mutex m_mutex;
+    std::unordered_map<crypto::hash, BlockInfo> m_transactions;
+    std::deque<crypto::hash> m_insertionOrder;
+
+  };
+}
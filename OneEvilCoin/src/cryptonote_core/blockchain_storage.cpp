@@ -20,9 +20,11 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <memory>
 
 #include <boost/archive/binary_oarchive.hpp>
 #include <boost/archive/binary_iarchive.hpp>
+#include <boost/filesystem.hpp>
 
 // epee
 #include "file_io_utils.h"
@@ -50,6 +52,16 @@
 //}
 
 namespace {
+  // Number of blocks the cache snapshot may lag behind before it is rewritten
+  const uint64_t CACHE_SNAPSHOT_MAX_LAG = 10000;
+  // The snapshot of a longer chain may lag behind by this part of its height, so rewriting it while a long chain is
+  // downloaded costs time proportional to the chain rather than to its square
+  const uint64_t CACHE_SNAPSHOT_LAG_DIVISOR = 8;
+  // Precomputed long hashes of blocks that never got added are dropped, oldest first, once there are more than this
+  const size_t MAX_PRECOMPUTED_LONG_HASHES = 10000;
+  // Number of transactions with verified ring signatures remembered, enough to cover a full transaction pool
+  const size_t VERIFIED_TRANSACTIONS_CACHE_SIZE = 20000;
+
   std::string appendPath(const std::string& path, const std::string& fileName) {
     std::string result = path;
     if (!result.empty()) {
@@ -139,7 +151,7 @@ namespace cryptonote {
 #define CURRENT_BLOCKCHAIN_STORAGE_ARCHIVE_VER    13
 
   template<class archive_t> void blockchain_storage::serialize(archive_t & ar, const unsigned int version) {
-    CRITICAL_REGION_LOCAL(m_blockchain_lock);
+    EXCLUSIVE_CRITICAL_REGION_LOCAL(m_blockchain_lock);
     if (version < 12) {
       LOG_PRINT_L0("Detected blockchain of unsupported version, migration is not possible.");
       return;
@@ -218,13 +230,32 @@ BOOST_CLASS_VERSION(cryptonote::blockchain_storage, CURRENT_BLOCKCHAIN_STORAGE_A
 namespace cryptonote
 {
 
-#define CURRENT_BLOCKCACHE_STORAGE_ARCHIVE_VER 1
+#define CURRENT_BLOCKCACHE_STORAGE_ARCHIVE_VER 5
 
   class BlockCacheSerializer {
 
   public:
-    BlockCacheSerializer(blockchain_storage& bs, const crypto::hash lastBlockHash) :
-      m_bs(bs), m_lastBlockHash(lastBlockHash), m_loaded(false) {}
+    // The loaded snapshot may be behind or ahead of the stored blocks, init() reconciles them
+    explicit BlockCacheSerializer(blockchain_storage& bs) :
+      m_blockIndex(bs.m_blockIndex),
+      m_blockHeaders(bs.m_blockHeaders),
+      m_blockBlobs(bs.m_blockBlobs),
+      m_transactionMap(bs.m_transactionMap),
+      m_spentKeys(bs.m_spent_keys),
+      m_outputs(bs.m_outputs),
+      m_multisignatureOutputs(bs.m_multisignatureOutputs),
+      m_loaded(false) {}
+
+    BlockCacheSerializer(blockchain_storage& bs, const crypto::hash& lastBlockHash) :
+      m_blockIndex(bs.m_blockIndex),
+      m_blockHeaders(bs.m_blockHeaders),
+      m_blockBlobs(bs.m_blockBlobs),
+      m_transactionMap(bs.m_transactionMap),
+      m_spentKeys(bs.m_spent_keys),
+      m_outputs(bs.m_outputs),
+      m_multisignatureOutputs(bs.m_multisignatureOutputs),
+      m_lastBlockHash(lastBlockHash),
+      m_loaded(false) {}
 
     template<class Archive> void serialize(Archive& ar, unsigned int version) {
 
@@ -232,35 +263,29 @@ namespace cryptonote
       if (version < CURRENT_BLOCKCACHE_STORAGE_ARCHIVE_VER)
         return;
 
-      std::string operation;
-      if (Archive::is_loading::value) {
-        operation = "- loading ";
-        crypto::hash blockHash;
-        ar & blockHash;
+      std::string operation = Archive::is_loading::value ? "- loading " : "- saving ";
+      ar & m_lastBlockHash;
 
-        if (blockHash != m_lastBlockHash) {
-          return;
-        }
+      LOG_PRINT_L0(operation << "block index...");
+      ar & m_blockIndex;
 
-      } else {
-        operation = "- saving ";
-        ar & m_lastBlockHash;
-      }
+      LOG_PRINT_L0(operation << "block headers...");
+      ar & m_blockHeaders;
 
-      LOG_PRINT_L0(operation << "block index...");
-      ar & m_bs.m_blockIndex;
+      LOG_PRINT_L0(operation << "block blob index...");
+      ar & m_blockBlobs;
 
       LOG_PRINT_L0(operation << "transaction map...");
-      ar & m_bs.m_transactionMap;
+      ar & m_transactionMap;
 
       LOG_PRINT_L0(operation << "spend keys...");
-      ar & m_bs.m_spent_keys;
+      ar & m_spentKeys;
 
       LOG_PRINT_L0(operation << "outputs...");
-      ar & m_bs.m_outputs;
+      ar & m_outputs;
 
       LOG_PRINT_L0(operation << "multi-signature outputs...");
-      ar & m_bs.m_multisignatureOutputs;
+      ar & m_multisignatureOutputs;
 
       m_loaded = true;
     }
@@ -271,9 +296,15 @@ namespace cryptonote
 
   private:
 
-    bool m_loaded;
-    blockchain_storage& m_bs;
+    CryptoNote::BlockIndex& m_blockIndex;
+    CryptoNote::BlockHeaderCache& m_blockHeaders;
+    CryptoNote::BlockBlobIndex& m_blockBlobs;
+    blockchain_storage::TransactionMap& m_transactionMap;
+    blockchain_storage::key_images_container& m_spentKeys;
+    CryptoNote::OutputIndex& m_outputs;
+    blockchain_storage::MultisignatureOutputsContainer& m_multisignatureOutputs;
     crypto::hash m_lastBlockHash;
+    bool m_loaded;
   };
 }
 
@@ -286,8 +317,11 @@ blockchain_storage::blockchain_storage(const Currency& currency, tx_memory_pool&
       m_current_block_cumul_sz_limit(0),
       m_is_in_checkpoint_zone(false),
       m_is_blockchain_storing(false),
-      m_upgradeDetector(currency, m_blocks, BLOCK_MAJOR_VERSION_2) {
-  m_outputs.set_deleted_key(0);
+      m_cacheSnapshotHeight(0),
+      m_upgradeDetector(currency, m_blocks, BLOCK_MAJOR_VERSION_2),
+      m_ringSignatureVerifier(std::max(std::thread::hardware_concurrency(), 1u) - 1),
+      m_longHashCalculator(std::max(std::thread::hardware_concurrency(), 1u), MAX_PRECOMPUTED_LONG_HASHES),
+      m_verifiedTransactions(VERIFIED_TRANSACTIONS_CACHE_SIZE) {
 
   crypto::key_image nullImage = AUTO_VAL_INIT(nullImage);
   m_spent_keys.set_deleted_key(nullImage);
@@ -349,28 +383,29 @@ bool blockchain_storage::haveSpentKeyImages(const cryptonote::Transaction& tx) {
 }
 
 bool blockchain_storage::have_tx(const crypto::hash &id) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   return m_transactionMap.find(id) != m_transactionMap.end();
 }
 
 bool blockchain_storage::have_tx_keyimg_as_spent(const crypto::key_image &key_im) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   return  m_spent_keys.find(key_im) != m_spent_keys.end();
 }
 
 uint64_t blockchain_storage::get_current_blockchain_height() {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   return m_blocks.size();
 }
 
 bool blockchain_storage::init(const std::string& config_folder, bool load_existing) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  EXCLUSIVE_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   if (!config_folder.empty() && !tools::create_directories_if_necessary(config_folder)) {
     LOG_ERROR("Failed to create data directory: " << m_config_folder);
     return false;
   }
 
   m_config_folder = config_folder;
+  m_cacheSnapshotHeight = 0;
 
   if (!m_blocks.open(appendPath(config_folder, m_currency.blocksFileName()), appendPath(config_folder, m_currency.blockIndexesFileName()), 1024)) {
     return false;
@@ -385,13 +420,15 @@ bool blockchain_storage::init(const std::string& config_folder, bool load_existi
         LOG_PRINT_L0("Can't load blockchain storage from file.");
       }
     } else {
-      BlockCacheSerializer loader(*this, get_block_hash(m_blocks.back().bl));
+      BlockCacheSerializer loader(*this);
       tools::unserialize_obj_from_file(loader, appendPath(config_folder, m_currency.blocksCacheFileName()));
 
-      if (!loader.loaded()) {
+      if (!loader.loaded() || !replayCacheJournal()) {
         LOG_PRINT_L0("No actual blockchain cache found, rebuilding internal structures...");
         std::chrono::steady_clock::time_point timePoint = std::chrono::steady_clock::now();
         m_blockIndex.clear();
+        m_blockHeaders.clear();
+        m_blockBlobs.clear();
         m_transactionMap.clear();
         m_spent_keys.clear();
         m_outputs.clear();
@@ -400,38 +437,11 @@ bool blockchain_storage::init(const std::string& config_folder, bool load_existi
           if (b % 1000 == 0) {
             std::cout << "Height " << b << " of " << m_blocks.size() << '\r';
           }
-          const BlockEntry& block = m_blocks[b];
-          crypto::hash blockHash = get_block_hash(block.bl);
-          m_blockIndex.push(blockHash);
-          for (uint16_t t = 0; t < block.transactions.size(); ++t) {
-            const TransactionEntry& transaction = block.transactions[t];
-            crypto::hash transactionHash = get_transaction_hash(transaction.tx);
-            TransactionIndex transactionIndex = { b, t };
-            m_transactionMap.insert(std::make_pair(transactionHash, transactionIndex));
-
-            // process inputs
-            for (auto& i : transaction.tx.vin) {
-              if (i.type() == typeid(TransactionInputToKey)) {
-                m_spent_keys.insert(::boost::get<TransactionInputToKey>(i).keyImage);
-              } else if (i.type() == typeid(TransactionInputMultisignature)) {
-                auto out = ::boost::get<TransactionInputMultisignature>(i);
-                m_multisignatureOutputs[out.amount][out.outputIndex].isUsed = true;
-              }
-            }
-
-            // process outputs
-            for (uint16_t o = 0; o < transaction.tx.vout.size(); ++o) {
-              const auto& out = transaction.tx.vout[o];
-              if(out.target.type() == typeid(TransactionOutputToKey)) {
-                m_outputs[out.amount].push_back(std::make_pair<>(transactionIndex, o));
-              } else if (out.target.type() == typeid(TransactionOutputMultisignature)) {
-                MultisignatureOutputUsage usage = { transactionIndex, o, false };
-                m_multisignatureOutputs[out.amount].push_back(usage);
-              }
-            }
-          }
+
+          pushBlockCache(b);
         }
 
+        m_cacheSnapshotHeight = 0;
         std::chrono::duration<double> duration = std::chrono::steady_clock::now() - timePoint;
         LOG_PRINT_L0("Rebuilding internal structures took: " << duration.count());
       }
@@ -440,13 +450,20 @@ bool blockchain_storage::init(const std::string& config_folder, bool load_existi
     m_blocks.clear();
   }
 
+  m_cacheJournal.close();
+  m_cacheJournal.open(appendPath(config_folder, m_currency.blocksCacheJournalFileName()), std::ios::out | std::ios::binary | (load_existing ? std::ios::app : std::ios::trunc));
+  if (!m_cacheJournal) {
+    LOG_ERROR("Failed to open blockchain cache journal");
+    return false;
+  }
+
   if (m_blocks.empty()) {
     LOG_PRINT_L0("Blockchain not loaded, generating genesis block.");
     block_verification_context bvc = boost::value_initialized<block_verification_context>();
     add_new_block(m_currency.genesisBlock(), bvc);
     CHECK_AND_ASSERT_MES(!bvc.m_verifivation_failed, false, "Failed to add genesis block to blockchain");
   } else {
-    crypto::hash firstBlockHash = get_block_hash(m_blocks[0].bl);
+    crypto::hash firstBlockHash = get_block_hash(m_blocks[0]->bl);
     CHECK_AND_ASSERT_MES(firstBlockHash == m_currency.genesisBlockHash(), false,
       "Failed to init: genesis block mismatch. Probably you set --testnet flag with data dir with non-test blockchain or another network.");
   }
@@ -458,8 +475,8 @@ bool blockchain_storage::init(const std::string& config_folder, bool load_existi
 
   update_next_comulative_size_limit();
 
-  uint64_t timestamp_diff = time(NULL) - m_blocks.back().bl.timestamp;
-  if (!m_blocks.back().bl.timestamp) {
+  uint64_t timestamp_diff = time(NULL) - m_blocks.back()->bl.timestamp;
+  if (!m_blocks.back()->bl.timestamp) {
     timestamp_diff = time(NULL) - 1341378000;
   }
 
@@ -468,27 +485,192 @@ bool blockchain_storage::init(const std::string& config_folder, bool load_existi
 }
 
 bool blockchain_storage::storeCache() {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
-
+  std::lock_guard<std::mutex> storeLock(m_cacheStoreMutex);
+  // Written under the shared lock like the full cache always was: copying it first would double its memory and block
+  // writers just as long. Snapshots are rare enough (see isCacheSnapshotStale) for this to stay cheap overall.
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   LOG_PRINT_L0("Saving blockchain...");
+
+  std::string cacheFileName = appendPath(m_config_folder, m_currency.blocksCacheFileName());
+  std::string tempFileName = cacheFileName + ".tmp";
   BlockCacheSerializer ser(*this, get_tail_id());
-  if (!tools::serialize_obj_to_file(ser, appendPath(m_config_folder, m_currency.blocksCacheFileName()))) {
+  if (!tools::serialize_obj_to_file(ser, tempFileName)) {
     LOG_ERROR("Failed to save blockchain cache");
     return false;
   }
 
+  // Replace the previous snapshot only once the new one is complete, so a crash never leaves a torn cache
+  boost::system::error_code ec;
+  boost::filesystem::rename(tempFileName, cacheFileName, ec);
+  if (ec) {
+    LOG_ERROR("Failed to replace blockchain cache: " << ec.message());
+    return false;
+  }
+
+  // Blocks popped so far are not needed anymore to roll back the new snapshot, and none can be popped meanwhile
+  std::lock_guard<std::mutex> journalLock(m_cacheJournalMutex);
+  m_cacheJournal.close();
+  m_cacheJournal.open(appendPath(m_config_folder, m_currency.blocksCacheJournalFileName()), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!m_cacheJournal) {
+    LOG_ERROR("Failed to truncate blockchain cache journal");
+  }
+
+  m_cacheSnapshotHeight = m_blocks.size();
   return true;
 }
 
+bool blockchain_storage::isCacheSnapshotStale() {
+  uint64_t height = get_current_blockchain_height();
+  std::lock_guard<std::mutex> journalLock(m_cacheJournalMutex);
+  return height - m_cacheSnapshotHeight >= std::max(CACHE_SNAPSHOT_MAX_LAG, m_cacheSnapshotHeight / CACHE_SNAPSHOT_LAG_DIVISOR);
+}
+
+bool blockchain_storage::replayCacheJournal() {
+  std::unordered_map<crypto::hash, BlockEntry> poppedBlocks;
+  std::ifstream journal(appendPath(m_config_folder, m_currency.blocksCacheJournalFileName()), std::ios::in | std::ios::binary);
+  if (journal) {
+    binary_archive<false> archive(journal);
+    while (journal.peek() != std::ifstream::traits_type::eof()) {
+      BlockEntry block;
+      // The last record may be incomplete if the daemon crashed while writing it
+      if (!do_serialize(archive, block)) {
+        break;
+      }
+
+      crypto::hash blockHash = get_block_hash(block.bl);
+      poppedBlocks[blockHash] = std::move(block);
+    }
+  }
+
+  try {
+    uint64_t rolledBack = 0;
+    while (m_blockIndex.size() > 0) {
+      uint64_t height = m_blockIndex.size() - 1;
+      crypto::hash blockHash = m_blockIndex.getBlockId(height);
+      if (height < m_blocks.size() && blockHash == get_block_hash(m_blocks[height]->bl)) {
+        break;
+      }
+
+      auto it = poppedBlocks.find(blockHash);
+      if (it == poppedBlocks.end()) {
+        LOG_PRINT_L0("Blockchain cache does not match stored blocks at height " << height);
+        return false;
+      }
+
+      popBlockCache(it->second);
+      ++rolledBack;
+    }
+
+    m_cacheSnapshotHeight = m_blockIndex.size();
+    for (uint32_t b = static_cast<uint32_t>(m_blockIndex.size()); b < m_blocks.size(); ++b) {
+      pushBlockCache(b);
+    }
+
+    LOG_PRINT_L0("Blockchain cache loaded, rolled back " << rolledBack << " blocks and replayed " << m_blocks.size() - m_cacheSnapshotHeight << " blocks");
+  } catch (std::exception& e) {
+    LOG_ERROR("Failed to replay blockchain cache journal: " << e.what());
+    return false;
+  }
+
+  return true;
+}
+
+void blockchain_storage::appendCacheJournal(BlockEntry& block) {
+  std::lock_guard<std::mutex> journalLock(m_cacheJournalMutex);
+  binary_archive<true> archive(m_cacheJournal);
+  if (!do_serialize(archive, block) || !m_cacheJournal.flush()) {
+    LOG_ERROR("Failed to write blockchain cache journal");
+  }
+
+  m_cacheSnapshotHeight = std::min<uint64_t>(m_cacheSnapshotHeight, m_blocks.size() - 1);
+}
+
+void blockchain_storage::pushBlockCache(uint32_t height) {
+  Blocks::ItemPtr blockPtr = m_blocks[height];
+  const BlockEntry& block = *blockPtr;
+  crypto::hash blockHash = get_block_hash(block.bl);
+  m_blockIndex.push(blockHash);
+  m_blockHeaders.push(block.bl.timestamp, block.cumulative_difficulty, block.block_cumulative_size, block.already_generated_coins);
+  pushBlockBlobs(block);
+  for (uint16_t t = 0; t < block.transactions.size(); ++t) {
+    const TransactionEntry& transaction = block.transactions[t];
+    crypto::hash transactionHash = get_transaction_hash(transaction.tx);
+    TransactionIndex transactionIndex = { height, t };
+    m_transactionMap.insert(std::make_pair(transactionHash, transactionIndex));
+
+    // process inputs
+    for (auto& i : transaction.tx.vin) {
+      if (i.type() == typeid(TransactionInputToKey)) {
+        m_spent_keys.insert(::boost::get<TransactionInputToKey>(i).keyImage);
+      } else if (i.type() == typeid(TransactionInputMultisignature)) {
+        auto out = ::boost::get<TransactionInputMultisignature>(i);
+        m_multisignatureOutputs[out.amount][out.outputIndex].isUsed = true;
+      }
+    }
+
+    // process outputs
+    for (uint16_t o = 0; o < transaction.tx.vout.size(); ++o) {
+      const auto& out = transaction.tx.vout[o];
+      if(out.target.type() == typeid(TransactionOutputToKey)) {
+        m_outputs.push(out.amount, transactionIndex.block, transactionIndex.transaction, o, ::boost::get<TransactionOutputToKey>(out.target).key, transaction.tx.unlockTime);
+      } else if (out.target.type() == typeid(TransactionOutputMultisignature)) {
+        MultisignatureOutputUsage usage = { transactionIndex, o, false };
+        m_multisignatureOutputs[out.amount].push_back(usage);
+      }
+    }
+  }
+}
+
+void blockchain_storage::popBlockCache(const BlockEntry& block) {
+  for (size_t i = block.transactions.size() - 1; i > 0; --i) {
+    popTransaction(block.transactions[i].tx, block.bl.txHashes[i - 1]);
+  }
+
+  popTransaction(block.bl.minerTx, get_transaction_hash(block.bl.minerTx));
+  m_blockIndex.pop();
+  m_blockHeaders.pop();
+  m_blockBlobs.pop();
+}
+
+void blockchain_storage::pushBlockBlobs(const BlockEntry& block) {
+  std::vector<uint32_t> transactionOffsets;
+  std::vector<uint32_t> transactionSizes;
+  transactionOffsets.reserve(block.transactions.size());
+  transactionSizes.reserve(block.transactions.size());
+  for (const TransactionEntry& transaction : block.transactions) {
+    transactionOffsets.push_back(transaction.blobOffset);
+    transactionSizes.push_back(transaction.blobSize);
+  }
+
+  m_blockBlobs.push(block.blockBlobSize, transactionOffsets, transactionSizes);
+}
+
 bool blockchain_storage::deinit() {
-  storeCache();
+  if (isCacheSnapshotStale()) {
+    storeCache();
+  }
+
+  std::lock_guard<std::mutex> journalLock(m_cacheJournalMutex);
+  m_cacheJournal.close();
   return true;
 }
 
+void blockchain_storage::on_idle() {
+  m_cacheSnapshotInterval.do_call([this]() {
+    if (isCacheSnapshotStale()) {
+      storeCache();
+    }
+
+    return true;
+  });
+}
+
 bool blockchain_storage::reset_and_set_genesis_block(const Block& b) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  EXCLUSIVE_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   m_blocks.clear();
   m_blockIndex.clear();
+  m_blockHeaders.clear();
+  m_blockBlobs.clear();
   m_transactionMap.clear();
 
   m_spent_keys.clear();
@@ -501,19 +683,19 @@ bool blockchain_storage::reset_and_set_genesis_block(const Block& b) {
 }
 
 crypto::hash blockchain_storage::get_tail_id(uint64_t& height) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   height = get_current_blockchain_height() - 1;
   return get_tail_id();
 }
 
 crypto::hash blockchain_storage::get_tail_id() {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   return m_blockIndex.getTailId();
 }
 
 bool blockchain_storage::getPoolSymmetricDifference(const std::vector<crypto::hash>& known_pool_tx_ids, const crypto::hash& known_block_id, std::vector<Transaction>& new_txs, std::vector<crypto::hash>& deleted_tx_ids) {
   CRITICAL_REGION_LOCAL1(m_tx_pool);
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   if (known_block_id != get_tail_id()) {
     return false;
   }
@@ -527,23 +709,40 @@ bool blockchain_storage::getPoolSymmetricDifference(const std::vector<crypto::ha
   return true;
 }
 
+bool blockchain_storage::getPoolChanges(const crypto::hash& knownBlockId, uint64_t knownPoolVersion, bool& isPoolVersionActual, uint64_t& poolVersion,
+  std::vector<Transaction>& newTxs, std::vector<crypto::hash>& deletedTxIds) {
+  CRITICAL_REGION_LOCAL1(m_tx_pool);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  if (knownBlockId != get_tail_id()) {
+    return false;
+  }
+
+  std::vector<crypto::hash> newTxIds;
+  isPoolVersionActual = m_tx_pool.get_changes(knownPoolVersion, newTxIds, deletedTxIds, poolVersion);
+
+  std::vector<crypto::hash> misses;
+  get_transactions(newTxIds, newTxs, misses, true);
+  assert(misses.empty());
+  return true;
+}
+
 bool blockchain_storage::get_short_chain_history(std::list<crypto::hash>& ids) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   return m_blockIndex.getShortChainHistory(ids);
 }
 
 crypto::hash blockchain_storage::get_block_id_by_height(uint64_t height) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   return m_blockIndex.getBlockId(height);
 }
 
 bool blockchain_storage::get_block_by_hash(const crypto::hash& blockHash, Block& b) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
 
   uint64_t height = 0;
 
   if (m_blockIndex.getBlockHeight(blockHash, height)) {
-    b = m_blocks[height].bl;
+    b = m_blocks[height]->bl;
     return true;
   }
 
@@ -557,28 +756,28 @@ bool blockchain_storage::get_block_by_hash(const crypto::hash& blockHash, Block&
 }
 
 difficulty_type blockchain_storage::get_difficulty_for_next_block() {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   std::vector<uint64_t> timestamps;
   std::vector<difficulty_type> commulative_difficulties;
-  size_t offset = m_blocks.size() - std::min(m_blocks.size(), static_cast<uint64_t>(m_currency.difficultyBlocksCount()));
+  size_t offset = m_blockHeaders.size() - std::min(m_blockHeaders.size(), static_cast<uint64_t>(m_currency.difficultyBlocksCount()));
   if (offset == 0) {
     ++offset;
   }
 
-  for (; offset < m_blocks.size(); offset++) {
-    timestamps.push_back(m_blocks[offset].bl.timestamp);
-    commulative_difficulties.push_back(m_blocks[offset].cumulative_difficulty);
+  for (; offset < m_blockHeaders.size(); offset++) {
+    timestamps.push_back(m_blockHeaders.timestamp(offset));
+    commulative_difficulties.push_back(m_blockHeaders.cumulativeDifficulty(offset));
   }
 
   return m_currency.nextDifficulty(timestamps, commulative_difficulties);
 }
 
 uint64_t blockchain_storage::getCoinsInCirculation() {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
-  if (m_blocks.empty()) {
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  if (m_blockHeaders.empty()) {
     return 0;
   } else {
-    return m_blocks.back().already_generated_coins;
+    return m_blockHeaders.alreadyGeneratedCoins(m_blockHeaders.size() - 1);
   }
 }
 
@@ -587,11 +786,11 @@ uint8_t blockchain_storage::get_block_major_version_for_height(uint64_t height)
 }
 
 bool blockchain_storage::rollback_blockchain_switching(std::list<Block>& original_chain, size_t rollback_height) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  EXCLUSIVE_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   //remove failed subchain
   for (size_t i = m_blocks.size() - 1; i >= rollback_height; i--)
   {
-    popBlock(get_block_hash(m_blocks.back().bl));
+    popBlock(get_block_hash(m_blocks.back()->bl));
     //bool r = pop_block_from_blockchain();
     //CHECK_AND_ASSERT_MES(r, false, "PANIC!!! failed to remove block while chain switching during the rollback!");
   }
@@ -608,7 +807,7 @@ bool blockchain_storage::rollback_blockchain_switching(std::list<Block>& origina
 }
 
 bool blockchain_storage::switch_to_alternative_blockchain(std::list<blocks_ext_by_hash::iterator>& alt_chain, bool discard_disconnected_chain) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  EXCLUSIVE_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   CHECK_AND_ASSERT_MES(alt_chain.size(), false, "switch_to_alternative_blockchain: empty chain passed");
 
   size_t split_height = alt_chain.front()->second.height;
@@ -617,7 +816,7 @@ bool blockchain_storage::switch_to_alternative_blockchain(std::list<blocks_ext_b
   //disconnecting old chain
   std::list<Block> disconnected_chain;
   for (size_t i = m_blocks.size() - 1; i >= split_height; i--) {
-    Block b = m_blocks[i].bl;
+    Block b = m_blocks[i]->bl;
     popBlock(get_block_hash(b));
     //CHECK_AND_ASSERT_MES(r, false, "failed to remove block on chain switching");
     disconnected_chain.push_front(b);
@@ -671,7 +870,7 @@ difficulty_type blockchain_storage::get_next_difficulty_for_alternative_chain(co
   std::vector<uint64_t> timestamps;
   std::vector<difficulty_type> commulative_difficulties;
   if (alt_chain.size() < m_currency.difficultyBlocksCount()) {
-    CRITICAL_REGION_LOCAL(m_blockchain_lock);
+    SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
     size_t main_chain_stop_offset = alt_chain.size() ? alt_chain.front()->second.height : bei.height;
     size_t main_chain_count = m_currency.difficultyBlocksCount() - std::min(m_currency.difficultyBlocksCount(), alt_chain.size());
     main_chain_count = std::min(main_chain_count, main_chain_stop_offset);
@@ -680,8 +879,8 @@ difficulty_type blockchain_storage::get_next_difficulty_for_alternative_chain(co
     if (!main_chain_start_offset)
       ++main_chain_start_offset; //skip genesis block
     for (; main_chain_start_offset < main_chain_stop_offset; ++main_chain_start_offset) {
-      timestamps.push_back(m_blocks[main_chain_start_offset].bl.timestamp);
-      commulative_difficulties.push_back(m_blocks[main_chain_start_offset].cumulative_difficulty);
+      timestamps.push_back(m_blockHeaders.timestamp(main_chain_start_offset));
+      commulative_difficulties.push_back(m_blockHeaders.cumulativeDifficulty(main_chain_start_offset));
     }
 
     CHECK_AND_ASSERT_MES((alt_chain.size() + timestamps.size()) <= m_currency.difficultyBlocksCount(), false,
@@ -763,23 +962,23 @@ bool blockchain_storage::validate_miner_transaction(const Block& b, uint64_t hei
 }
 
 bool blockchain_storage::get_backward_blocks_sizes(size_t from_height, std::vector<size_t>& sz, size_t count) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
-  CHECK_AND_ASSERT_MES(from_height < m_blocks.size(), false, "Internal error: get_backward_blocks_sizes called with from_height=" << from_height << ", blockchain height = " << m_blocks.size());
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  CHECK_AND_ASSERT_MES(from_height < m_blockHeaders.size(), false, "Internal error: get_backward_blocks_sizes called with from_height=" << from_height << ", blockchain height = " << m_blockHeaders.size());
   size_t start_offset = (from_height + 1) - std::min((from_height + 1), count);
   for (size_t i = start_offset; i != from_height + 1; i++) {
-    sz.push_back(m_blocks[i].block_cumulative_size);
+    sz.push_back(m_blockHeaders.blockCumulativeSize(i));
   }
 
   return true;
 }
 
 bool blockchain_storage::get_last_n_blocks_sizes(std::vector<size_t>& sz, size_t count) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
-  if (!m_blocks.size()) {
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  if (m_blockHeaders.empty()) {
     return true;
   }
 
-  return get_backward_blocks_sizes(m_blocks.size() - 1, sz, count);
+  return get_backward_blocks_sizes(m_blockHeaders.size() - 1, sz, count);
 }
 
 uint64_t blockchain_storage::get_current_comulative_blocksize_limit() {
@@ -790,7 +989,7 @@ bool blockchain_storage::create_block_template(Block& b, const AccountPublicAddr
   size_t median_size;
   uint64_t already_generated_coins;
 
-  CRITICAL_REGION_BEGIN(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_BEGIN(m_blockchain_lock);
   height = m_blocks.size();
   diffic = get_difficulty_for_next_block();
   CHECK_AND_ASSERT_MES(diffic, false, "difficulty overhead.");
@@ -815,7 +1014,7 @@ bool blockchain_storage::create_block_template(Block& b, const AccountPublicAddr
   b.timestamp = time(NULL);
 
   median_size = m_current_block_cumul_sz_limit / 2;
-  already_generated_coins = m_blocks.back().already_generated_coins;
+  already_generated_coins = m_blockHeaders.alreadyGeneratedCoins(height - 1);
 
   CRITICAL_REGION_END();
 
@@ -927,13 +1126,13 @@ bool blockchain_storage::complete_timestamps_vector(uint64_t start_top_height, s
   if (timestamps.size() >= m_currency.timestampCheckWindow())
     return true;
 
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   size_t need_elements = m_currency.timestampCheckWindow() - timestamps.size();
-  CHECK_AND_ASSERT_MES(start_top_height < m_blocks.size(), false, "internal error: passed start_height = " << start_top_height << " not less then m_blocks.size()=" << m_blocks.size());
+  CHECK_AND_ASSERT_MES(start_top_height < m_blockHeaders.size(), false, "internal error: passed start_height = " << start_top_height << " not less then m_blockHeaders.size()=" << m_blockHeaders.size());
   size_t stop_offset = start_top_height > need_elements ? start_top_height - need_elements : 0;
   do
   {
-    timestamps.push_back(m_blocks[start_top_height].bl.timestamp);
+    timestamps.push_back(m_blockHeaders.timestamp(start_top_height));
     if (start_top_height == 0)
       break;
     --start_top_height;
@@ -942,7 +1141,7 @@ bool blockchain_storage::complete_timestamps_vector(uint64_t start_top_height, s
 }
 
 bool blockchain_storage::handle_alternative_block(const Block& b, const crypto::hash& id, block_verification_context& bvc) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  EXCLUSIVE_CRITICAL_REGION_LOCAL(m_blockchain_lock);
 
   uint64_t block_height = get_block_height(b);
   if (block_height == 0) {
@@ -1002,7 +1201,7 @@ bool blockchain_storage::handle_alternative_block(const Block& b, const crypto::
       //make sure that it has right connection to main chain
       CHECK_AND_ASSERT_MES(m_blocks.size() > alt_chain.front()->second.height, false, "main blockchain wrong height");
       crypto::hash h = null_hash;
-      get_block_hash(m_blocks[alt_chain.front()->second.height - 1].bl, h);
+      get_block_hash(m_blocks[alt_chain.front()->second.height - 1]->bl, h);
       CHECK_AND_ASSERT_MES(h == alt_chain.front()->second.bl.prevId, false, "alternative chain have wrong connection to main chain");
       complete_timestamps_vector(alt_chain.front()->second.height - 1, timestamps);
     } else {
@@ -1035,7 +1234,7 @@ bool blockchain_storage::handle_alternative_block(const Block& b, const crypto::
     difficulty_type current_diff = get_next_difficulty_for_alternative_chain(alt_chain, bei);
     CHECK_AND_ASSERT_MES(current_diff, false, "!!!!!!! DIFFICULTY OVERHEAD !!!!!!!");
     crypto::hash proof_of_work = null_hash;
-    if (!m_currency.checkProofOfWork(m_cn_context, bei.bl, current_diff, proof_of_work)) {
+    if (!checkProofOfWork(bei.bl, id, current_diff, proof_of_work)) {
       LOG_PRINT_RED_L0("Block with id: " << id
         << ENDL << " for alternative chain, have not enough proof of work: " << proof_of_work
         << ENDL << " expected difficulty: " << current_diff);
@@ -1049,7 +1248,7 @@ bool blockchain_storage::handle_alternative_block(const Block& b, const crypto::
       return false;
     }
 
-    bei.cumulative_difficulty = alt_chain.size() ? it_prev->second.cumulative_difficulty : m_blocks[mainPrevHeight].cumulative_difficulty;
+    bei.cumulative_difficulty = alt_chain.size() ? it_prev->second.cumulative_difficulty : m_blockHeaders.cumulativeDifficulty(mainPrevHeight);
     bei.cumulative_difficulty += current_diff;
 
 #ifdef _DEBUG
@@ -1069,10 +1268,10 @@ bool blockchain_storage::handle_alternative_block(const Block& b, const crypto::
       if (r) bvc.m_added_to_main_chain = true;
       else bvc.m_verifivation_failed = true;
       return r;
-    } else if (m_blocks.back().cumulative_difficulty < bei.cumulative_difficulty) //check if difficulty bigger then in main chain
+    } else if (m_blockHeaders.cumulativeDifficulty(m_blockHeaders.size() - 1) < bei.cumulative_difficulty) //check if difficulty bigger then in main chain
     {
       //do reorganize!
-      LOG_PRINT_GREEN("###### REORGANIZE on height: " << alt_chain.front()->second.height << " of " << m_blocks.size() - 1 << " with cum_difficulty " << m_blocks.back().cumulative_difficulty
+      LOG_PRINT_GREEN("###### REORGANIZE on height: " << alt_chain.front()->second.height << " of " << m_blocks.size() - 1 << " with cum_difficulty " << m_blockHeaders.cumulativeDifficulty(m_blockHeaders.size() - 1)
         << ENDL << " alternative blockchain size: " << alt_chain.size() << " with cum_difficulty " << bei.cumulative_difficulty, LOG_LEVEL_0);
       bool r = switch_to_alternative_blockchain(alt_chain, false);
       if (r) bvc.m_added_to_main_chain = true;
@@ -1095,14 +1294,14 @@ bool blockchain_storage::handle_alternative_block(const Block& b, const crypto::
 }
 
 bool blockchain_storage::get_blocks(uint64_t start_offset, size_t count, std::list<Block>& blocks, std::list<Transaction>& txs) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   if (start_offset >= m_blocks.size())
     return false;
   for (size_t i = start_offset; i < start_offset + count && i < m_blocks.size(); i++)
   {
-    blocks.push_back(m_blocks[i].bl);
+    blocks.push_back(m_blocks[i]->bl);
     std::list<crypto::hash> missed_ids;
-    get_transactions(m_blocks[i].bl.txHashes, txs, missed_ids);
+    get_transactions(m_blocks[i]->bl.txHashes, txs, missed_ids);
     CHECK_AND_ASSERT_MES(!missed_ids.size(), false, "have missed transactions in own block in main blockchain");
   }
 
@@ -1110,52 +1309,91 @@ bool blockchain_storage::get_blocks(uint64_t start_offset, size_t count, std::li
 }
 
 bool blockchain_storage::get_blocks(uint64_t start_offset, size_t count, std::list<Block>& blocks) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   if (start_offset >= m_blocks.size()) {
     return false;
   }
 
   for (size_t i = start_offset; i < start_offset + count && i < m_blocks.size(); i++) {
-    blocks.push_back(m_blocks[i].bl);
+    blocks.push_back(m_blocks[i]->bl);
+  }
+
+  return true;
+}
+
+bool blockchain_storage::getRawBlock(uint64_t height, block_complete_entry& rawBlock) {
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  if (height >= m_blocks.size()) {
+    return false;
+  }
+
+  // The blob index locates the blobs, so the stored entry is copied from without being deserialized
+  Blocks::ItemSpan span = m_blocks.itemSpan(height);
+  uint32_t blockBlobSize = m_blockBlobs.blockBlobSize(height);
+  CHECK_AND_ASSERT_MES(blockBlobSize != 0 && blockBlobSize <= span.size, false, "Internal error: invalid blob layout of block at height " << height);
+  rawBlock.block.assign(span.data, blockBlobSize);
+  // transaction 0 is the miner transaction, which is a part of the block blob
+  for (size_t i = 1; i < m_blockBlobs.transactionCount(height); ++i) {
+    uint32_t offset = m_blockBlobs.transactionBlobOffset(height, i);
+    uint32_t size = m_blockBlobs.transactionBlobSize(height, i);
+    CHECK_AND_ASSERT_MES(size != 0 && offset + static_cast<uint64_t>(size) <= span.size, false,
+      "Internal error: invalid blob layout of transaction " << i << " in block at height " << height);
+    rawBlock.txs.push_back(blobdata(span.data + offset, size));
   }
 
   return true;
 }
 
+void blockchain_storage::getRawTransactions(const std::list<crypto::hash>& txs_ids, std::list<blobdata>& txs, std::list<crypto::hash>& missed_txs) {
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  for (const auto& tx_id : txs_ids) {
+    auto it = m_transactionMap.find(tx_id);
+    if (it == m_transactionMap.end()) {
+      missed_txs.push_back(tx_id);
+      continue;
+    }
+
+    Blocks::ItemSpan span = m_blocks.itemSpan(it->second.block);
+    uint32_t offset = m_blockBlobs.transactionBlobOffset(it->second.block, it->second.transaction);
+    uint32_t size = m_blockBlobs.transactionBlobSize(it->second.block, it->second.transaction);
+    if (size == 0 || offset + static_cast<uint64_t>(size) > span.size) {
+      LOG_ERROR("Internal error: invalid blob layout of transaction " << tx_id);
+      missed_txs.push_back(tx_id);
+      continue;
+    }
+
+    txs.push_back(blobdata(span.data + offset, size));
+  }
+}
+
+uint64_t blockchain_storage::getBlockEntryLoads() {
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  return m_blocks.cacheMisses();
+}
+
 bool blockchain_storage::handle_get_objects(NOTIFY_REQUEST_GET_OBJECTS::request& arg, NOTIFY_RESPONSE_GET_OBJECTS::request& rsp) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   rsp.current_blockchain_height = get_current_blockchain_height();
-  std::list<Block> blocks;
-  get_blocks(arg.blocks, blocks, rsp.missed_ids);
-
-  for (const auto& bl : blocks) {
-    std::list<crypto::hash> missed_tx_id;
-    std::list<Transaction> txs;
-    get_transactions(bl.txHashes, txs, rsp.missed_ids);
-    CHECK_AND_ASSERT_MES(!missed_tx_id.size(), false, "Internal error: have missed missed_tx_id.size()=" << missed_tx_id.size() << ENDL << "for block id = " << get_block_hash(bl));
+  for (const auto& bl_id : arg.blocks) {
+    uint64_t height = 0;
+    if (!m_blockIndex.getBlockHeight(bl_id, height)) {
+      rsp.missed_ids.push_back(bl_id);
+      continue;
+    }
+
     rsp.blocks.push_back(block_complete_entry());
-    block_complete_entry& e = rsp.blocks.back();
-    //pack block
-    e.block = t_serializable_object_to_blob(bl);
-    //pack transactions
-    for (Transaction& tx : txs) {
-      e.txs.push_back(t_serializable_object_to_blob(tx));
+    if (!getRawBlock(height, rsp.blocks.back())) {
+      return false;
     }
   }
 
   //get another transactions, if need
-  std::list<Transaction> txs;
-  get_transactions(arg.txs, txs, rsp.missed_ids);
-  //pack aside transactions
-  for (const auto& tx : txs) {
-    rsp.txs.push_back(t_serializable_object_to_blob(tx));
-  }
-
+  getRawTransactions(arg.txs, rsp.txs, rsp.missed_ids);
   return true;
 }
 
 bool blockchain_storage::get_alternative_blocks(std::list<Block>& blocks) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   for (auto& alt_bl : m_alternative_chains) {
     blocks.push_back(alt_bl.second.bl);
   }
@@ -1164,66 +1402,54 @@ bool blockchain_storage::get_alternative_blocks(std::list<Block>& blocks) {
 }
 
 size_t blockchain_storage::get_alternative_blocks_count() {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   return m_alternative_chains.size();
 }
 
-bool blockchain_storage::add_out_to_get_random_outs(std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount& result_outs, uint64_t amount, size_t i) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
-  const Transaction& tx = transactionByIndex(amount_outs[i].first).tx;
-  CHECK_AND_ASSERT_MES(tx.vout.size() > amount_outs[i].second, false, "internal error: in global outs index, transaction out index="
-    << amount_outs[i].second << " more than transaction outputs = " << tx.vout.size() << ", for tx id = " << get_transaction_hash(tx));
-  CHECK_AND_ASSERT_MES(tx.vout[amount_outs[i].second].target.type() == typeid(TransactionOutputToKey), false, "unknown tx out type");
-
+bool blockchain_storage::add_out_to_get_random_outs(const CryptoNote::OutputIndex::OutputKeys& amount_keys, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount& result_outs, uint64_t amount, size_t i) {
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   //check if transaction is unlocked
-  if (!is_tx_spendtime_unlocked(tx.unlockTime))
+  if (!is_tx_spendtime_unlocked(amount_keys[i].unlockTime))
     return false;
 
   COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::out_entry& oen = *result_outs.outs.insert(result_outs.outs.end(), COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::out_entry());
   oen.global_amount_index = i;
-  oen.out_key = boost::get<TransactionOutputToKey>(tx.vout[amount_outs[i].second].target).key;
+  oen.out_key = amount_keys[i].key;
   return true;
 }
 
-size_t blockchain_storage::find_end_of_allowed_index(const std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
-  if (amount_outs.empty()) {
+size_t blockchain_storage::find_end_of_allowed_index(uint64_t amount) {
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  uint64_t height = get_current_blockchain_height();
+  if (height < m_currency.minedMoneyUnlockWindow()) {
     return 0;
   }
 
-  size_t i = amount_outs.size();
-  do {
-    --i;
-    if (amount_outs[i].first.block + m_currency.minedMoneyUnlockWindow() <= get_current_blockchain_height()) {
-      return i + 1;
-    }
-  } while (i != 0);
-
-  return 0;
+  return m_outputs.countUpToBlock(amount, height - m_currency.minedMoneyUnlockWindow());
 }
 
 bool blockchain_storage::get_random_outs_for_amounts(const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::request& req, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response& res) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
 
   for (uint64_t amount : req.amounts) {
     COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount& result_outs = *res.outs.insert(res.outs.end(), COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount());
     result_outs.amount = amount;
-    auto it = m_outputs.find(amount);
-    if (it == m_outputs.end()) {
+    const CryptoNote::OutputIndex::AmountOutputs* outputs = m_outputs.find(amount);
+    if (outputs == nullptr) {
       LOG_ERROR("COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS: not outs for amount " << amount << ", wallet should use some real outs when it lookup for some mix, so, at least one out for this amount should exist");
       continue;//actually this is strange situation, wallet should use some real outs when it lookup for some mix, so, at least one out for this amount should exist
     }
 
-    std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs = it->second;
+    const CryptoNote::OutputIndex::Outputs& amount_outs = outputs->outputs;
     //it is not good idea to use top fresh outs, because it increases possibility of transaction canceling on split
     //lets find upper bound of not fresh outs
-    size_t up_index_limit = find_end_of_allowed_index(amount_outs);
+    size_t up_index_limit = find_end_of_allowed_index(amount);
     CHECK_AND_ASSERT_MES(up_index_limit <= amount_outs.size(), false, "internal error: find_end_of_allowed_index returned wrong index=" << up_index_limit << ", with amount_outs.size = " << amount_outs.size());
 
     if (up_index_limit > 0) {
       ShuffleGenerator<size_t, crypto::random_engine<size_t>> generator(up_index_limit);
       for (uint64_t j = 0; j < up_index_limit && result_outs.outs.size() < req.outs_count; ++j) {
-        add_out_to_get_random_outs(amount_outs, result_outs, amount, generator());
+        add_out_to_get_random_outs(outputs->keys, result_outs, amount, generator());
       }
     }
   }
@@ -1232,7 +1458,7 @@ bool blockchain_storage::get_random_outs_for_amounts(const COMMAND_RPC_GET_RANDO
 
 bool blockchain_storage::find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, uint64_t& starter_offset)
 {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
 
   if (!qblock_ids.size() /*|| !req.m_total_height*/)
   {
@@ -1240,10 +1466,10 @@ bool blockchain_storage::find_blockchain_supplement(const std::list<crypto::hash
     return false;
   }
   //check genesis match
-  if (qblock_ids.back() != get_block_hash(m_blocks[0].bl))
+  if (qblock_ids.back() != get_block_hash(m_blocks[0]->bl))
   {
     LOG_ERROR("Client sent wrong NOTIFY_REQUEST_CHAIN: genesis block missmatch: " << ENDL << "id: "
-      << qblock_ids.back() << ", " << ENDL << "expected: " << get_block_hash(m_blocks[0].bl)
+      << qblock_ids.back() << ", " << ENDL << "expected: " << get_block_hash(m_blocks[0]->bl)
       << "," << ENDL << " dropping connection");
     return false;
   }
@@ -1260,18 +1486,18 @@ bool blockchain_storage::find_blockchain_supplement(const std::list<crypto::hash
 
 uint64_t blockchain_storage::block_difficulty(size_t i)
 {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
-  CHECK_AND_ASSERT_MES(i < m_blocks.size(), false, "wrong block index i = " << i << " at blockchain_storage::block_difficulty()");
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  CHECK_AND_ASSERT_MES(i < m_blockHeaders.size(), false, "wrong block index i = " << i << " at blockchain_storage::block_difficulty()");
   if (i == 0)
-    return m_blocks[i].cumulative_difficulty;
+    return m_blockHeaders.cumulativeDifficulty(i);
 
-  return m_blocks[i].cumulative_difficulty - m_blocks[i - 1].cumulative_difficulty;
+  return m_blockHeaders.cumulativeDifficulty(i) - m_blockHeaders.cumulativeDifficulty(i - 1);
 }
 
 void blockchain_storage::print_blockchain(uint64_t start_index, uint64_t end_index)
 {
   std::stringstream ss;
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   if (start_index >= m_blocks.size())
   {
     LOG_PRINT_L0("Wrong starter index set: " << start_index << ", expected max index " << m_blocks.size() - 1);
@@ -1280,9 +1506,9 @@ void blockchain_storage::print_blockchain(uint64_t start_index, uint64_t end_ind
 
   for (size_t i = start_index; i != m_blocks.size() && i != end_index; i++)
   {
-    ss << "height " << i << ", timestamp " << m_blocks[i].bl.timestamp << ", cumul_dif " << m_blocks[i].cumulative_difficulty << ", cumul_size " << m_blocks[i].block_cumulative_size
-      << "\nid\t\t" << get_block_hash(m_blocks[i].bl)
-      << "\ndifficulty\t\t" << block_difficulty(i) << ", nonce " << m_blocks[i].bl.nonce << ", tx_count " << m_blocks[i].bl.txHashes.size() << ENDL;
+    ss << "height " << i << ", timestamp " << m_blocks[i]->bl.timestamp << ", cumul_dif " << m_blocks[i]->cumulative_difficulty << ", cumul_size " << m_blocks[i]->block_cumulative_size
+      << "\nid\t\t" << get_block_hash(m_blocks[i]->bl)
+      << "\ndifficulty\t\t" << block_difficulty(i) << ", nonce " << m_blocks[i]->bl.nonce << ", tx_count " << m_blocks[i]->bl.txHashes.size() << ENDL;
   }
   LOG_PRINT_L1("Current blockchain:" << ENDL << ss.str());
   LOG_PRINT_L0("Blockchain printed with log level 1");
@@ -1290,7 +1516,7 @@ void blockchain_storage::print_blockchain(uint64_t start_index, uint64_t end_ind
 
 void blockchain_storage::print_blockchain_index() {
   std::stringstream ss;
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
 
   std::list<crypto::hash> blockIds;
   m_blockIndex.getBlockIds(0, std::numeric_limits<size_t>::max(), blockIds);
@@ -1306,13 +1532,14 @@ void blockchain_storage::print_blockchain_index() {
 
 void blockchain_storage::print_blockchain_outs(const std::string& file) {
   std::stringstream ss;
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
-  for (const outputs_container::value_type& v : m_outputs) {
-    const std::vector<std::pair<TransactionIndex, uint16_t>>& vals = v.second;
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  for (const auto& v : m_outputs) {
+    const CryptoNote::OutputIndex::Outputs& vals = v.second.outputs;
     if (!vals.empty()) {
       ss << "amount: " << v.first << ENDL;
       for (size_t i = 0; i != vals.size(); i++) {
-        ss << "\t" << get_transaction_hash(transactionByIndex(vals[i].first).tx) << ": " << vals[i].second << ENDL;
+        TransactionIndex transactionIndex = { vals[i].block, vals[i].transaction };
+        ss << "\t" << get_transaction_hash(transactionByIndex(transactionIndex)->tx) << ": " << vals[i].output << ENDL;
       }
     }
   }
@@ -1325,7 +1552,7 @@ void blockchain_storage::print_blockchain_outs(const std::string& file) {
 }
 
 bool blockchain_storage::find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, NOTIFY_RESPONSE_CHAIN_ENTRY::request& resp) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   if (!find_blockchain_supplement(qblock_ids, resp.start_height))
     return false;
 
@@ -1336,7 +1563,7 @@ bool blockchain_storage::find_blockchain_supplement(const std::list<crypto::hash
 }
 
 bool blockchain_storage::find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, std::list<std::pair<Block, std::list<Transaction> > >& blocks, uint64_t& total_height, uint64_t& start_height, size_t max_count) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   if (!find_blockchain_supplement(qblock_ids, start_height)) {
     return false;
   }
@@ -1345,18 +1572,36 @@ bool blockchain_storage::find_blockchain_supplement(const std::list<crypto::hash
   size_t count = 0;
   for (size_t i = start_height; i != m_blocks.size() && count < max_count; i++, count++) {
     blocks.resize(blocks.size() + 1);
-    blocks.back().first = m_blocks[i].bl;
+    blocks.back().first = m_blocks[i]->bl;
     std::list<crypto::hash> mis;
-    get_transactions(m_blocks[i].bl.txHashes, blocks.back().second, mis);
+    get_transactions(m_blocks[i]->bl.txHashes, blocks.back().second, mis);
     CHECK_AND_ASSERT_MES(!mis.size(), false, "internal error, transaction from block not found");
   }
 
   return true;
 }
 
+bool blockchain_storage::find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, std::list<block_complete_entry>& blocks, uint64_t& total_height, uint64_t& start_height, size_t max_count) {
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  if (!find_blockchain_supplement(qblock_ids, start_height)) {
+    return false;
+  }
+
+  total_height = get_current_blockchain_height();
+  size_t count = 0;
+  for (size_t i = start_height; i != m_blocks.size() && count < max_count; i++, count++) {
+    blocks.push_back(block_complete_entry());
+    if (!getRawBlock(i, blocks.back())) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 bool blockchain_storage::have_block(const crypto::hash& id)
 {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   if (m_blockIndex.hasBlock(id))
     return true;
 
@@ -1367,19 +1612,20 @@ bool blockchain_storage::have_block(const crypto::hash& id)
 }
 
 size_t blockchain_storage::get_total_transactions() {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   return m_transactionMap.size();
 }
 
 bool blockchain_storage::get_tx_outputs_gindexs(const crypto::hash& tx_id, std::vector<uint64_t>& indexs) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   auto it = m_transactionMap.find(tx_id);
   if (it == m_transactionMap.end()) {
     LOG_PRINT_RED_L0("warning: get_tx_outputs_gindexs failed to find transaction with id = " << tx_id);
     return false;
   }
 
-  const TransactionEntry& tx = transactionByIndex(it->second);
+  std::shared_ptr<const TransactionEntry> txPtr = transactionByIndex(it->second);
+  const TransactionEntry& tx = *txPtr;
   CHECK_AND_ASSERT_MES(tx.m_global_output_indexes.size(), false, "internal error: global indexes for transaction " << tx_id << " is empty");
   indexs.resize(tx.m_global_output_indexes.size());
   for (size_t i = 0; i < tx.m_global_output_indexes.size(); ++i) {
@@ -1390,7 +1636,7 @@ bool blockchain_storage::get_tx_outputs_gindexs(const crypto::hash& tx_id, std::
 }
 
 bool blockchain_storage::check_tx_inputs(const Transaction& tx, uint64_t& max_used_block_height, crypto::hash& max_used_block_id, BlockInfo* tail) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
 
   if (tail)
     tail->id = get_tail_id(tail->height);
@@ -1398,7 +1644,7 @@ bool blockchain_storage::check_tx_inputs(const Transaction& tx, uint64_t& max_us
   bool res = check_tx_inputs(tx, &max_used_block_height);
   if (!res) return false;
   CHECK_AND_ASSERT_MES(max_used_block_height < m_blocks.size(), false, "internal error: max used block index=" << max_used_block_height << " is not less then blockchain size = " << m_blocks.size());
-  get_block_hash(m_blocks[max_used_block_height].bl, max_used_block_id);
+  get_block_hash(m_blocks[max_used_block_height]->bl, max_used_block_id);
   return true;
 }
 
@@ -1420,11 +1666,37 @@ bool blockchain_storage::check_tx_inputs(const Transaction& tx, uint64_t* pmax_u
 }
 
 bool blockchain_storage::check_tx_inputs(const Transaction& tx, const crypto::hash& tx_prefix_hash, uint64_t* pmax_used_block_height) {
-  size_t inputIndex = 0;
+  std::vector<CryptoNote::RingSignatureVerifier::Check> ringSignatureChecks;
+  uint64_t maxUsedBlockHeight = 0;
+  if (!check_tx_inputs(tx, tx_prefix_hash, &maxUsedBlockHeight, ringSignatureChecks)) {
+    return false;
+  }
+
   if (pmax_used_block_height) {
-    *pmax_used_block_height = 0;
+    *pmax_used_block_height = maxUsedBlockHeight;
   }
 
+  if (!m_ringSignatureVerifier.verify(ringSignatureChecks)) {
+    LOG_PRINT_L0("Failed to check ring signature for tx " << get_transaction_hash(tx));
+    return false;
+  }
+
+  if (!ringSignatureChecks.empty() && maxUsedBlockHeight < m_blockIndex.size()) {
+    BlockInfo maxUsedBlock;
+    maxUsedBlock.height = maxUsedBlockHeight;
+    maxUsedBlock.id = m_blockIndex.getBlockId(maxUsedBlockHeight);
+    m_verifiedTransactions.add(get_transaction_hash(tx), maxUsedBlock);
+  }
+
+  return true;
+}
+
+bool blockchain_storage::check_tx_inputs(const Transaction& tx, const crypto::hash& tx_prefix_hash, uint64_t* pmax_used_block_height,
+  std::vector<CryptoNote::RingSignatureVerifier::Check>& ringSignatureChecks) {
+  size_t inputIndex = 0;
+  uint64_t maxUsedBlockHeight = 0;
+  size_t firstRingSignatureCheck = ringSignatureChecks.size();
+
   crypto::hash transactionHash = get_transaction_hash(tx);
   for (const auto& txin : tx.vin) {
     assert(inputIndex < tx.signatures.size());
@@ -1437,7 +1709,7 @@ bool blockchain_storage::check_tx_inputs(const Transaction& tx, const crypto::ha
         return false;
       }
 
-      if (!check_tx_input(in_to_key, tx_prefix_hash, tx.signatures[inputIndex], pmax_used_block_height)) {
+      if (!check_tx_input(in_to_key, tx_prefix_hash, tx.signatures[inputIndex], &maxUsedBlockHeight, ringSignatureChecks)) {
         LOG_PRINT_L0("Failed to check ring signature for tx " << transactionHash);
         return false;
       }
@@ -1455,6 +1727,18 @@ bool blockchain_storage::check_tx_inputs(const Transaction& tx, const crypto::ha
     }
   }
 
+  if (pmax_used_block_height) {
+    *pmax_used_block_height = maxUsedBlockHeight;
+  }
+
+  // ring members are resolved above, signatures of a transaction verified against the same ring members are not checked again
+  BlockInfo verifiedMaxUsedBlock;
+  if (ringSignatureChecks.size() > firstRingSignatureCheck && m_verifiedTransactions.find(transactionHash, verifiedMaxUsedBlock) &&
+    verifiedMaxUsedBlock.height == maxUsedBlockHeight && maxUsedBlockHeight < m_blockIndex.size() &&
+    verifiedMaxUsedBlock.id == m_blockIndex.getBlockId(maxUsedBlockHeight)) {
+    ringSignatureChecks.resize(firstRingSignatureCheck);
+  }
+
   return true;
 }
 
@@ -1477,8 +1761,9 @@ bool blockchain_storage::is_tx_spendtime_unlocked(uint64_t unlock_time) {
   return false;
 }
 
-bool blockchain_storage::check_tx_input(const TransactionInputToKey& txin, const crypto::hash& tx_prefix_hash, const std::vector<crypto::signature>& sig, uint64_t* pmax_related_block_height) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+bool blockchain_storage::check_tx_input(const TransactionInputToKey& txin, const crypto::hash& tx_prefix_hash, const std::vector<crypto::signature>& sig, uint64_t* pmax_related_block_height,
+  std::vector<CryptoNote::RingSignatureVerifier::Check>& ringSignatureChecks) {
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
 
   struct outputs_visitor
   {
@@ -1486,20 +1771,14 @@ bool blockchain_storage::check_tx_input(const TransactionInputToKey& txin, const
     blockchain_storage& m_bch;
     outputs_visitor(std::vector<const crypto::public_key *>& results_collector, blockchain_storage& bch) :m_results_collector(results_collector), m_bch(bch)
     {}
-    bool handle_output(const Transaction& tx, const TransactionOutput& out) {
+    bool handle_output(const CryptoNote::OutputIndex::OutputKey& out) {
       //check tx unlock time
-      if (!m_bch.is_tx_spendtime_unlocked(tx.unlockTime)) {
-        LOG_PRINT_L0("One of outputs for one of inputs have wrong tx.unlockTime = " << tx.unlockTime);
+      if (!m_bch.is_tx_spendtime_unlocked(out.unlockTime)) {
+        LOG_PRINT_L0("One of outputs for one of inputs have wrong tx.unlockTime = " << out.unlockTime);
         return false;
       }
 
-      if (out.target.type() != typeid(TransactionOutputToKey))
-      {
-        LOG_PRINT_L0("Output have wrong type id, which=" << out.target.which());
-        return false;
-      }
-
-      m_results_collector.push_back(&boost::get<TransactionOutputToKey>(out.target).key);
+      m_results_collector.push_back(&out.key);
       return true;
     }
   };
@@ -1523,7 +1802,15 @@ bool blockchain_storage::check_tx_input(const TransactionInputToKey& txin, const
     return true;
   }
 
-  return crypto::check_ring_signature(tx_prefix_hash, txin.keyImage, output_keys, sig.data());
+  // output keys may move when the outputs of the following transactions are indexed, so the check keeps copies
+  CryptoNote::RingSignatureVerifier::Check check = { tx_prefix_hash, txin.keyImage, {}, sig };
+  check.keys.reserve(output_keys.size());
+  for (const crypto::public_key* key : output_keys) {
+    check.keys.push_back(*key);
+  }
+
+  ringSignatureChecks.push_back(std::move(check));
+  return true;
 }
 
 uint64_t blockchain_storage::get_adjusted_time() {
@@ -1538,9 +1825,9 @@ bool blockchain_storage::check_block_timestamp_main(const Block& b) {
   }
 
   std::vector<uint64_t> timestamps;
-  size_t offset = m_blocks.size() <= m_currency.timestampCheckWindow() ? 0 : m_blocks.size() - m_currency.timestampCheckWindow();
-  for (; offset != m_blocks.size(); ++offset) {
-    timestamps.push_back(m_blocks[offset].bl.timestamp);
+  size_t offset = m_blockHeaders.size() <= m_currency.timestampCheckWindow() ? 0 : m_blockHeaders.size() - m_currency.timestampCheckWindow();
+  for (; offset != m_blockHeaders.size(); ++offset) {
+    timestamps.push_back(m_blockHeaders.timestamp(offset));
   }
 
   return check_block_timestamp(std::move(timestamps), b);
@@ -1649,7 +1936,7 @@ bool blockchain_storage::add_new_block(const Block& bl_, block_verification_cont
 
   bool add_result;
   CRITICAL_REGION_BEGIN(m_tx_pool);//to avoid deadlock lets lock tx_pool for whole add/reorganize process
-  CRITICAL_REGION_BEGIN1(m_blockchain_lock);
+  EXCLUSIVE_CRITICAL_REGION_BEGIN(m_blockchain_lock);
   if (have_block(id)) {
     LOG_PRINT_L3("block with id = " << id << " already exists");
     bvc.m_already_exists = true;
@@ -1674,12 +1961,14 @@ bool blockchain_storage::add_new_block(const Block& bl_, block_verification_cont
   return add_result;
 }
 
-const blockchain_storage::TransactionEntry& blockchain_storage::transactionByIndex(TransactionIndex index) {
-  return m_blocks[index.block].transactions[index.transaction];
+std::shared_ptr<const blockchain_storage::TransactionEntry> blockchain_storage::transactionByIndex(TransactionIndex index) {
+  // the transaction keeps its block alive
+  Blocks::ItemPtr block = m_blocks[index.block];
+  return std::shared_ptr<const TransactionEntry>(block, &block->transactions[index.transaction]);
 }
 
 bool blockchain_storage::pushBlock(const Block& blockData, block_verification_context& bvc) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  EXCLUSIVE_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   TIME_MEASURE_START(block_processing_time);
 
   crypto::hash blockHash = get_block_hash(blockData);
@@ -1726,7 +2015,7 @@ bool blockchain_storage::pushBlock(const Block& blockData, block_verification_co
       return false;
     }
   } else {
-    if (!m_currency.checkProofOfWork(m_cn_context, blockData, currentDifficulty, proof_of_work)) {
+    if (!checkProofOfWork(blockData, blockHash, currentDifficulty, proof_of_work)) {
       LOG_PRINT_L0("Block " << blockHash << ", has too weak proof of work: " << proof_of_work << ", expected difficulty: " << currentDifficulty);
       bvc.m_verifivation_failed = true;
       return false;
@@ -1753,6 +2042,7 @@ bool blockchain_storage::pushBlock(const Block& blockData, block_verification_co
   size_t coinbase_blob_size = get_object_blobsize(blockData.minerTx);
   size_t cumulative_block_size = coinbase_blob_size;
   uint64_t fee_summary = 0;
+  std::vector<CryptoNote::RingSignatureVerifier::Check> ringSignatureChecks;
   for (const crypto::hash& tx_id : blockData.txHashes) {
     block.transactions.resize(block.transactions.size() + 1);
     size_t blob_size = 0;
@@ -1760,13 +2050,14 @@ bool blockchain_storage::pushBlock(const Block& blockData, block_verification_co
     if (!m_tx_pool.take_tx(tx_id, block.transactions.back().tx, blob_size, fee)) {
       LOG_PRINT_L0("Block " << blockHash << " has at least one unknown transaction: " << tx_id);
       bvc.m_verifivation_failed = true;
+      bvc.m_missing_transactions = true;
       tx_verification_context tvc = ::AUTO_VAL_INIT(tvc);
       block.transactions.pop_back();
       popTransactions(block, minerTransactionHash);
       return false;
     }
 
-    if (!check_tx_inputs(block.transactions.back().tx)) {
+    if (!check_tx_inputs(block.transactions.back().tx, get_transaction_prefix_hash(block.transactions.back().tx), nullptr, ringSignatureChecks)) {
       LOG_PRINT_L0("Block " << blockHash << " has at least one transaction with wrong inputs: " << tx_id);
       bvc.m_verifivation_failed = true;
       tx_verification_context tvc = ::AUTO_VAL_INIT(tvc);
@@ -1786,6 +2077,14 @@ bool blockchain_storage::pushBlock(const Block& blockData, block_verification_co
     fee_summary += fee;
   }
 
+  // ring signatures of all transactions are verified in parallel, after the sequential checks have passed
+  if (!m_ringSignatureVerifier.verify(ringSignatureChecks)) {
+    LOG_PRINT_L0("Block " << blockHash << " has at least one transaction with invalid ring signature");
+    bvc.m_verifivation_failed = true;
+    popTransactions(block, minerTransactionHash);
+    return false;
+  }
+
   if (!checkCumulativeBlockSize(blockHash, cumulative_block_size, m_blocks.size())) {
     bvc.m_verifivation_failed = true;
     return false;
@@ -1793,7 +2092,7 @@ bool blockchain_storage::pushBlock(const Block& blockData, block_verification_co
 
   int64_t emissionChange = 0;
   uint64_t reward = 0;
-  uint64_t already_generated_coins = m_blocks.empty() ? 0 : m_blocks.back().already_generated_coins;
+  uint64_t already_generated_coins = m_blockHeaders.empty() ? 0 : m_blockHeaders.alreadyGeneratedCoins(m_blockHeaders.size() - 1);
   if (!validate_miner_transaction(blockData, m_blocks.size(), cumulative_block_size, already_generated_coins, fee_summary, reward, emissionChange)) {
     LOG_PRINT_L0("Block " << blockHash << " has invalid miner transaction");
     bvc.m_verifivation_failed = true;
@@ -1805,8 +2104,8 @@ bool blockchain_storage::pushBlock(const Block& blockData, block_verification_co
   block.block_cumulative_size = cumulative_block_size;
   block.cumulative_difficulty = currentDifficulty;
   block.already_generated_coins = already_generated_coins + emissionChange;
-  if (m_blocks.size() > 0) {
-    block.cumulative_difficulty += m_blocks.back().cumulative_difficulty;
+  if (!m_blockHeaders.empty()) {
+    block.cumulative_difficulty += m_blockHeaders.cumulativeDifficulty(m_blockHeaders.size() - 1);
   }
 
   pushBlock(block);
@@ -1822,17 +2121,112 @@ bool blockchain_storage::pushBlock(const Block& blockData, block_verification_co
 
   m_upgradeDetector.blockPushed();
   update_next_comulative_size_limit();
+  m_tx_pool.on_blockchain_inc(m_blocks.size(), blockHash);
 
   return true;
 }
 
+void blockchain_storage::precomputeLongHashes(const std::vector<Block>& blocks) {
+  if (blocks.empty() || m_checkpoints.is_in_checkpoint_zone(get_current_blockchain_height() + blocks.size() - 1)) {
+    return;
+  }
+
+  // blocks failing the cheap checks aren't added anyway: the ones not continuing a known block or each other, or
+  // from too far in the future. Known blocks aren't added again.
+  std::vector<Block> hashed;
+  uint64_t maxTimestamp = get_adjusted_time() + m_currency.blockFutureTimeLimit();
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    const Block& block = blocks[i];
+    if (i == 0 ? !have_block(block.prevId) : block.prevId != get_block_hash(blocks[i - 1])) {
+      break;
+    }
+
+    if (block.timestamp > maxTimestamp) {
+      break;
+    }
+
+    if (!have_block(get_block_hash(block))) {
+      hashed.push_back(block);
+    }
+  }
+
+  // hashed by the workers while the blocks are added, proof of work is checked with the hashes once they are done
+  m_longHashCalculator.submit(hashed);
+}
+
+bool blockchain_storage::startHeaderChain(uint64_t height, const crypto::hash& prevId, CryptoNote::BlockHeaderChain& chain) {
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  if (height == 0 || height > m_blocks.size() || m_blockIndex.getBlockId(height - 1) != prevId) {
+    return false;
+  }
+
+  std::vector<uint64_t> timestamps;
+  std::vector<difficulty_type> cumulativeDifficulties;
+  for (uint64_t i = height - std::min<uint64_t>(height, chain.windowSize()); i < height; ++i) {
+    timestamps.push_back(m_blockHeaders.timestamp(i));
+    cumulativeDifficulties.push_back(m_blockHeaders.cumulativeDifficulty(i));
+  }
+
+  chain.reset(height, prevId, timestamps, cumulativeDifficulties);
+  return true;
+}
+
+bool blockchain_storage::checkBlockHeaders(CryptoNote::BlockHeaderChain& chain, const std::vector<Block>& headers) {
+  if (headers.empty()) {
+    return true;
+  }
+
+  // the long hashes are computed only for headers passing the other checks, the bodies of these blocks are downloaded
+  // next and adding them then takes the hashes computed here
+  std::vector<difficulty_type> difficulties;
+  size_t count = chain.check(headers, m_checkpoints, get_adjusted_time(), difficulties);
+  std::vector<Block> hashed;
+  for (size_t i = 0; i < count; ++i) {
+    if (!m_checkpoints.is_in_checkpoint_zone(chain.height() + i)) {
+      hashed.push_back(headers[i]);
+    }
+  }
+
+  m_longHashCalculator.submit(hashed);
+  std::vector<crypto::hash> longHashes(count, null_hash);
+  // allocates its scratchpad only if some hash has to be computed here
+  std::unique_ptr<crypto::cn_context> context;
+  for (size_t i = 0; i < count; ++i) {
+    if (!m_checkpoints.is_in_checkpoint_zone(chain.height() + i) && !m_longHashCalculator.get(get_block_hash(headers[i]), longHashes[i])) {
+      // dropped meanwhile, computed here then
+      if (!context) {
+        context.reset(new crypto::cn_context());
+      }
+
+      if (!get_block_longhash(*context, headers[i], longHashes[i])) {
+        return false;
+      }
+    }
+  }
+
+  return chain.append(headers, difficulties, longHashes, m_checkpoints) && count == headers.size();
+}
+
+bool blockchain_storage::checkProofOfWork(const Block& block, const crypto::hash& blockHash, difficulty_type currentDifficulty, crypto::hash& proofOfWork) {
+  if (m_longHashCalculator.take(blockHash, proofOfWork)) {
+    return m_currency.checkProofOfWork(block, currentDifficulty, proofOfWork);
+  }
+
+  return m_currency.checkProofOfWork(m_cn_context, block, currentDifficulty, proofOfWork);
+}
+
 bool blockchain_storage::pushBlock(BlockEntry& block) {
   crypto::hash blockHash = get_block_hash(block.bl);
 
   m_blocks.push_back(block);
   m_blockIndex.push(blockHash);
+  m_blockHeaders.push(block.bl.timestamp, block.cumulative_difficulty, block.block_cumulative_size, block.already_generated_coins);
+  // push_back recorded the blob locations in the entry while serializing it
+  pushBlockBlobs(block);
 
   assert(m_blockIndex.size() == m_blocks.size());
+  assert(m_blockHeaders.size() == m_blocks.size());
+  assert(m_blockBlobs.size() == m_blocks.size());
 
   return true;
 }
@@ -1843,13 +2237,20 @@ void blockchain_storage::popBlock(const crypto::hash& blockHash) {
     return;
   }
 
-  popTransactions(m_blocks.back(), get_transaction_hash(m_blocks.back().bl.minerTx));
+  BlockEntry block = *m_blocks.back();
+  appendCacheJournal(block);
+  popTransactions(block, get_transaction_hash(block.bl.minerTx));
   m_blocks.pop_back();
   m_blockIndex.pop();
+  m_blockHeaders.pop();
+  m_blockBlobs.pop();
 
   assert(m_blockIndex.size() == m_blocks.size());
+  assert(m_blockHeaders.size() == m_blocks.size());
+  assert(m_blockBlobs.size() == m_blocks.size());
 
   m_upgradeDetector.blockPopped();
+  m_tx_pool.on_blockchain_dec(m_blocks.size(), m_blocks.empty() ? null_hash : m_blockIndex.getTailId());
 }
 
 bool blockchain_storage::pushTransaction(BlockEntry& block, const crypto::hash& transactionHash, TransactionIndex transactionIndex) {
@@ -1893,9 +2294,9 @@ bool blockchain_storage::pushTransaction(BlockEntry& block, const crypto::hash&
   transaction.m_global_output_indexes.resize(transaction.tx.vout.size());
   for (uint16_t output = 0; output < transaction.tx.vout.size(); ++output) {
     if (transaction.tx.vout[output].target.type() == typeid(TransactionOutputToKey)) {
-      auto& amountOutputs = m_outputs[transaction.tx.vout[output].amount];
-      transaction.m_global_output_indexes[output] = amountOutputs.size();
-      amountOutputs.push_back(std::make_pair<>(transactionIndex, output));
+      const TransactionOutput& out = transaction.tx.vout[output];
+      transaction.m_global_output_indexes[output] = m_outputs.push(out.amount, transactionIndex.block, transactionIndex.transaction, output,
+        ::boost::get<TransactionOutputToKey>(out.target).key, transaction.tx.unlockTime);
     } else if (transaction.tx.vout[output].target.type() == typeid(TransactionOutputMultisignature)) {
       auto& amountOutputs = m_multisignatureOutputs[transaction.tx.vout[output].amount];
       transaction.m_global_output_indexes[output] = amountOutputs.size();
@@ -1912,31 +2313,23 @@ void blockchain_storage::popTransaction(const Transaction& transaction, const cr
   for (size_t outputIndex = 0; outputIndex < transaction.vout.size(); ++outputIndex) {
     const TransactionOutput& output = transaction.vout[transaction.vout.size() - 1 - outputIndex];
     if (output.target.type() == typeid(TransactionOutputToKey)) {
-      auto amountOutputs = m_outputs.find(output.amount);
-      if (amountOutputs == m_outputs.end()) {
+      const CryptoNote::OutputIndex::AmountOutputs* amountOutputs = m_outputs.find(output.amount);
+      if (amountOutputs == nullptr) {
         LOG_ERROR("Blockchain consistency broken - cannot find specific amount in outputs map.");
         continue;
       }
 
-      if (amountOutputs->second.empty()) {
-        LOG_ERROR("Blockchain consistency broken - output array for specific amount is empty.");
-        continue;
-      }
-
-      if (amountOutputs->second.back().first.block != transactionIndex.block || amountOutputs->second.back().first.transaction != transactionIndex.transaction) {
+      if (amountOutputs->outputs.back().block != transactionIndex.block || amountOutputs->outputs.back().transaction != transactionIndex.transaction) {
         LOG_ERROR("Blockchain consistency broken - invalid transaction index.");
         continue;
       }
 
-      if (amountOutputs->second.back().second != transaction.vout.size() - 1 - outputIndex) {
+      if (amountOutputs->outputs.back().output != transaction.vout.size() - 1 - outputIndex) {
         LOG_ERROR("Blockchain consistency broken - invalid output index.");
         continue;
       }
 
-      amountOutputs->second.pop_back();
-      if (amountOutputs->second.empty()) {
-        m_outputs.erase(amountOutputs);
-      }
+      m_outputs.pop(output.amount);
     } else if (output.target.type() == typeid(TransactionOutputMultisignature)) {
       auto amountOutputs = m_multisignatureOutputs.find(output.amount);
       if (amountOutputs == m_multisignatureOutputs.end()) {
@@ -2025,7 +2418,8 @@ bool blockchain_storage::validateInput(const TransactionInputMultisignature& inp
     return false;
   }
 
-  const Transaction& outputTransaction = m_blocks[outputIndex.transactionIndex.block].transactions[outputIndex.transactionIndex.transaction].tx;
+  Blocks::ItemPtr outputBlock = m_blocks[outputIndex.transactionIndex.block];
+  const Transaction& outputTransaction = outputBlock->transactions[outputIndex.transactionIndex.transaction].tx;
   if (!is_tx_spendtime_unlocked(outputTransaction.unlockTime)) {
     LOG_PRINT_L1("Transaction << " << transactionHash << " contains multisignature input which points to a locked transaction.");
     return false;
@@ -2058,24 +2452,27 @@ bool blockchain_storage::validateInput(const TransactionInputMultisignature& inp
 }
 
 bool blockchain_storage::getLowerBound(uint64_t timestamp, uint64_t startOffset, uint64_t& height) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   
-  if (startOffset >= m_blocks.size()) {
+  if (startOffset >= m_blockHeaders.size()) {
     return false;
   }
 
-  auto bound = std::lower_bound(m_blocks.begin() + startOffset, m_blocks.end(), timestamp - m_currency.blockFutureTimeLimit(),
-    [](const BlockEntry& b, uint64_t timestamp) { return b.bl.timestamp < timestamp; });
-
-  if (bound == m_blocks.end()) {
+  uint64_t bound = m_blockHeaders.timestampLowerBound(startOffset, timestamp - m_currency.blockFutureTimeLimit());
+  if (bound == m_blockHeaders.size()) {
     return false;
   }
 
-  height = std::distance(m_blocks.begin(), bound);
+  height = bound;
   return true;
 }
 
 bool blockchain_storage::getBlockIds(uint64_t startHeight, size_t maxCount, std::list<crypto::hash>& items) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   return m_blockIndex.getBlockIds(startHeight, maxCount, items);
 }
+
+uint64_t blockchain_storage::getBlockTimestamp(uint64_t height) {
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  return m_blockHeaders.timestamp(height);
+}
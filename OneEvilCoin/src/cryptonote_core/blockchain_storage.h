@@ -18,24 +18,33 @@
 #pragma once
 
 #include <atomic>
+#include <fstream>
 
 #include "google/sparse_hash_set"
-#include "google/sparse_hash_map"
 
 #include "common/ObserverManager.h"
 #include "common/util.h"
+#include "math_helper.h"
+#include "cryptonote_core/BlockBlobIndex.h"
+#include "cryptonote_core/BlockHeaderCache.h"
+#include "cryptonote_core/BlockHeaderChain.h"
 #include "cryptonote_core/BlockIndex.h"
 #include "cryptonote_core/checkpoints.h"
 #include "cryptonote_core/Currency.h"
 #include "cryptonote_core/IBlockchainStorageObserver.h"
+#include "cryptonote_core/LongHashCalculator.h"
 #include "cryptonote_core/ITransactionValidator.h"
+#include "cryptonote_core/OutputIndex.h"
+#include "cryptonote_core/RingSignatureVerifier.h"
 #include "cryptonote_core/SwappedVector.h"
 #include "cryptonote_core/UpgradeDetector.h"
+#include "cryptonote_core/VerifiedTransactionCache.h"
 #include "cryptonote_core/cryptonote_format_utils.h"
 #include "cryptonote_core/tx_pool.h"
 
 
 namespace cryptonote {
+  struct block_complete_entry;
   struct NOTIFY_RESPONSE_CHAIN_ENTRY_request;
   struct NOTIFY_REQUEST_GET_OBJECTS_request;
   struct NOTIFY_RESPONSE_GET_OBJECTS_request;
@@ -59,13 +68,25 @@ namespace cryptonote {
     bool init() { return init(tools::get_default_data_dir(), true); }
     bool init(const std::string& config_folder, bool load_existing);
     bool deinit();
+    void on_idle();
+    // Writes a snapshot of the internal structures, after which the cache journal is truncated
+    bool storeCache();
 
     bool getLowerBound(uint64_t timestamp, uint64_t startOffset, uint64_t& height);
     bool getBlockIds(uint64_t startHeight, size_t maxCount, std::list<crypto::hash>& items);
+    uint64_t getBlockTimestamp(uint64_t height);
 
     void set_checkpoints(checkpoints&& chk_pts) { m_checkpoints = chk_pts; }
     bool get_blocks(uint64_t start_offset, size_t count, std::list<Block>& blocks, std::list<Transaction>& txs);
     bool get_blocks(uint64_t start_offset, size_t count, std::list<Block>& blocks);
+    // Raw block and transaction blobs are copied from the stored entries, which are neither deserialized nor
+    // serialized again
+    bool getRawBlock(uint64_t height, block_complete_entry& rawBlock);
+    void getRawTransactions(const std::list<crypto::hash>& txs_ids, std::list<blobdata>& txs, std::list<crypto::hash>& missed_txs);
+    // Number of block entries deserialized from the block storage since init
+    uint64_t getBlockEntryLoads();
+    // Pages backing the scratchpad proof of work of received blocks is checked with
+    crypto::scratchpad_pages getScratchpadPages() const { return m_cn_context.pages(); }
     bool get_alternative_blocks(std::list<Block>& blocks);
     size_t get_alternative_blocks_count();
     crypto::hash get_block_id_by_height(uint64_t height);
@@ -91,6 +112,7 @@ namespace cryptonote {
     bool find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, uint64_t& starter_offset); // !!!!
     bool find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, NOTIFY_RESPONSE_CHAIN_ENTRY_request& resp);
     bool find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, std::list<std::pair<Block, std::list<Transaction>>>& blocks, uint64_t& total_height, uint64_t& start_height, size_t max_count);
+    bool find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, std::list<block_complete_entry>& blocks, uint64_t& total_height, uint64_t& start_height, size_t max_count);
     bool handle_get_objects(NOTIFY_REQUEST_GET_OBJECTS_request& arg, NOTIFY_RESPONSE_GET_OBJECTS_request& rsp);
     bool get_random_outs_for_amounts(const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_request& req, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_response& res);
     bool get_backward_blocks_sizes(size_t from_height, std::vector<size_t>& sz, size_t count);
@@ -100,11 +122,21 @@ namespace cryptonote {
     bool is_storing_blockchain(){return m_is_blockchain_storing;}
     uint64_t block_difficulty(size_t i);
     bool getPoolSymmetricDifference(const std::vector<crypto::hash>& known_pool_tx_ids, const crypto::hash& known_block_id, std::vector<Transaction>& new_txs, std::vector<crypto::hash>& deleted_tx_ids);
+    bool getPoolChanges(const crypto::hash& knownBlockId, uint64_t knownPoolVersion, bool& isPoolVersionActual, uint64_t& poolVersion,
+      std::vector<Transaction>& newTxs, std::vector<crypto::hash>& deletedTxIds);
+    // Queues the blocks passing cheap checks for computing their long hashes on the hashing workers, so that adding them
+    // afterwards mostly compares the hashes with the difficulty
+    void precomputeLongHashes(const std::vector<Block>& blocks);
+    // Starts the header chain after prevId, fails unless it is the main chain block at height - 1
+    bool startHeaderChain(uint64_t height, const crypto::hash& prevId, CryptoNote::BlockHeaderChain& chain);
+    // Checks the headers continuing the header chain, computing long hashes on the hashing workers for the headers
+    // passing the other checks; the long hashes are kept for adding the blocks later
+    bool checkBlockHeaders(CryptoNote::BlockHeaderChain& chain, const std::vector<Block>& headers);
 
 
     template<class t_ids_container, class t_blocks_container, class t_missed_container>
     bool get_blocks(const t_ids_container& block_ids, t_blocks_container& blocks, t_missed_container& missed_bs) {
-      CRITICAL_REGION_LOCAL(m_blockchain_lock);
+      SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
 
       for (const auto& bl_id : block_ids) {
         uint64_t height = 0;
@@ -113,7 +145,7 @@ namespace cryptonote {
         } else {
           CHECK_AND_ASSERT_MES(height < m_blocks.size(), false, "Internal error: bl_id=" << epee::string_tools::pod_to_hex(bl_id)
             << " have index record with offset=" << height << ", bigger then m_blocks.size()=" << m_blocks.size());
-            blocks.push_back(m_blocks[height].bl);
+            blocks.push_back(m_blocks[height]->bl);
         }
       }
 
@@ -122,14 +154,14 @@ namespace cryptonote {
 
     template<class t_ids_container, class t_tx_container, class t_missed_container>
     void get_transactions(const t_ids_container& txs_ids, t_tx_container& txs, t_missed_container& missed_txs, bool checkTxPool = false) {
-      CRITICAL_REGION_LOCAL(m_blockchain_lock);
+      SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
 
       for (const auto& tx_id : txs_ids) {
         auto it = m_transactionMap.find(tx_id);
         if (it == m_transactionMap.end()) {
           missed_txs.push_back(tx_id);
         } else {
-          txs.push_back(transactionByIndex(it->second).tx);
+          txs.push_back(transactionByIndex(it->second)->tx);
         }
       }
 
@@ -146,14 +178,23 @@ namespace cryptonote {
     void print_blockchain_outs(const std::string& file);
 
   private:
+    template<template<bool> class Archive> static std::streamoff archivePosition(Archive<false>& ar) { return ar.stream().tellg(); }
+    template<template<bool> class Archive> static std::streamoff archivePosition(Archive<true>& ar) { return ar.stream().tellp(); }
+
     struct TransactionEntry {
       Transaction tx;
       std::vector<uint32_t> m_global_output_indexes;
+      // Location of the transaction blob inside the serialized BlockEntry, not serialized itself
+      uint32_t blobOffset = 0;
+      uint32_t blobSize = 0;
 
       template<class archive_t> void serialize(archive_t & ar, unsigned int version);
 
       BEGIN_SERIALIZE_OBJECT()
+        std::streamoff begin = archivePosition(ar);
         FIELD(tx)
+        blobOffset = static_cast<uint32_t>(begin);
+        blobSize = static_cast<uint32_t>(archivePosition(ar) - begin);
         FIELD(m_global_output_indexes)
       END_SERIALIZE()
     };
@@ -165,16 +206,23 @@ namespace cryptonote {
       difficulty_type cumulative_difficulty;
       uint64_t already_generated_coins;
       std::vector<TransactionEntry> transactions;
+      // The block blob is the first blockBlobSize bytes of the serialized entry, not serialized itself
+      uint32_t blockBlobSize = 0;
 
       template<class Archive> void serialize(Archive& archive, unsigned int version);
 
       BEGIN_SERIALIZE_OBJECT()
+        std::streamoff begin = archivePosition(ar);
         FIELD(bl)
+        blockBlobSize = static_cast<uint32_t>(archivePosition(ar) - begin);
         VARINT_FIELD(height)
         VARINT_FIELD(block_cumulative_size)
         VARINT_FIELD(cumulative_difficulty)
         VARINT_FIELD(already_generated_coins)
         FIELD(transactions)
+        for (TransactionEntry& transaction : transactions) {
+          transaction.blobOffset -= static_cast<uint32_t>(begin);
+        }
       END_SERIALIZE()
     };
 
@@ -195,19 +243,18 @@ namespace cryptonote {
 
     typedef google::sparse_hash_set<crypto::key_image> key_images_container;
     typedef std::unordered_map<crypto::hash, BlockEntry> blocks_ext_by_hash;
-    typedef google::sparse_hash_map<uint64_t, std::vector<std::pair<TransactionIndex, uint16_t>>> outputs_container; //crypto::hash - tx hash, size_t - index of out in transaction
     typedef std::map<uint64_t, std::vector<MultisignatureOutputUsage>> MultisignatureOutputsContainer;
 
     const Currency& m_currency;
     tx_memory_pool& m_tx_pool;
-    epee::critical_section m_blockchain_lock; // TODO: add here reader/writer lock
+    epee::shared_critical_section m_blockchain_lock;
     crypto::cn_context m_cn_context;
     tools::ObserverManager<IBlockchainStorageObserver> m_observerManager;
 
     key_images_container m_spent_keys;
     size_t m_current_block_cumul_sz_limit;
     blocks_ext_by_hash m_alternative_chains; // crypto::hash -> block_extended_info
-    outputs_container m_outputs;
+    CryptoNote::OutputIndex m_outputs;
 
     std::string m_config_folder;
     checkpoints m_checkpoints;
@@ -219,15 +266,33 @@ namespace cryptonote {
     typedef std::unordered_map<crypto::hash, TransactionIndex> TransactionMap;
     typedef BasicUpgradeDetector<Blocks> UpgradeDetector;
 
+    // Blocks popped since the last cache snapshot, needed to roll the snapshot back to the stored chain
+    std::mutex m_cacheStoreMutex;
+    std::mutex m_cacheJournalMutex; // guards the journal and the snapshot heights
+    std::ofstream m_cacheJournal;
+    uint64_t m_cacheSnapshotHeight;
+    epee::math_helper::once_a_time_seconds<60 * 10, false> m_cacheSnapshotInterval;
+
     friend class BlockCacheSerializer;
 
     Blocks m_blocks;
     CryptoNote::BlockIndex m_blockIndex;
+    CryptoNote::BlockHeaderCache m_blockHeaders;
+    CryptoNote::BlockBlobIndex m_blockBlobs;
     TransactionMap m_transactionMap;
     MultisignatureOutputsContainer m_multisignatureOutputs;
     UpgradeDetector m_upgradeDetector;
-
-    bool storeCache();
+    CryptoNote::RingSignatureVerifier m_ringSignatureVerifier;
+    CryptoNote::LongHashCalculator m_longHashCalculator;
+    CryptoNote::VerifiedTransactionCache m_verifiedTransactions;
+
+    bool checkProofOfWork(const Block& block, const crypto::hash& blockHash, difficulty_type currentDifficulty, crypto::hash& proofOfWork);
+    bool isCacheSnapshotStale();
+    bool replayCacheJournal();
+    void appendCacheJournal(BlockEntry& block);
+    void pushBlockCache(uint32_t height);
+    void pushBlockBlobs(const BlockEntry& block);
+    void popBlockCache(const BlockEntry& block);
     template<class visitor_t> bool scan_outputkeys_for_indexes(const TransactionInputToKey& tx_in_to_key, visitor_t& vis, uint64_t* pmax_related_block_height = NULL);
     bool switch_to_alternative_blockchain(std::list<blocks_ext_by_hash::iterator>& alt_chain, bool discard_disconnected_chain);
     bool handle_alternative_block(const Block& b, const crypto::hash& id, block_verification_context& bvc);
@@ -237,9 +302,9 @@ namespace cryptonote {
     bool validate_transaction(const Block& b, uint64_t height, const Transaction& tx);
     bool rollback_blockchain_switching(std::list<Block>& original_chain, size_t rollback_height);
     bool get_last_n_blocks_sizes(std::vector<size_t>& sz, size_t count);
-    bool add_out_to_get_random_outs(std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_outs_for_amount& result_outs, uint64_t amount, size_t i);
+    bool add_out_to_get_random_outs(const CryptoNote::OutputIndex::OutputKeys& amount_keys, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_outs_for_amount& result_outs, uint64_t amount, size_t i);
     bool is_tx_spendtime_unlocked(uint64_t unlock_time);
-    size_t find_end_of_allowed_index(const std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs);
+    size_t find_end_of_allowed_index(uint64_t amount);
     bool check_block_timestamp_main(const Block& b);
     bool check_block_timestamp(std::vector<uint64_t> timestamps, const Block& b);
     uint64_t get_adjusted_time();
@@ -249,11 +314,14 @@ namespace cryptonote {
     bool checkCumulativeBlockSize(const crypto::hash& blockId, size_t cumulativeBlockSize, uint64_t height);
     bool getBlockCumulativeSize(const Block& block, size_t& cumulativeSize);
     bool update_next_comulative_size_limit();
-    bool check_tx_input(const TransactionInputToKey& txin, const crypto::hash& tx_prefix_hash, const std::vector<crypto::signature>& sig, uint64_t* pmax_related_block_height = NULL);
+    bool check_tx_input(const TransactionInputToKey& txin, const crypto::hash& tx_prefix_hash, const std::vector<crypto::signature>& sig, uint64_t* pmax_related_block_height,
+      std::vector<CryptoNote::RingSignatureVerifier::Check>& ringSignatureChecks);
+    // checks everything but ring signatures, which are appended to ringSignatureChecks to be verified in one batch
+    bool check_tx_inputs(const Transaction& tx, const crypto::hash& tx_prefix_hash, uint64_t* pmax_used_block_height, std::vector<CryptoNote::RingSignatureVerifier::Check>& ringSignatureChecks);
     bool check_tx_inputs(const Transaction& tx, const crypto::hash& tx_prefix_hash, uint64_t* pmax_used_block_height = NULL);
     bool check_tx_inputs(const Transaction& tx, uint64_t* pmax_used_block_height = NULL);
     bool have_tx_keyimg_as_spent(const crypto::key_image &key_im);
-    const TransactionEntry& transactionByIndex(TransactionIndex index);
+    std::shared_ptr<const TransactionEntry> transactionByIndex(TransactionIndex index);
     bool pushBlock(const Block& blockData, block_verification_context& bvc);
     bool pushBlock(BlockEntry& block);
     void popBlock(const crypto::hash& blockHash);
@@ -262,13 +330,33 @@ namespace cryptonote {
     void popTransactions(const BlockEntry& block, const crypto::hash& minerTransactionHash);
     bool validateInput(const TransactionInputMultisignature& input, const crypto::hash& transactionHash, const crypto::hash& transactionPrefixHash, const std::vector<crypto::signature>& transactionSignatures);
 
-    friend class LockedBlockchainStorage;
+    friend class ReadLockedBlockchainStorage;
+    friend class WriteLockedBlockchainStorage;
+  };
+
+  // Holds m_blockchain_lock shared for its lifetime. Any number of readers may run concurrently,
+  // but only methods that don't modify the blockchain may be called through it.
+  class ReadLockedBlockchainStorage: boost::noncopyable {
+  public:
+
+    ReadLockedBlockchainStorage(blockchain_storage& bc)
+      : m_bc(bc), m_lock(bc.m_blockchain_lock) {}
+
+    blockchain_storage* operator -> () {
+      return &m_bc;
+    }
+
+  private:
+
+    blockchain_storage& m_bc;
+    epee::shared_guard m_lock;
   };
 
-  class LockedBlockchainStorage: boost::noncopyable {
+  // Holds m_blockchain_lock exclusively for its lifetime.
+  class WriteLockedBlockchainStorage: boost::noncopyable {
   public:
 
-    LockedBlockchainStorage(blockchain_storage& bc)
+    WriteLockedBlockchainStorage(blockchain_storage& bc)
       : m_bc(bc), m_lock(bc.m_blockchain_lock) {}
 
     blockchain_storage* operator -> () {
@@ -278,17 +366,17 @@ namespace cryptonote {
   private:
 
     blockchain_storage& m_bc;
-    epee::critical_region_t<epee::critical_section> m_lock;
+    epee::exclusive_guard m_lock;
   };
 
   template<class visitor_t> bool blockchain_storage::scan_outputkeys_for_indexes(const TransactionInputToKey& tx_in_to_key, visitor_t& vis, uint64_t* pmax_related_block_height) {
-    CRITICAL_REGION_LOCAL(m_blockchain_lock);
-    auto it = m_outputs.find(tx_in_to_key.amount);
-    if (it == m_outputs.end() || !tx_in_to_key.keyOffsets.size())
+    SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+    const CryptoNote::OutputIndex::AmountOutputs* outputs = m_outputs.find(tx_in_to_key.amount);
+    if (outputs == nullptr || !tx_in_to_key.keyOffsets.size())
       return false;
 
     std::vector<uint64_t> absolute_offsets = relative_output_offsets_to_absolute(tx_in_to_key.keyOffsets);
-    std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs_vec = it->second;
+    const CryptoNote::OutputIndex::Outputs& amount_outs_vec = outputs->outputs;
     size_t count = 0;
     for (uint64_t i : absolute_offsets) {
       if(i >= amount_outs_vec.size() ) {
@@ -296,20 +384,15 @@ namespace cryptonote {
         return false;
       }
 
-      //auto tx_it = m_transactionMap.find(amount_outs_vec[i].first);
-      //CHECK_AND_ASSERT_MES(tx_it != m_transactionMap.end(), false, "Wrong transaction id in output indexes: " << epee::string_tools::pod_to_hex(amount_outs_vec[i].first));
-
-      const TransactionEntry& tx = transactionByIndex(amount_outs_vec[i].first);
-      CHECK_AND_ASSERT_MES(amount_outs_vec[i].second < tx.tx.vout.size(), false,
-        "Wrong index in transaction outputs: " << amount_outs_vec[i].second << ", expected less then " << tx.tx.vout.size());
-      if (!vis.handle_output(tx.tx, tx.tx.vout[amount_outs_vec[i].second])) {
+      const CryptoNote::OutputIndex::Output& out = amount_outs_vec[i];
+      if (!vis.handle_output(outputs->keys[i])) {
         LOG_PRINT_L0("Failed to handle_output for output no = " << count << ", with absolute offset " << i);
         return false;
       }
 
       if(count++ == absolute_offsets.size()-1 && pmax_related_block_height) {
-        if (*pmax_related_block_height < amount_outs_vec[i].first.block) {
-          *pmax_related_block_height = amount_outs_vec[i].first.block;
+        if (*pmax_related_block_height < out.block) {
+          *pmax_related_block_height = out.block;
         }
       }
     }
@@ -19,6 +19,7 @@
 
 #include <atomic>
 #include <list>
+#include <memory>
 #include <unordered_set>
 
 #include "net/net_utils_base.h"
@@ -26,6 +27,11 @@
 
 #include "crypto/hash.h"
 
+namespace CryptoNote
+{
+  class BlockHeaderChain;
+}
+
 namespace cryptonote
 {
 
@@ -43,8 +49,15 @@ namespace cryptonote
     state m_state;
     std::list<crypto::hash> m_needed_objects;
     std::unordered_set<crypto::hash> m_requested_objects;
+    uint8_t m_version; //protocol version of the peer
     uint64_t m_remote_blockchain_height;
     uint64_t m_last_response_height;
+    bool m_shares_download; //its chain is downloaded from many peers at once
+    bool m_waiting_for_blocks; //waits for a span of the shared block download
+    std::shared_ptr<CryptoNote::BlockHeaderChain> m_header_chain; //headers of its chain checked ahead of the blocks
+    std::list<crypto::hash> m_needed_headers;
+    std::list<crypto::hash> m_requested_headers;
+    crypto::hash m_requested_full_block; //block whose transactions were all requested from it
     epee::copyable_atomic m_callback_request_count; //in debug purpose: problem with double callback rise
     //size_t m_score;  TODO: add score calculations
   };
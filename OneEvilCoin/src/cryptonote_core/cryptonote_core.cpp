@@ -51,7 +51,12 @@ namespace cryptonote
               m_mempool(currency, m_blockchain_storage, m_timeProvider),
               m_blockchain_storage(currency, m_mempool),
               m_miner(new miner(currency, this)),
-              m_starter_message_showed(false)
+              m_starter_message_showed(false),
+              m_minerTemplateOutdated(false),
+              m_templateNotifier(0),
+              m_templateCache([this](Block& b, const AccountPublicAddress& adr, difficulty_type& diffic, uint64_t& height, const blobdata& ex_nonce) {
+                return m_blockchain_storage.create_block_template(b, adr, diffic, height, ex_nonce);
+              }, std::chrono::seconds(30))
   {
     set_cryptonote_protocol(pprotocol);
     m_blockchain_storage.addObserver(this);
@@ -105,9 +110,11 @@ namespace cryptonote
   {
     return m_blockchain_storage.get_blocks(start_offset, count, blocks);
   }  //-----------------------------------------------------------------------------------------------
-  void core::get_transactions(const std::vector<crypto::hash>& txs_ids, std::list<Transaction>& txs, std::list<crypto::hash>& missed_txs)
+  void core::get_transactions(const std::vector<crypto::hash>& txs_ids, std::list<Transaction>& txs, std::list<crypto::hash>& missed_txs, bool checkTxPool)
   {
-    m_blockchain_storage.get_transactions(txs_ids, txs, missed_txs);
+    // the pool is locked before the blockchain, as add_new_block does
+    CRITICAL_REGION_LOCAL(m_mempool);
+    m_blockchain_storage.get_transactions(txs_ids, txs, missed_txs, checkTxPool);
   }
   //-----------------------------------------------------------------------------------------------
   bool core::get_alternative_blocks(std::list<Block>& blocks)
@@ -122,14 +129,19 @@ namespace cryptonote
   //-----------------------------------------------------------------------------------------------
   bool core::init(const CoreConfig& config, const MinerConfig& minerConfig, bool load_existing) {
     m_config_folder = config.configFolder;
+    m_mempool.set_max_memory_usage(config.mempoolMaxSize);
     bool r = m_mempool.init(m_config_folder);
     CHECK_AND_ASSERT_MES(r, false, "Failed to initialize memory pool");
 
     r = m_blockchain_storage.init(m_config_folder, load_existing);
     CHECK_AND_ASSERT_MES(r, false, "Failed to initialize blockchain storage");
 
+    LOG_PRINT_L0("Slow hash implementation: " << crypto::cn_slow_hash_variant() << ", block check scratchpad on " <<
+      crypto::scratchpad_pages_name(m_blockchain_storage.getScratchpadPages()));
+
     r = m_miner->init(minerConfig);
     CHECK_AND_ASSERT_MES(r, false, "Failed to initialize blockchain storage");
+    m_templateNotifier.setFeeThreshold(minerConfig.templateFeeThreshold);
 
     return load_state_data();
   }
@@ -156,9 +168,7 @@ namespace cryptonote
   bool core::handle_incoming_tx(const blobdata& tx_blob, tx_verification_context& tvc, bool keeped_by_block)
   {
     tvc = boost::value_initialized<tx_verification_context>();
-    //want to process all transactions sequentially
-    CRITICAL_REGION_LOCAL(m_incoming_tx_lock);
-
+    // parsing and stateless checks run concurrently, the pool serializes only the conflict check and the insertion
     if(tx_blob.size() > m_currency.maxTxSize())
     {
       LOG_PRINT_L0("WRONG TRANSACTION BLOB, too big size " << tx_blob.size() << ", rejected");
@@ -206,6 +216,9 @@ namespace cryptonote
     if (tvc.m_added_to_pool) {
       LOG_PRINT_L1("tx added: " << tx_hash);
       poolUpdated();
+      if (m_templateNotifier.transactionAdded(get_tx_fee(tx))) {
+        update_miner_block_template();
+      }
     }
 
     return r;
@@ -214,6 +227,7 @@ namespace cryptonote
   bool core::get_stat_info(core_stat_info& st_inf)
   {
     st_inf.mining_speed = m_miner->get_speed();
+    st_inf.mining_thread_speeds = m_miner->get_thread_speeds();
     st_inf.alternative_blocks = m_blockchain_storage.get_alternative_blocks_count();
     st_inf.blockchain_height = m_blockchain_storage.get_current_blockchain_height();
     st_inf.tx_pool_size = m_mempool.get_transactions_count();
@@ -317,9 +331,7 @@ namespace cryptonote
       return true;
     }
 
-    // It's not very good to lock on m_mempool here, because it's very hard to understand the order of locking
-    // tx_memory_pool::m_transactions_lock, blockchain_storage::m_blockchain_lock, and core::m_incoming_tx_lock
-    CRITICAL_REGION_LOCAL(m_mempool);
+    // the pool checks for the transaction again when it inserts it
     if (m_mempool.have_tx(tx_hash)) {
       LOG_PRINT_L2("tx " << tx_hash << " is already in transaction pool");
       return true;
@@ -342,6 +354,11 @@ namespace cryptonote
   {
     return m_blockchain_storage.find_blockchain_supplement(qblock_ids, blocks, total_height, start_height, max_count);
   }
+
+  bool core::find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, std::list<block_complete_entry>& blocks, uint64_t& total_height, uint64_t& start_height, size_t max_count)
+  {
+    return m_blockchain_storage.find_blockchain_supplement(qblock_ids, blocks, total_height, start_height, max_count);
+  }
   //-----------------------------------------------------------------------------------------------
   void core::print_blockchain(uint64_t start_index, uint64_t end_index)
   {
@@ -398,6 +415,25 @@ namespace cryptonote
     return true;
   }
   //-----------------------------------------------------------------------------------------------
+  bool core::getPoolChanges(const crypto::hash& knownBlockId, uint64_t knownPoolVersion, bool& isBcActual, bool& isPoolVersionActual, uint64_t& poolVersion,
+    std::vector<Transaction>& newTxs, std::vector<crypto::hash>& deletedTxIds) {
+    isPoolVersionActual = false;
+    isBcActual = m_blockchain_storage.getPoolChanges(knownBlockId, knownPoolVersion, isPoolVersionActual, poolVersion, newTxs, deletedTxIds);
+    return true;
+  }
+  //-----------------------------------------------------------------------------------------------
+  void core::precompute_blocks_longhash(const std::vector<Block>& blocks) {
+    m_blockchain_storage.precomputeLongHashes(blocks);
+  }
+  //-----------------------------------------------------------------------------------------------
+  bool core::start_header_chain(uint64_t height, const crypto::hash& prev_id, CryptoNote::BlockHeaderChain& chain) {
+    return m_blockchain_storage.startHeaderChain(height, prev_id, chain);
+  }
+  //-----------------------------------------------------------------------------------------------
+  bool core::check_block_headers(CryptoNote::BlockHeaderChain& chain, const std::vector<Block>& headers) {
+    return m_blockchain_storage.checkBlockHeaders(chain, headers);
+  }
+  //-----------------------------------------------------------------------------------------------
   bool core::handle_incoming_block_blob(const blobdata& block_blob, block_verification_context& bvc, bool control_miner, bool relay_block) {
     if (block_blob.size() > m_currency.maxBlockBlobSize()) {
       LOG_PRINT_L0("WRONG BLOCK BLOB, too big size " << block_blob.size() << ", rejected");
@@ -463,6 +499,26 @@ namespace cryptonote
     return m_mempool.get_transactions_count();
   }
   //-----------------------------------------------------------------------------------------------
+  bool core::pool_has_tx(const crypto::hash& id)
+  {
+    return m_mempool.have_tx(id);
+  }
+  //-----------------------------------------------------------------------------------------------
+  bool core::have_tx(const crypto::hash& id)
+  {
+    return m_mempool.have_tx(id) || m_blockchain_storage.have_tx(id);
+  }
+  //-----------------------------------------------------------------------------------------------
+  size_t core::get_pool_memory_usage()
+  {
+    return m_mempool.get_memory_usage();
+  }
+  //-----------------------------------------------------------------------------------------------
+  uint64_t core::get_pool_evicted_transactions_count()
+  {
+    return m_mempool.get_evicted_transactions_count();
+  }
+  //-----------------------------------------------------------------------------------------------
   bool core::have_block(const crypto::hash& id)
   {
     return m_blockchain_storage.have_block(id);
@@ -537,8 +593,14 @@ namespace cryptonote
       m_starter_message_showed = true;
     }
 
+    // a paused miner gets its template when mining is resumed
+    if (m_minerTemplateOutdated.exchange(false) && !m_miner->is_paused()) {
+      update_miner_block_template();
+    }
+
     m_miner->on_idle();
     m_mempool.on_idle();
+    m_blockchain_storage.on_idle();
     return true;
   }
   //-----------------------------------------------------------------------------------------------
@@ -550,11 +612,34 @@ namespace cryptonote
     return m_observerManager.remove(observer);
   }
 
+  uint64_t core::get_block_template_version() {
+    return m_templateNotifier.version();
+  }
+
+  uint64_t core::wait_block_template_change(uint64_t known_version, std::chrono::milliseconds timeout) {
+    return m_templateNotifier.waitForChange(known_version, timeout);
+  }
+
+  bool core::get_block_template_instance(const AccountPublicAddress& adr, size_t reserve_size, CryptoNote::BlockTemplateInstance& instance) {
+    return m_templateCache.getTemplate(adr, reserve_size, m_templateNotifier.version(), instance);
+  }
+
   void core::blockchainUpdated() {
+    m_templateNotifier.blockchainUpdated();
+    // a paused miner gets its template when mining is resumed
+    if (!m_miner->is_paused()) {
+      m_minerTemplateOutdated = false;
+      update_miner_block_template();
+    }
+
     m_observerManager.notify(&ICoreObserver::blockchainUpdated);
   }
 
   void core::txDeletedFromPool() {
+    // the pool may evict transactions while blocks are being added under the exclusive blockchain lock,
+    // so the miner template is rebuilt from on_idle; RPC templates are rebuilt on the version change
+    m_minerTemplateOutdated = true;
+    m_templateNotifier.transactionsRemoved();
     poolUpdated();
   }
 
@@ -565,7 +650,7 @@ namespace cryptonote
   bool core::queryBlocks(const std::list<crypto::hash>& knownBlockIds, uint64_t timestamp,
       uint64_t& resStartHeight, uint64_t& resCurrentHeight, uint64_t& resFullOffset, std::list<BlockFullInfo>& entries) {
 
-    LockedBlockchainStorage lbs(m_blockchain_storage);
+    ReadLockedBlockchainStorage lbs(m_blockchain_storage);
 
     uint64_t currentHeight = lbs->get_current_blockchain_height();
     uint64_t startOffset = 0;
@@ -596,25 +681,16 @@ namespace cryptonote
     auto blocksLeft = std::min(BLOCKS_IDS_SYNCHRONIZING_DEFAULT_COUNT - entries.size(), size_t(BLOCKS_SYNCHRONIZING_DEFAULT_COUNT));
 
     if (blocksLeft) {
-      std::list<Block> blocks;
-      lbs->get_blocks(startFullOffset, blocksLeft, blocks);
-
-      for (auto& b : blocks) {
+      uint64_t endHeight = std::min(startFullOffset + blocksLeft, currentHeight);
+      for (uint64_t height = startFullOffset; height < endHeight; ++height) {
         BlockFullInfo item;
 
-        item.block_id = get_block_hash(b);
-
-        if (b.timestamp >= timestamp) {
-          // query transactions
-          std::list<Transaction> txs;
-          std::list<crypto::hash> missedTxs;
-          lbs->get_transactions(b.txHashes, txs, missedTxs);
+        item.block_id = lbs->get_block_id_by_height(height);
 
+        if (lbs->getBlockTimestamp(height) >= timestamp) {
           // fill data
-          block_complete_entry& completeEntry = item;
-          completeEntry.block = block_to_blob(b);
-          for (auto& tx : txs) {
-            completeEntry.txs.push_back(tx_to_blob(tx));
+          if (!lbs->getRawBlock(height, item)) {
+            return false;
           }
         }
 
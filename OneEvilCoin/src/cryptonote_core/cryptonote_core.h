@@ -32,6 +32,8 @@
 #include "crypto/hash.h"
 #include "ICore.h"
 #include "ICoreObserver.h"
+#include "BlockTemplateCache.h"
+#include "BlockTemplateNotifier.h"
 #include "common/ObserverManager.h"
 
 PUSH_WARNINGS
@@ -50,6 +52,10 @@ namespace cryptonote {
      bool on_idle();
      virtual bool handle_incoming_tx(const blobdata& tx_blob, tx_verification_context& tvc, bool keeped_by_block);
      bool handle_incoming_block_blob(const blobdata& block_blob, block_verification_context& bvc, bool control_miner, bool relay_block);
+     bool handle_incoming_block(const Block& b, block_verification_context& bvc, bool control_miner, bool relay_block);
+     void precompute_blocks_longhash(const std::vector<Block>& blocks);
+     bool start_header_chain(uint64_t height, const crypto::hash& prev_id, CryptoNote::BlockHeaderChain& chain);
+     bool check_block_headers(CryptoNote::BlockHeaderChain& chain, const std::vector<Block>& headers);
      const Currency& currency() const { return m_currency; }
      virtual i_cryptonote_protocol* get_protocol(){return m_pprotocol;}
 
@@ -60,6 +66,12 @@ namespace cryptonote {
      bool addObserver(ICoreObserver* observer);
      bool removeObserver(ICoreObserver* observer);
 
+     // version of the block template contents, changes on new blocks and on pool updates worth a new template
+     uint64_t get_block_template_version();
+     uint64_t wait_block_template_change(uint64_t known_version, std::chrono::milliseconds timeout);
+     // template shared by all callers for the current version, every call gets its own extra nonce tag
+     bool get_block_template_instance(const AccountPublicAddress& adr, size_t reserve_size, CryptoNote::BlockTemplateInstance& instance);
+
      miner& get_miner() { return *m_miner; }
      static void init_options(boost::program_options::options_description& desc);
      bool init(const CoreConfig& config, const MinerConfig& minerConfig, bool load_existing);
@@ -77,7 +89,7 @@ namespace cryptonote {
      virtual bool queryBlocks(const std::list<crypto::hash>& block_ids, uint64_t timestamp,
          uint64_t& start_height, uint64_t& current_height, uint64_t& full_offset, std::list<BlockFullInfo>& entries);
      crypto::hash get_block_id_by_height(uint64_t height);
-     void get_transactions(const std::vector<crypto::hash>& txs_ids, std::list<Transaction>& txs, std::list<crypto::hash>& missed_txs);
+     void get_transactions(const std::vector<crypto::hash>& txs_ids, std::list<Transaction>& txs, std::list<crypto::hash>& missed_txs, bool checkTxPool = false);
      bool get_block_by_hash(const crypto::hash &h, Block &blk);
      //void get_all_known_block_ids(std::list<crypto::hash> &main, std::list<crypto::hash> &alt, std::list<crypto::hash> &invalid);
 
@@ -91,12 +103,18 @@ namespace cryptonote {
 
      void get_pool_transactions(std::list<Transaction>& txs);
      size_t get_pool_transactions_count();
+     bool pool_has_tx(const crypto::hash& id);
+     // in the blockchain or in the pool
+     bool have_tx(const crypto::hash& id);
+     size_t get_pool_memory_usage();
+     uint64_t get_pool_evicted_transactions_count();
      size_t get_blockchain_total_transactions();
      //bool get_outs(uint64_t amount, std::list<crypto::public_key>& pkeys);
      bool have_block(const crypto::hash& id);
      bool get_short_chain_history(std::list<crypto::hash>& ids);
      virtual bool find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, NOTIFY_RESPONSE_CHAIN_ENTRY_request& resp);
      virtual bool find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, std::list<std::pair<Block, std::list<Transaction> > >& blocks, uint64_t& total_height, uint64_t& start_height, size_t max_count);
+     bool find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, std::list<block_complete_entry>& blocks, uint64_t& total_height, uint64_t& start_height, size_t max_count);
      bool get_stat_info(core_stat_info& st_inf);
      //bool get_backward_blocks_sizes(uint64_t from_height, std::vector<size_t>& sizes, size_t count);
      virtual bool get_tx_outputs_gindexs(const crypto::hash& tx_id, std::vector<uint64_t>& indexs);
@@ -112,13 +130,14 @@ namespace cryptonote {
      void print_blockchain_outs(const std::string& file);
      void on_synchronized();
      virtual bool getPoolSymmetricDifference(const std::vector<crypto::hash>& known_pool_tx_ids, const crypto::hash& known_block_id, bool& isBcActual, std::vector<Transaction>& new_txs, std::vector<crypto::hash>& deleted_tx_ids) override;
+     virtual bool getPoolChanges(const crypto::hash& knownBlockId, uint64_t knownPoolVersion, bool& isBcActual, bool& isPoolVersionActual, uint64_t& poolVersion,
+       std::vector<Transaction>& newTxs, std::vector<crypto::hash>& deletedTxIds) override;
 
    private:
      bool add_new_tx(const Transaction& tx, const crypto::hash& tx_hash, const crypto::hash& tx_prefix_hash, size_t blob_size, tx_verification_context& tvc, bool keeped_by_block);
      bool add_new_tx(const Transaction& tx, tx_verification_context& tvc, bool keeped_by_block);
      bool load_state_data();
      bool parse_tx_from_blob(Transaction& tx, crypto::hash& tx_hash, crypto::hash& tx_prefix_hash, const blobdata& blob);
-     bool handle_incoming_block(const Block& b, block_verification_context& bvc, bool control_miner, bool relay_block);
 
      bool check_tx_syntax(const Transaction& tx);
      //check correct values, amounts and all lightweight checks not related with database
@@ -142,13 +161,15 @@ namespace cryptonote {
      tx_memory_pool m_mempool;
      blockchain_storage m_blockchain_storage;
      i_cryptonote_protocol* m_pprotocol;
-     epee::critical_section m_incoming_tx_lock;
      std::unique_ptr<miner> m_miner;
      std::string m_config_folder;
      cryptonote_protocol_stub m_protocol_stub;
      friend class tx_validate_inputs;
      std::atomic<bool> m_starter_message_showed;
+     std::atomic<bool> m_minerTemplateOutdated;
      tools::ObserverManager<cryptonote::ICoreObserver> m_observerManager;
+     CryptoNote::BlockTemplateNotifier m_templateNotifier;
+     CryptoNote::BlockTemplateCache m_templateCache;
    };
 }
 
@@ -686,17 +686,19 @@ namespace cryptonote
     return get_object_hash(blob, res);
   }
   //---------------------------------------------------------------
-  bool get_block_longhash(crypto::cn_context &context, const Block& b, crypto::hash& res) {
-    blobdata bd;
+  bool get_block_longhash_blob(const Block& b, blobdata& blob) {
     if (b.majorVersion == BLOCK_MAJOR_VERSION_1) {
-      if (!get_block_hashing_blob(b, bd)) {
-        return false;
-      }
+      return get_block_hashing_blob(b, blob);
     } else if (b.majorVersion == BLOCK_MAJOR_VERSION_2) {
-      if (!get_parent_block_hashing_blob(b, bd)) {
-        return false;
-      }
-    } else {
+      return get_parent_block_hashing_blob(b, blob);
+    }
+
+    return false;
+  }
+  //---------------------------------------------------------------
+  bool get_block_longhash(crypto::cn_context &context, const Block& b, crypto::hash& res) {
+    blobdata bd;
+    if (!get_block_longhash_blob(b, bd)) {
       return false;
     }
     crypto::cn_slow_hash(context, bd.data(), bd.size(), res);
@@ -104,6 +104,7 @@ namespace cryptonote
   bool get_aux_block_header_hash(const Block& b, crypto::hash& res);
   bool get_block_hash(const Block& b, crypto::hash& res);
   crypto::hash get_block_hash(const Block& b);
+  bool get_block_longhash_blob(const Block& b, blobdata& blob);
   bool get_block_longhash(crypto::cn_context &context, const Block& b, crypto::hash& res);
   bool parse_and_validate_block_from_blob(const blobdata& b_blob, Block& b);
   bool get_inputs_money_amount(const Transaction& tx, uint64_t& money);
@@ -26,6 +26,7 @@ namespace cryptonote
     uint64_t tx_pool_size;
     uint64_t blockchain_height;
     uint64_t mining_speed;
+    std::vector<uint64_t> mining_thread_speeds;
     uint64_t alternative_blocks;
     std::string top_block_id_str;
     
@@ -33,6 +34,7 @@ namespace cryptonote
       KV_SERIALIZE(tx_pool_size)
       KV_SERIALIZE(blockchain_height)
       KV_SERIALIZE(mining_speed)
+      KV_SERIALIZE(mining_thread_speeds)
       KV_SERIALIZE(alternative_blocks)
       KV_SERIALIZE(top_block_id_str)
     END_KV_SERIALIZE_MAP()
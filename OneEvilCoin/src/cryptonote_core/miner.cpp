@@ -54,6 +54,8 @@ namespace cryptonote
     m_phandler(phandler),
     m_pausers_count(0),
     m_threads_total(0),
+    m_hashes_per_thread(crypto::cn_slow_hash_preferred_ways()),
+    m_thread_priority(CryptoNote::MinerThreadPriority::NORMAL),
     m_starter_nonce(0),
     m_last_hr_merge_time(0),
     m_hashes(0),
@@ -84,6 +86,11 @@ namespace cryptonote
       }
     }
 
+    if (!m_hashingTemplate.init(m_template)) {
+      LOG_ERROR("Failed to prepare block hashing template");
+      return false;
+    }
+
     m_diffic = di;
     ++m_template_no;
     m_starter_nonce = crypto::rand<uint32_t>();
@@ -117,10 +124,23 @@ namespace cryptonote
     return true;
   }
   //-----------------------------------------------------------------------------------------------------
+  bool miner::refresh_template_timestamp() {
+    if (m_template_no == 0) {
+      return request_block_template();
+    }
+
+    // chain and pool events rebuild the template, so only the timestamp can have gone stale here;
+    // the lock keeps a template rebuilt meanwhile from being replaced by this older copy
+    CRITICAL_REGION_LOCAL(m_template_lock);
+    Block bl = m_template;
+    bl.timestamp = time(NULL);
+    return set_block_template(bl, m_diffic);
+  }
+  //-----------------------------------------------------------------------------------------------------
   bool miner::on_idle()
   {
     m_update_block_template_interval.do_call([&](){
-      if(is_mining())request_block_template();
+      if(is_mining())refresh_template_timestamp();
       return true;
     });
 
@@ -139,10 +159,15 @@ namespace cryptonote
   //-----------------------------------------------------------------------------------------------------
   void miner::merge_hr()
   {
+    CRITICAL_REGION_LOCAL(m_last_hash_rates_lock);
     if(m_last_hr_merge_time && is_mining())
     {
-      m_current_hash_rate = m_hashes * 1000 / ((misc_utils::get_tick_count() - m_last_hr_merge_time + 1));
-      CRITICAL_REGION_LOCAL(m_last_hash_rates_lock);
+      uint64_t interval = misc_utils::get_tick_count() - m_last_hr_merge_time + 1;
+      m_current_hash_rate = m_hashes * 1000 / interval;
+      for (size_t i = 0; i < m_thread_hashes.size(); ++i) {
+        m_thread_hash_rates[i] = m_thread_hashes[i].exchange(0) * 1000 / interval;
+      }
+
       m_last_hash_rates.push_back(m_current_hash_rate);
       if(m_last_hash_rates.size() > 19)
         m_last_hash_rates.pop_front();
@@ -150,7 +175,18 @@ namespace cryptonote
       {
         uint64_t total_hr = std::accumulate(m_last_hash_rates.begin(), m_last_hash_rates.end(), 0);
         float hr = static_cast<float>(total_hr)/static_cast<float>(m_last_hash_rates.size());
-        std::cout << "hashrate: " << std::setprecision(4) << std::fixed << hr << ENDL;
+        std::cout << "hashrate: " << std::setprecision(4) << std::fixed << hr;
+        if (m_thread_hash_rates.size() > 1) {
+          std::cout << ", per thread:";
+          for (uint64_t threadHashRate : m_thread_hash_rates) {
+            std::cout << " " << threadHashRate;
+          }
+        }
+        std::cout << ENDL;
+      }
+    } else {
+      for (auto& threadHashes : m_thread_hashes) {
+        threadHashes = 0;
       }
     }
     m_last_hr_merge_time = misc_utils::get_tick_count();
@@ -179,6 +215,29 @@ namespace cryptonote
       LOG_PRINT_L0("Loaded " << m_extra_messages.size() << " extra messages, current index " << m_config.current_extra_message_index);
     }
 
+    if (config.hashesPerThread != 0) {
+      if (config.hashesPerThread != 1 && config.hashesPerThread != 2 && config.hashesPerThread != 4) {
+        LOG_ERROR("Wrong number of hashes per mining thread: " << config.hashesPerThread << ", expected 1, 2 or 4");
+        return false;
+      }
+
+      m_hashes_per_thread = config.hashesPerThread;
+    }
+
+    if (!config.threadAffinity.empty()) {
+      if (config.threadAffinity == "auto") {
+        m_thread_cpus = CryptoNote::spreadOverPhysicalCores(CryptoNote::detectCpuTopology());
+      } else if (!CryptoNote::parseCpuList(config.threadAffinity, m_thread_cpus)) {
+        LOG_ERROR("Wrong mining thread affinity: " << config.threadAffinity);
+        return false;
+      }
+    }
+
+    if (!CryptoNote::parseMinerThreadPriority(config.threadPriority, m_thread_priority)) {
+      LOG_ERROR("Wrong mining thread priority: " << config.threadPriority << ", expected normal, low or idle");
+      return false;
+    }
+
     if(!config.startMining.empty()) {
       if (!m_currency.parseAccountAddressString(config.startMining, m_mine_address)) {
         LOG_ERROR("Target account address " << config.startMining << " has wrong format, starting daemon canceled");
@@ -199,6 +258,11 @@ namespace cryptonote
     return !m_stop;
   }
   //-----------------------------------------------------------------------------------------------------
+  bool miner::is_paused()
+  {
+    return m_pausers_count > 0;
+  }
+  //-----------------------------------------------------------------------------------------------------
   bool miner::start(const AccountPublicAddress& adr, size_t threads_count, const boost::thread::attributes& attrs)
   {
     m_mine_address = adr;
@@ -220,6 +284,15 @@ namespace cryptonote
     if(!m_template_no)
       request_block_template();//lets update block template
 
+    {
+      CRITICAL_REGION_LOCAL(m_last_hash_rates_lock);
+      m_thread_hashes = std::vector<std::atomic<uint64_t>>(threads_count);
+      for (auto& threadHashes : m_thread_hashes) {
+        threadHashes = 0;
+      }
+      m_thread_hash_rates.assign(threads_count, 0);
+    }
+
     boost::interprocess::ipcdetail::atomic_write32(&m_stop, 0);
     boost::interprocess::ipcdetail::atomic_write32(&m_thread_index, 0);
 
@@ -240,6 +313,16 @@ namespace cryptonote
       return 0;
   }
   //-----------------------------------------------------------------------------------------------------
+  std::vector<uint64_t> miner::get_thread_speeds()
+  {
+    if (!is_mining()) {
+      return std::vector<uint64_t>();
+    }
+
+    CRITICAL_REGION_LOCAL(m_last_hash_rates_lock);
+    return m_thread_hash_rates;
+  }
+  //-----------------------------------------------------------------------------------------------------
   void miner::send_stop_signal()
   {
     boost::interprocess::ipcdetail::atomic_write32(&m_stop, 1);
@@ -268,19 +351,20 @@ namespace cryptonote
       std::atomic<bool> found(false);
       uint32_t startNonce = crypto::rand<uint32_t>();
 
+      CryptoNote::BlockHashingTemplate localTemplate;
+      if (!localTemplate.init(bl)) {
+        return false;
+      }
+
       for (unsigned i = 0; i < nthreads; ++i) {
         threads[i] = std::async(std::launch::async, [&, i]() {
           crypto::cn_context localctx;
           crypto::hash h;
 
-          Block lb(bl); // copy to local block
+          CryptoNote::BlockHashingTemplate hashingTemplate(localTemplate); // copy to local template
 
           for (uint32_t nonce = startNonce + i; !found; nonce += nthreads) {
-            lb.nonce = nonce;
-
-            if (!get_block_longhash(localctx, lb, h)) {
-              return;
-            }
+            hashingTemplate.hash(localctx, nonce, h);
 
             if (check_hash(h, diffic)) {
               foundNonce = nonce;
@@ -353,11 +437,28 @@ namespace cryptonote
     uint32_t th_local_index = boost::interprocess::ipcdetail::atomic_inc32(&m_thread_index);
     LOG_PRINT_L0("Miner thread was started ["<< th_local_index << "]");
     log_space::log_singletone::set_thread_log_prefix(std::string("[miner ") + std::to_string(th_local_index) + "]");
+    if (!m_thread_cpus.empty()) {
+      uint32_t cpu = m_thread_cpus[th_local_index % m_thread_cpus.size()];
+      if (!CryptoNote::setCurrentThreadAffinity(cpu)) {
+        LOG_PRINT_L0("Failed to pin miner thread to CPU " << cpu);
+      }
+    }
+
+    if (!CryptoNote::setCurrentThreadPriority(m_thread_priority)) {
+      LOG_PRINT_L0("Failed to change miner thread priority");
+    }
+
     uint32_t nonce = m_starter_nonce + th_local_index;
     difficulty_type local_diff = 0;
     uint32_t local_template_ver = 0;
-    crypto::cn_context context;
+    // allocated after pinning, so the scratchpad pages are placed on the NUMA node of the thread's CPU.
+    // every thread hashes several nonces in lockstep: nonce, nonce + m_threads_total, ...
+    crypto::cn_multi_context context(m_hashes_per_thread);
+    LOG_PRINT_L1("Miner thread [" << th_local_index << "] scratchpad on " << crypto::scratchpad_pages_name(context.pages()));
+    uint32_t nonces[crypto::SLOW_HASH_MAX_WAYS];
+    crypto::hash hashes[crypto::SLOW_HASH_MAX_WAYS];
     Block b;
+    CryptoNote::BlockHashingTemplate hashingTemplate;
     while(!m_stop)
     {
       if(m_pausers_count)//anti split workaround
@@ -371,6 +472,7 @@ namespace cryptonote
 
         CRITICAL_REGION_BEGIN(m_template_lock);
         b = m_template;
+        hashingTemplate = m_hashingTemplate;
         local_diff = m_diffic;
         CRITICAL_REGION_END();
         local_template_ver = m_template_no;
@@ -384,15 +486,20 @@ namespace cryptonote
         continue;
       }
 
-      b.nonce = nonce;
-      crypto::hash h;
-      if (!m_stop && !get_block_longhash(context, b, h)) {
-        LOG_ERROR("Failed to get block long hash");
-        m_stop = true;
+      for (size_t i = 0; i < context.ways(); ++i) {
+        nonces[i] = nonce + static_cast<uint32_t>(i) * m_threads_total;
       }
 
-      if (!m_stop && check_hash(h, local_diff))
+      hashingTemplate.hash(context, nonces, hashes);
+
+      for (size_t i = 0; i < context.ways() && !m_stop; ++i)
       {
+        if (!check_hash(hashes[i], local_diff))
+        {
+          continue;
+        }
+
+        b.nonce = nonces[i];
         //we lucky!
         ++m_config.current_extra_message_index;
         LOG_PRINT_GREEN("Found block for difficulty: " << local_diff, LOG_LEVEL_0);
@@ -406,8 +513,9 @@ namespace cryptonote
         }
       }
 
-      nonce+=m_threads_total;
-      ++m_hashes;
+      nonce += static_cast<uint32_t>(context.ways()) * m_threads_total;
+      m_hashes += context.ways();
+      m_thread_hashes[th_local_index] += context.ways();
     }
     LOG_PRINT_L0("Miner thread stopped ["<< th_local_index << "]");
     return true;
@@ -25,11 +25,13 @@
 #include "serialization/keyvalue_serialization.h"
 #include "math_helper.h"
 
+#include "cryptonote_core/BlockHashingTemplate.h"
 #include "cryptonote_core/cryptonote_basic.h"
 #include "cryptonote_core/Currency.h"
 #include "cryptonote_core/difficulty.h"
 #include "cryptonote_core/i_miner_handler.h"
 #include "cryptonote_core/MinerConfig.h"
+#include "cryptonote_core/MinerThreadPlacement.h"
 
 namespace cryptonote {
   class miner {
@@ -42,9 +44,11 @@ namespace cryptonote {
     bool on_block_chain_update();
     bool start(const AccountPublicAddress& adr, size_t threads_count, const boost::thread::attributes& attrs);
     uint64_t get_speed();
+    std::vector<uint64_t> get_thread_speeds();
     void send_stop_signal();
     bool stop();
     bool is_mining();
+    bool is_paused();
     bool on_idle();
     void on_synchronized();
     //synchronous analog (for fast calls)
@@ -56,6 +60,7 @@ namespace cryptonote {
   private:
     bool worker_thread();
     bool request_block_template();
+    bool refresh_template_timestamp();
     void  merge_hr();
 
     struct miner_config
@@ -72,11 +77,16 @@ namespace cryptonote {
     volatile uint32_t m_stop;
     epee::critical_section m_template_lock;
     Block m_template;
+    CryptoNote::BlockHashingTemplate m_hashingTemplate;
     std::atomic<uint32_t> m_template_no;
     std::atomic<uint32_t> m_starter_nonce;
     difficulty_type m_diffic;
     volatile uint32_t m_thread_index;
     volatile uint32_t m_threads_total;
+    size_t m_hashes_per_thread;
+    // CPU of every mining thread, empty if threads are not pinned
+    std::vector<uint32_t> m_thread_cpus;
+    CryptoNote::MinerThreadPriority m_thread_priority;
     std::atomic<int32_t> m_pausers_count;
     epee::critical_section m_miners_count_lock;
 
@@ -84,13 +94,16 @@ namespace cryptonote {
     epee::critical_section m_threads_lock;
     i_miner_handler* m_phandler;
     AccountPublicAddress m_mine_address;
-    epee::math_helper::once_a_time_seconds<5> m_update_block_template_interval;
+    // templates are rebuilt on events, this only refreshes the timestamp
+    epee::math_helper::once_a_time_seconds<30> m_update_block_template_interval;
     epee::math_helper::once_a_time_seconds<2> m_update_merge_hr_interval;
     std::vector<blobdata> m_extra_messages;
     miner_config m_config;
     std::string m_config_folder_path;
     std::atomic<uint64_t> m_last_hr_merge_time;
     std::atomic<uint64_t> m_hashes;
+    std::vector<std::atomic<uint64_t>> m_thread_hashes;
+    std::vector<uint64_t> m_thread_hash_rates;
     std::atomic<uint64_t> m_current_hash_rate;
     epee::critical_section m_last_hash_rates_lock;
     std::list<uint64_t> m_last_hash_rates;
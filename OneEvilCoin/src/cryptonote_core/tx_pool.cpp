@@ -98,13 +98,56 @@ namespace cryptonote {
 
   using CryptoNote::BlockInfo;
 
+  namespace {
+    // index nodes of a pool entry and a node of the spent inputs containers, a rough estimate for common allocators
+    const size_t POOL_ENTRY_OVERHEAD = 8 * sizeof(void*);
+    const size_t SPENT_INPUT_OVERHEAD = 4 * sizeof(void*);
+
+    size_t getTransactionMemoryUsage(const Transaction& tx) {
+      size_t size = sizeof(tx_memory_pool::TransactionDetails) + POOL_ENTRY_OVERHEAD;
+
+      size += tx.vin.capacity() * sizeof(TransactionInput);
+      for (const auto& in : tx.vin) {
+        if (in.type() == typeid(TransactionInputToKey)) {
+          size += boost::get<TransactionInputToKey>(in).keyOffsets.capacity() * sizeof(uint64_t);
+          size += sizeof(crypto::key_image) + sizeof(crypto::hash) + 2 * SPENT_INPUT_OVERHEAD;
+        } else if (in.type() == typeid(TransactionInputMultisignature)) {
+          size += 2 * sizeof(uint64_t) + SPENT_INPUT_OVERHEAD;
+        }
+      }
+
+      size += tx.vout.capacity() * sizeof(TransactionOutput);
+      for (const auto& out : tx.vout) {
+        if (out.target.type() == typeid(TransactionOutputMultisignature)) {
+          size += boost::get<TransactionOutputMultisignature>(out.target).keys.capacity() * sizeof(crypto::public_key);
+        }
+      }
+
+      size += tx.extra.capacity();
+      size += tx.signatures.capacity() * sizeof(std::vector<crypto::signature>);
+      for (const auto& signatures : tx.signatures) {
+        size += signatures.capacity() * sizeof(crypto::signature);
+      }
+
+      return size;
+    }
+  }
+
   //---------------------------------------------------------------------------------
   tx_memory_pool::tx_memory_pool(const cryptonote::Currency& currency, CryptoNote::ITransactionValidator& validator, CryptoNote::ITimeProvider& timeProvider) :
     m_currency(currency),
     m_validator(validator), 
     m_timeProvider(timeProvider), 
     m_txCheckInterval(60, timeProvider),
-    m_fee_index(boost::get<1>(m_transactions)) {
+    m_fee_index(boost::get<1>(m_transactions)),
+    m_readinessTip(null_hash),
+    m_readinessTime(0),
+    m_memoryUsage(0),
+    m_maxMemoryUsage(parameters::CRYPTONOTE_MEMPOOL_DEFAULT_MAX_SIZE),
+    m_evictedTransactions(0),
+    // versions of different daemon runs don't overlap, so a client can't mistake a fresh pool for the one it knows
+    m_version(static_cast<uint64_t>(std::time(nullptr)) << 32),
+    m_changesStartVersion(m_version) {
   }
 
   //---------------------------------------------------------------------------------
@@ -150,7 +193,7 @@ namespace cryptonote {
 
     BlockInfo maxUsedBlock;
 
-    // check inputs
+    // check inputs, ring signatures of concurrently added transactions are checked in parallel outside of the pool lock
     bool inputsValid = m_validator.checkTransactionInputs(tx, maxUsedBlock);
 
     if (!inputsValid) {
@@ -164,37 +207,73 @@ namespace cryptonote {
       tvc.m_verifivation_impossible = true;
     }
 
-    CRITICAL_REGION_LOCAL(m_transactions_lock);
-
-    // add to pool
+    bool evicted = false;
     {
-      TransactionDetails txd;
+      CRITICAL_REGION_LOCAL(m_transactions_lock);
 
-      txd.id = id;
-      txd.blobSize = blobSize;
-      txd.tx = tx;
-      txd.fee = fee;
-      txd.keptByBlock = keptByBlock;
-      txd.receiveTime = m_timeProvider.now();
+      if (m_transactions.count(id)) {
+        LOG_PRINT_L2("tx " << id << " is already in transaction pool");
+        return true;
+      }
 
-      txd.maxUsedBlock = maxUsedBlock;
-      txd.lastFailedBlock.clear();
+      // the pool and the blockchain may have changed while the inputs were checked, so conflicts are checked again
+      // together with the insertion. Blocks are added with the pool locked, so no block spending these key images can
+      // be added before the transaction is in the pool
+      if (!keptByBlock && (haveSpentInputs(tx) || m_validator.haveSpentKeyImages(tx))) {
+        LOG_PRINT_L0("Transaction with id= " << id << " used already spent inputs");
+        tvc.m_verifivation_failed = true;
+        return false;
+      }
 
-      auto txd_p = m_transactions.insert(std::move(txd));
-      CHECK_AND_ASSERT_MES(txd_p.second, false, "transaction already exists at inserting in memory pool");
-    }
+      // add to pool
+      {
+        TransactionDetails txd;
 
-    tvc.m_added_to_pool = true;
+        txd.id = id;
+        txd.blobSize = blobSize;
+        txd.tx = tx;
+        txd.fee = fee;
+        txd.keptByBlock = keptByBlock;
+        txd.receiveTime = m_timeProvider.now();
 
-    if (inputsValid && fee > 0)
-      tvc.m_should_be_relayed = true;
+        txd.maxUsedBlock = maxUsedBlock;
+        txd.lastFailedBlock.clear();
 
-    tvc.m_verifivation_failed = true;
+        auto txd_p = m_transactions.insert(std::move(txd));
+        CHECK_AND_ASSERT_MES(txd_p.second, false, "transaction already exists at inserting in memory pool");
+        m_memoryUsage += getTransactionMemoryUsage(txd_p.first->tx);
+        recordChange(id, true);
+      }
 
-    if (!addTransactionInputs(id, tx, keptByBlock))
-      return false;
+      tvc.m_added_to_pool = true;
+
+      if (inputsValid && fee > 0)
+        tvc.m_should_be_relayed = true;
+
+      tvc.m_verifivation_failed = true;
+
+      if (!addTransactionInputs(id, tx, keptByBlock))
+        return false;
+
+      tvc.m_verifivation_failed = false;
+
+      if (m_memoryUsage > m_maxMemoryUsage) {
+        uint64_t evictedBefore = m_evictedTransactions;
+        bool addedEvicted = evictCheapestTransactions(id);
+        evicted = m_evictedTransactions != evictedBefore;
+        if (addedEvicted) {
+          LOG_PRINT_L1("Transaction " << id << " is too cheap for the full pool, rejected");
+          tvc.m_added_to_pool = false;
+          tvc.m_should_be_relayed = false;
+          tvc.m_tx_fee_too_small = true;
+        }
+      }
+    }
+
+    if (evicted) {
+      m_observerManager.notify(&ITxPoolObserver::txDeletedFromPool);
+    }
 
-    tvc.m_verifivation_failed = false;
     //succeed
     return true;
   }
@@ -228,6 +307,21 @@ namespace cryptonote {
     return m_transactions.size();
   }
   //---------------------------------------------------------------------------------
+  size_t tx_memory_pool::get_memory_usage() const {
+    CRITICAL_REGION_LOCAL(m_transactions_lock);
+    return m_memoryUsage;
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::set_max_memory_usage(size_t maxMemoryUsage) {
+    CRITICAL_REGION_LOCAL(m_transactions_lock);
+    m_maxMemoryUsage = maxMemoryUsage;
+  }
+  //---------------------------------------------------------------------------------
+  uint64_t tx_memory_pool::get_evicted_transactions_count() const {
+    CRITICAL_REGION_LOCAL(m_transactions_lock);
+    return m_evictedTransactions;
+  }
+  //---------------------------------------------------------------------------------
   void tx_memory_pool::get_transactions(std::list<Transaction>& txs) const {
     CRITICAL_REGION_LOCAL(m_transactions_lock);
     for (const auto& tx_vt : m_transactions) {
@@ -261,11 +355,46 @@ namespace cryptonote {
     deleted_tx_ids.assign(known_set.begin(), known_set.end());
   }
   //---------------------------------------------------------------------------------
+  bool tx_memory_pool::get_changes(uint64_t knownVersion, std::vector<crypto::hash>& new_tx_ids, std::vector<crypto::hash>& deleted_tx_ids, uint64_t& version) {
+    CRITICAL_REGION_LOCAL(m_transactions_lock);
+    refreshTimedReadiness();
+    version = m_version;
+    if (knownVersion < m_changesStartVersion || knownVersion > m_version) {
+      return false;
+    }
+
+    auto firstChange = std::upper_bound(m_changes.begin(), m_changes.end(), knownVersion,
+      [](uint64_t v, const PoolChange& change) { return v < change.version; });
+
+    // the first change of a transaction after knownVersion tells whether it was in the pool at that version
+    std::unordered_set<crypto::hash> seen;
+    for (auto it = firstChange; it != m_changes.end(); ++it) {
+      if (!seen.insert(it->id).second) {
+        continue;
+      }
+
+      auto txIt = m_transactions.find(it->id);
+      if (it->added) {
+        if (txIt != m_transactions.end() && isReadyForNextBlock(m_transactions.project<1>(txIt))) {
+          new_tx_ids.push_back(it->id);
+        }
+      } else if (txIt == m_transactions.end()) {
+        deleted_tx_ids.push_back(it->id);
+      }
+    }
+
+    return true;
+  }
+  //---------------------------------------------------------------------------------
   bool tx_memory_pool::on_blockchain_inc(uint64_t new_block_height, const crypto::hash& top_block_id) {
+    CRITICAL_REGION_LOCAL(m_transactions_lock);
+    resetReadiness(top_block_id);
     return true;
   }
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::on_blockchain_dec(uint64_t new_block_height, const crypto::hash& top_block_id) {
+    CRITICAL_REGION_LOCAL(m_transactions_lock);
+    resetReadiness(top_block_id);
     return true;
   }
   //---------------------------------------------------------------------------------
@@ -298,6 +427,70 @@ namespace cryptonote {
     return true;
   }
   //---------------------------------------------------------------------------------
+  bool tx_memory_pool::isReadyForNextBlock(tx_container_t::nth_index<1>::type::iterator i) {
+    auto readiness = m_readiness.find(i->id);
+    if (readiness != m_readiness.end()) {
+      return readiness->second;
+    }
+
+    TransactionCheckInfo checkInfo(*i);
+    bool ready = is_transaction_ready_to_go(i->tx, checkInfo);
+
+    // update item state
+    m_fee_index.modify(i, [&checkInfo](TransactionCheckInfo& item) {
+      item = checkInfo;
+    });
+
+    m_readiness.insert(std::make_pair(i->id, ready));
+    return ready;
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::resetReadiness(const crypto::hash& topBlockId) {
+    if (topBlockId != m_readinessTip) {
+      m_readinessTip = topBlockId;
+      m_readinessTime = m_timeProvider.now();
+      m_readiness.clear();
+      resetChanges();
+    }
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::refreshTimedReadiness() {
+    uint64_t now = m_timeProvider.now();
+    if (now < m_readinessTime + parameters::CRYPTONOTE_MEMPOOL_READINESS_TIME_STEP) {
+      return;
+    }
+
+    m_readinessTime = now;
+
+    bool dropped = false;
+    for (auto it = m_readiness.begin(); it != m_readiness.end();) {
+      if (!it->second) {
+        it = m_readiness.erase(it);
+        dropped = true;
+      } else {
+        ++it;
+      }
+    }
+
+    // the change log reports a transaction only when it is added, clients have to fetch the whole difference to see it
+    if (dropped) {
+      resetChanges();
+    }
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::recordChange(const crypto::hash& id, bool added) {
+    m_changes.push_back(PoolChange{ ++m_version, id, added });
+    if (m_changes.size() > parameters::CRYPTONOTE_MEMPOOL_CHANGE_LOG_SIZE) {
+      m_changesStartVersion = m_changes.front().version;
+      m_changes.pop_front();
+    }
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::resetChanges() {
+    m_changes.clear();
+    m_changesStartVersion = ++m_version;
+  }
+  //---------------------------------------------------------------------------------
   std::string tx_memory_pool::print_pool(bool short_format) const {
     std::stringstream ss;
     CRITICAL_REGION_LOCAL(m_transactions_lock);
@@ -322,6 +515,7 @@ namespace cryptonote {
   bool tx_memory_pool::fill_block_template(Block& bl, size_t median_size, size_t maxCumulativeSize,
                                            uint64_t already_generated_coins, size_t& total_size, uint64_t& fee) {
     CRITICAL_REGION_LOCAL(m_transactions_lock);
+    refreshTimedReadiness();
 
     total_size = 0;
     fee = 0;
@@ -338,15 +532,7 @@ namespace cryptonote {
         continue;
       }
 
-      TransactionCheckInfo checkInfo(txd);
-      bool ready = is_transaction_ready_to_go(txd.tx, checkInfo);
-
-      // update item state
-      m_fee_index.modify(i, [&checkInfo](TransactionCheckInfo& item) {
-        item = checkInfo;
-      });
-      
-      if (ready && blockTemplate.addTransaction(txd.id, txd.tx)) {
+      if (isReadyForNextBlock(i) && blockTemplate.addTransaction(txd.id, txd.tx)) {
         total_size += txd.blobSize;
         fee += txd.fee;
       }
@@ -373,6 +559,12 @@ namespace cryptonote {
       m_spent_key_images.clear();
       m_spentOutputs.clear();
     }
+
+    m_readiness.clear();
+    m_memoryUsage = 0;
+    for (const auto& txd : m_transactions) {
+      m_memoryUsage += getTransactionMemoryUsage(txd.tx);
+    }
     // Ignore deserialization error
     return true;
   }
@@ -427,9 +619,33 @@ namespace cryptonote {
 
   tx_memory_pool::tx_container_t::iterator tx_memory_pool::removeTransaction(tx_memory_pool::tx_container_t::iterator i) {
     removeTransactionInputs(i->id, i->tx, i->keptByBlock);
+    m_readiness.erase(i->id);
+    m_memoryUsage -= getTransactionMemoryUsage(i->tx);
+    recordChange(i->id, false);
     return m_transactions.erase(i);
   }
 
+  // Removes the lowest fee per byte transactions until the pool fits into m_maxMemoryUsage. Transactions kept by
+  // blocks are never evicted, they are needed to switch to an alternative chain. Returns true if addedId was evicted.
+  bool tx_memory_pool::evictCheapestTransactions(const crypto::hash& addedId) {
+    bool addedEvicted = false;
+    auto it = m_fee_index.end();
+    while (m_memoryUsage > m_maxMemoryUsage && it != m_fee_index.begin()) {
+      auto cheapest = std::prev(it);
+      if (cheapest->keptByBlock) {
+        it = cheapest;
+        continue;
+      }
+
+      LOG_PRINT_L2("Tx " << cheapest->id << " evicted from tx pool, pool memory usage " << m_memoryUsage);
+      addedEvicted = addedEvicted || cheapest->id == addedId;
+      removeTransaction(m_transactions.project<0>(cheapest));
+      ++m_evictedTransactions;
+    }
+
+    return addedEvicted;
+  }
+
   bool tx_memory_pool::removeTransactionInputs(const crypto::hash& tx_id, const Transaction& tx, bool keptByBlock) {
     for (const auto& in : tx.vin) {
       if (in.type() == typeid(TransactionInputToKey)) {
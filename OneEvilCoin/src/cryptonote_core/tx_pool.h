@@ -18,6 +18,7 @@
 #pragma once
 #include "include_base_utils.h"
 
+#include <deque>
 #include <set>
 #include <unordered_map>
 #include <unordered_set>
@@ -111,7 +112,14 @@ namespace cryptonote {
 
     void get_transactions(std::list<Transaction>& txs) const;
     void get_difference(const std::vector<crypto::hash>& known_tx_ids, std::vector<crypto::hash>& new_tx_ids, std::vector<crypto::hash>& deleted_tx_ids) const;
+    // ready transactions added and transactions removed since the pool had knownVersion, it is O(changes) instead of
+    // O(pool) of get_difference. Returns false if the change log doesn't reach knownVersion, version is set anyway
+    bool get_changes(uint64_t knownVersion, std::vector<crypto::hash>& new_tx_ids, std::vector<crypto::hash>& deleted_tx_ids, uint64_t& version);
     size_t get_transactions_count() const;
+    // approximate memory used by pool transactions and the limit above which the cheapest ones are evicted
+    size_t get_memory_usage() const;
+    void set_max_memory_usage(size_t maxMemoryUsage);
+    uint64_t get_evicted_transactions_count() const;
     std::string print_pool(bool short_format) const;
     void on_idle();
 
@@ -159,6 +167,12 @@ namespace cryptonote {
 
   private:
 
+    struct PoolChange {
+      uint64_t version;
+      crypto::hash id;
+      bool added;
+    };
+
     struct TransactionPriorityComparator {
       // lhs > hrs
       bool operator()(const TransactionDetails& lhs, const TransactionDetails& rhs) const {
@@ -199,7 +213,13 @@ namespace cryptonote {
 
     tx_container_t::iterator removeTransaction(tx_container_t::iterator i);
     bool removeExpiredTransactions();
+    bool evictCheapestTransactions(const crypto::hash& addedId);
     bool is_transaction_ready_to_go(const Transaction& tx, TransactionCheckInfo& txd) const;
+    bool isReadyForNextBlock(tx_container_t::nth_index<1>::type::iterator i);
+    void resetReadiness(const crypto::hash& topBlockId);
+    void refreshTimedReadiness();
+    void recordChange(const crypto::hash& id, bool added);
+    void resetChanges();
 
     tools::ObserverManager<ITxPoolObserver> m_observerManager;
 
@@ -216,6 +236,24 @@ namespace cryptonote {
     tx_container_t m_transactions;  
     tx_container_t::nth_index<1>::type& m_fee_index;
 
+    // readiness of pool transactions for the block on top of m_readinessTip, so every transaction
+    // goes through is_transaction_ready_to_go() once per chain tip instead of once per block template.
+    // Outputs with a time based unlock become spendable without a new tip, so transactions found not ready
+    // are checked again once m_readinessTime is CRYPTONOTE_MEMPOOL_READINESS_TIME_STEP old
+    crypto::hash m_readinessTip;
+    uint64_t m_readinessTime;
+    std::unordered_map<crypto::hash, bool> m_readiness;
+
+    size_t m_memoryUsage;
+    size_t m_maxMemoryUsage;
+    uint64_t m_evictedTransactions;
+
+    // every added and removed transaction bumps m_version, m_changes keeps the latest of them so clients that know
+    // the pool at some version can fetch the difference. A chain tip change resets the log, since it changes readiness
+    uint64_t m_version;
+    uint64_t m_changesStartVersion;
+    std::deque<PoolChange> m_changes;
+
 #if defined(DEBUG_CREATE_BLOCK_TEMPLATE)
     friend class blockchain_storage;
 #endif
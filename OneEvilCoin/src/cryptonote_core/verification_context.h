@@ -36,5 +36,6 @@ namespace cryptonote
     bool m_verifivation_failed; //bad block, should drop connection
     bool m_marked_as_orphaned;
     bool m_already_exists;
+    bool m_missing_transactions; //verification failed only because transactions of the block aren't in the pool
   };
 }
@@ -138,10 +138,12 @@ namespace cryptonote
   {
     uint64_t current_height;
     crypto::hash  top_id;
+    uint8_t version; // missing in sync data of peers older than P2P_PROTOCOL_VERSION_1
 
     BEGIN_KV_SERIALIZE_MAP()
       KV_SERIALIZE(current_height)
       KV_SERIALIZE_VAL_POD_AS_BLOB(top_id)
+      KV_SERIALIZE(version)
     END_KV_SERIALIZE_MAP()
   };
 
@@ -178,4 +180,115 @@ namespace cryptonote
     typedef NOTIFY_RESPONSE_CHAIN_ENTRY_request request;
   };
 
+  /************************************************************************/
+  /*                                                                      */
+  /************************************************************************/
+  // new block without transactions, sent to peers of P2P_PROTOCOL_VERSION_1 and later,
+  // which take the transactions from their pools and request the missing ones
+  struct NOTIFY_NEW_COMPACT_BLOCK_request
+  {
+    blobdata block;
+    uint64_t current_blockchain_height;
+    uint32_t hop;
+
+    BEGIN_KV_SERIALIZE_MAP()
+      KV_SERIALIZE(block)
+      KV_SERIALIZE(current_blockchain_height)
+      KV_SERIALIZE(hop)
+    END_KV_SERIALIZE_MAP()
+  };
+
+  struct NOTIFY_NEW_COMPACT_BLOCK
+  {
+    const static int ID = BC_COMMANDS_POOL_BASE + 8;
+    typedef NOTIFY_NEW_COMPACT_BLOCK_request request;
+  };
+
+  struct NOTIFY_REQUEST_BLOCK_TXS_request
+  {
+    crypto::hash block_id;
+    std::list<crypto::hash> txs;
+    uint32_t hop;
+
+    BEGIN_KV_SERIALIZE_MAP()
+      KV_SERIALIZE_VAL_POD_AS_BLOB(block_id)
+      KV_SERIALIZE_CONTAINER_POD_AS_BLOB(txs)
+      KV_SERIALIZE(hop)
+    END_KV_SERIALIZE_MAP()
+  };
+
+  struct NOTIFY_REQUEST_BLOCK_TXS
+  {
+    const static int ID = BC_COMMANDS_POOL_BASE + 9;
+    typedef NOTIFY_REQUEST_BLOCK_TXS_request request;
+  };
+
+  // the block with the requested transactions only
+  struct NOTIFY_RESPONSE_BLOCK_TXS
+  {
+    const static int ID = BC_COMMANDS_POOL_BASE + 10;
+    typedef NOTIFY_NEW_BLOCK_request request;
+  };
+
+  /************************************************************************/
+  /*                                                                      */
+  /************************************************************************/
+  // hashes of new transactions, sent to peers of P2P_PROTOCOL_VERSION_2 and later instead of the transactions
+  struct NOTIFY_TX_INVENTORY_request
+  {
+    std::list<crypto::hash> txs;
+
+    BEGIN_KV_SERIALIZE_MAP()
+      KV_SERIALIZE_CONTAINER_POD_AS_BLOB(txs)
+    END_KV_SERIALIZE_MAP()
+  };
+
+  struct NOTIFY_TX_INVENTORY
+  {
+    const static int ID = BC_COMMANDS_POOL_BASE + 11;
+    typedef NOTIFY_TX_INVENTORY_request request;
+  };
+
+  // answered with NOTIFY_NEW_TRANSACTIONS
+  struct NOTIFY_REQUEST_TXS
+  {
+    const static int ID = BC_COMMANDS_POOL_BASE + 12;
+    typedef NOTIFY_TX_INVENTORY_request request;
+  };
+
+  /************************************************************************/
+  /*                                                                      */
+  /************************************************************************/
+  // ids of blocks whose headers are checked before downloading the blocks, sent to peers of P2P_PROTOCOL_VERSION_3 and later
+  struct NOTIFY_REQUEST_BLOCK_HEADERS_request
+  {
+    std::list<crypto::hash> blocks;
+
+    BEGIN_KV_SERIALIZE_MAP()
+      KV_SERIALIZE_CONTAINER_POD_AS_BLOB(blocks)
+    END_KV_SERIALIZE_MAP()
+  };
+
+  struct NOTIFY_REQUEST_BLOCK_HEADERS
+  {
+    const static int ID = BC_COMMANDS_POOL_BASE + 13;
+    typedef NOTIFY_REQUEST_BLOCK_HEADERS_request request;
+  };
+
+  // block blobs without transactions, in the order requested up to the first block the peer doesn't have
+  struct NOTIFY_RESPONSE_BLOCK_HEADERS_request
+  {
+    std::list<blobdata> headers;
+
+    BEGIN_KV_SERIALIZE_MAP()
+      KV_SERIALIZE(headers)
+    END_KV_SERIALIZE_MAP()
+  };
+
+  struct NOTIFY_RESPONSE_BLOCK_HEADERS
+  {
+    const static int ID = BC_COMMANDS_POOL_BASE + 14;
+    typedef NOTIFY_RESPONSE_BLOCK_HEADERS_request request;
+  };
+
 }
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <atomic>
+#include <memory>
 
 #include <boost/program_options/variables_map.hpp>
 #include <common/ObserverManager.h>
@@ -26,8 +27,12 @@
 #include "storages/levin_abstract_invoke2.h"
 #include "warnings.h"
 
+#include "cryptonote_core/BlockDownloadScheduler.h"
+#include "cryptonote_core/BlockHeaderChain.h"
 #include "cryptonote_core/connection_context.h"
 #include "cryptonote_core/cryptonote_stat_info.h"
+#include "cryptonote_core/TransactionAdmissionQueue.h"
+#include "cryptonote_core/TransactionInventory.h"
 #include "cryptonote_core/verification_context.h"
 #include "cryptonote_protocol/cryptonote_protocol_defs.h"
 #include "cryptonote_protocol/cryptonote_protocol_handler_common.h"
@@ -57,6 +62,13 @@ namespace cryptonote {
       HANDLE_NOTIFY_T2(NOTIFY_RESPONSE_GET_OBJECTS, &cryptonote_protocol_handler::handle_response_get_objects)
       HANDLE_NOTIFY_T2(NOTIFY_REQUEST_CHAIN, &cryptonote_protocol_handler::handle_request_chain)
       HANDLE_NOTIFY_T2(NOTIFY_RESPONSE_CHAIN_ENTRY, &cryptonote_protocol_handler::handle_response_chain_entry)
+      HANDLE_NOTIFY_T2(NOTIFY_NEW_COMPACT_BLOCK, &cryptonote_protocol_handler::handle_notify_new_compact_block)
+      HANDLE_NOTIFY_T2(NOTIFY_REQUEST_BLOCK_TXS, &cryptonote_protocol_handler::handle_request_block_txs)
+      HANDLE_NOTIFY_T2(NOTIFY_RESPONSE_BLOCK_TXS, &cryptonote_protocol_handler::handle_response_block_txs)
+      HANDLE_NOTIFY_T2(NOTIFY_TX_INVENTORY, &cryptonote_protocol_handler::handle_notify_tx_inventory)
+      HANDLE_NOTIFY_T2(NOTIFY_REQUEST_TXS, &cryptonote_protocol_handler::handle_request_txs)
+      HANDLE_NOTIFY_T2(NOTIFY_REQUEST_BLOCK_HEADERS, &cryptonote_protocol_handler::handle_request_block_headers)
+      HANDLE_NOTIFY_T2(NOTIFY_RESPONSE_BLOCK_HEADERS, &cryptonote_protocol_handler::handle_response_block_headers)
     END_INVOKE_MAP2()
 
     bool init();
@@ -90,13 +102,31 @@ namespace cryptonote {
     int handle_response_get_objects(int command, NOTIFY_RESPONSE_GET_OBJECTS::request& arg, cryptonote_connection_context& context);
     int handle_request_chain(int command, NOTIFY_REQUEST_CHAIN::request& arg, cryptonote_connection_context& context);
     int handle_response_chain_entry(int command, NOTIFY_RESPONSE_CHAIN_ENTRY::request& arg, cryptonote_connection_context& context);
+    int handle_notify_new_compact_block(int command, NOTIFY_NEW_COMPACT_BLOCK::request& arg, cryptonote_connection_context& context);
+    int handle_request_block_txs(int command, NOTIFY_REQUEST_BLOCK_TXS::request& arg, cryptonote_connection_context& context);
+    int handle_response_block_txs(int command, NOTIFY_RESPONSE_BLOCK_TXS::request& arg, cryptonote_connection_context& context);
+    int handle_notify_tx_inventory(int command, NOTIFY_TX_INVENTORY::request& arg, cryptonote_connection_context& context);
+    int handle_request_txs(int command, NOTIFY_REQUEST_TXS::request& arg, cryptonote_connection_context& context);
+    int handle_request_block_headers(int command, NOTIFY_REQUEST_BLOCK_HEADERS::request& arg, cryptonote_connection_context& context);
+    int handle_response_block_headers(int command, NOTIFY_RESPONSE_BLOCK_HEADERS::request& arg, cryptonote_connection_context& context);
 
     //----------------- i_cryptonote_protocol ----------------------------------
     virtual void relay_block(NOTIFY_NEW_BLOCK::request& arg, cryptonote_connection_context& exclude_context) override;
     virtual void relay_transactions(NOTIFY_NEW_TRANSACTIONS::request& arg, cryptonote_connection_context& exclude_context) override;
     //----------------------------------------------------------------------------------
 
+    // returns false if transactions of the block are missing, which doesn't make the block or the peer bad
+    bool process_new_block(NOTIFY_NEW_BLOCK::request& arg, cryptonote_connection_context& context);
+    void complete_new_block(NOTIFY_NEW_BLOCK::request& arg, cryptonote_connection_context& context, bool txs_requested);
+    bool fill_block_txs(NOTIFY_NEW_BLOCK::request& arg);
+    void admit_transactions(NOTIFY_NEW_TRANSACTIONS::request& arg, cryptonote_connection_context& context);
     bool request_missing_objects(cryptonote_connection_context& context, bool check_having_blocks);
+    bool start_header_sync(cryptonote_connection_context& context, uint64_t height, const crypto::hash& prev_id, const std::vector<crypto::hash>& ids);
+    void schedule_checked_blocks(cryptonote_connection_context& context, uint64_t height, const std::vector<crypto::hash>& ids);
+    bool add_blocks(const std::list<block_complete_entry>& entries, const std::vector<Block>& blocks, cryptonote_connection_context& context);
+    void add_scheduled_blocks(cryptonote_connection_context& context);
+    void wake_waiting_connections();
+    void send_tx_inventories();
     size_t get_synchronizing_connections_count();
     bool on_connection_synchronized();
     void updateObservedHeight(uint64_t peerHeight, const cryptonote_connection_context& context);
@@ -106,9 +136,9 @@ namespace cryptonote {
     bool post_notify(typename t_parametr::request& arg, cryptonote_connection_context& context)
     {
       LOG_PRINT_L2("[" << epee::net_utils::print_connection_context_short(context) << "] post " << typeid(t_parametr).name() << " -->");
-      std::string blob;
-      epee::serialization::store_t_to_binary(arg, blob);
-      return m_p2p->invoke_notify_to_peer(t_parametr::ID, blob, context);
+      std::shared_ptr<std::string> blob = std::make_shared<std::string>();
+      epee::serialization::store_t_to_binary(arg, *blob);
+      return m_p2p->invoke_notify_to_peer(t_parametr::ID, epee::net_utils::shared_buffer(blob), context);
     }
 
     template<class t_parametr>
@@ -133,6 +163,9 @@ namespace cryptonote {
 
     std::atomic<size_t> m_peersCount;
     tools::ObserverManager<ICryptonoteProtocolObserver> m_observerManager;
+    CryptoNote::TransactionAdmissionQueue m_admissionQueue;
+    CryptoNote::BlockDownloadScheduler m_downloads;
+    CryptoNote::TransactionInventory m_inventory;
   };
 }
 
@@ -29,7 +29,10 @@ namespace cryptonote
       m_p2p(p_net_layout),
       m_synchronized(false),
       m_stop(false),
-      m_observedHeight(0) {
+      m_observedHeight(0),
+      m_admissionQueue(std::max(std::thread::hardware_concurrency(), 1u), TX_ADMISSION_MAX_PENDING_BATCHES, TX_ADMISSION_MAX_PEER_PENDING_BATCHES),
+      m_downloads(BLOCKS_SYNCHRONIZING_DEFAULT_COUNT, BLOCKS_SYNCHRONIZING_WINDOW, std::chrono::seconds(BLOCKS_SYNCHRONIZING_SPAN_TIMEOUT)),
+      m_inventory(TX_INVENTORY_KNOWN_LIMIT, TX_INVENTORY_QUEUE_LIMIT, std::chrono::seconds(TX_INVENTORY_REQUEST_TIMEOUT), TX_INVENTORY_SERVED_PER_SECOND) {
     if (!m_p2p) {
       m_p2p = &m_p2p_stub;
     }
@@ -86,12 +89,17 @@ namespace cryptonote
       m_peersCount--;
       m_observerManager.notify(&ICryptonoteProtocolObserver::peerCountUpdated, m_peersCount.load());
     }
+
+    m_downloads.releasePeer(context.m_connection_id);
+    wake_waiting_connections();
+    m_inventory.removePeer(context.m_connection_id);
   }
 
   //------------------------------------------------------------------------------------------------------------------------  
   template<class t_core>
   void t_cryptonote_protocol_handler<t_core>::stop() {
     m_stop = true;
+    m_admissionQueue.stop();
   }
 
   //------------------------------------------------------------------------------------------------------------------------  
@@ -102,7 +110,10 @@ namespace cryptonote
     CHECK_AND_ASSERT_MES_CC( context.m_callback_request_count > 0, false, "false callback fired, but context.m_callback_request_count=" << context.m_callback_request_count);
     --context.m_callback_request_count;
 
-    if(context.m_state == cryptonote_connection_context::state_synchronizing)
+    if (context.m_waiting_for_blocks) {
+      context.m_waiting_for_blocks = false;
+      request_missing_objects(context, true);
+    } else if(context.m_state == cryptonote_connection_context::state_synchronizing && !context.m_shares_download)
     {
       NOTIFY_REQUEST_CHAIN::request r = boost::value_initialized<NOTIFY_REQUEST_CHAIN::request>();
       m_core.get_short_chain_history(r.block_ids);
@@ -149,6 +160,8 @@ namespace cryptonote
     if(context.m_state == cryptonote_connection_context::state_befor_handshake && !is_inital)
       return true;
 
+    context.m_version = hshd.version;
+
     if(context.m_state == cryptonote_connection_context::state_synchronizing) {
     } else if(m_core.have_block(hshd.top_id)) {
       context.m_state = cryptonote_connection_context::state_normal;
@@ -185,6 +198,7 @@ namespace cryptonote
   {
     m_core.get_blockchain_top(hshd.current_height, hshd.top_id);
     hshd.current_height +=1;
+    hshd.version = P2P_CURRENT_PROTOCOL_VERSION;
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------  
@@ -200,22 +214,169 @@ namespace cryptonote
       return 1;
     }
 
+    process_new_block(arg, context);
+    return 1;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  int t_cryptonote_protocol_handler<t_core>::handle_notify_new_compact_block(int command, NOTIFY_NEW_COMPACT_BLOCK::request& arg, cryptonote_connection_context& context) {
+    LOG_PRINT_CCONTEXT_L2("NOTIFY_NEW_COMPACT_BLOCK (hop " << arg.hop << ")");
+
+    updateObservedHeight(arg.current_blockchain_height, context);
+
+    context.m_remote_blockchain_height = arg.current_blockchain_height;
+
+    if (context.m_state != cryptonote_connection_context::state_normal) {
+      return 1;
+    }
+
+    NOTIFY_NEW_BLOCK::request block_arg = AUTO_VAL_INIT(block_arg);
+    block_arg.b.block = std::move(arg.block);
+    block_arg.current_blockchain_height = arg.current_blockchain_height;
+    block_arg.hop = arg.hop;
+    complete_new_block(block_arg, context, false);
+    return 1;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  int t_cryptonote_protocol_handler<t_core>::handle_request_block_txs(int command, NOTIFY_REQUEST_BLOCK_TXS::request& arg, cryptonote_connection_context& context) {
+    LOG_PRINT_CCONTEXT_L2("NOTIFY_REQUEST_BLOCK_TXS: txs.size()=" << arg.txs.size());
+
+    Block b;
+    if (!m_core.get_block_by_hash(arg.block_id, b)) {
+      LOG_PRINT_CCONTEXT_L1("requested transactions of unknown block " << epee::string_tools::pod_to_hex(arg.block_id));
+      return 1;
+    }
+
+    std::unordered_set<crypto::hash> block_txs(b.txHashes.begin(), b.txHashes.end());
+    std::vector<crypto::hash> tx_ids;
+    for (const crypto::hash& tx_id : arg.txs) {
+      if (!block_txs.count(tx_id)) {
+        LOG_ERROR_CCONTEXT("requested transaction " << epee::string_tools::pod_to_hex(tx_id) << " which isn't in block "
+          << epee::string_tools::pod_to_hex(arg.block_id) << ", dropping connection");
+        m_p2p->drop_connection(context);
+        return 1;
+      }
+      tx_ids.push_back(tx_id);
+    }
+
+    // transactions of alternative blocks and of blocks popped by a reorganization are kept in the pool
+    std::list<Transaction> txs;
+    std::list<crypto::hash> missed_txs;
+    m_core.get_transactions(tx_ids, txs, missed_txs, true);
+    if (!missed_txs.empty()) {
+      LOG_PRINT_CCONTEXT_L1("transactions of block " << epee::string_tools::pod_to_hex(arg.block_id) << " are no longer known, they aren't sent");
+      return 1;
+    }
+
+    NOTIFY_RESPONSE_BLOCK_TXS::request rsp = AUTO_VAL_INIT(rsp);
+    rsp.b.block = block_to_blob(b);
+    for (const Transaction& tx : txs) {
+      rsp.b.txs.push_back(tx_to_blob(tx));
+    }
+    rsp.current_blockchain_height = m_core.get_current_blockchain_height();
+    rsp.hop = arg.hop;
+    post_notify<NOTIFY_RESPONSE_BLOCK_TXS>(rsp, context);
+    return 1;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  int t_cryptonote_protocol_handler<t_core>::handle_response_block_txs(int command, NOTIFY_RESPONSE_BLOCK_TXS::request& arg, cryptonote_connection_context& context) {
+    LOG_PRINT_CCONTEXT_L2("NOTIFY_RESPONSE_BLOCK_TXS: txs.size()=" << arg.b.txs.size());
+
+    updateObservedHeight(arg.current_blockchain_height, context);
+
+    context.m_remote_blockchain_height = arg.current_blockchain_height;
+
+    if (context.m_state != cryptonote_connection_context::state_normal) {
+      return 1;
+    }
+
+    complete_new_block(arg, context, true);
+    return 1;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  void t_cryptonote_protocol_handler<t_core>::complete_new_block(NOTIFY_NEW_BLOCK::request& arg, cryptonote_connection_context& context, bool txs_requested) {
+    Block b;
+    if (!parse_and_validate_block_from_blob(arg.b.block, b)) {
+      LOG_ERROR_CCONTEXT("sent wrong block: failed to parse and validate block: \r\n"
+        << epee::string_tools::buff_to_hex_nodelimer(arg.b.block) << "\r\n dropping connection");
+      m_p2p->drop_connection(context);
+      return;
+    }
+
+    // the transactions of a known block have left the pool already, there is nothing to complete
+    if (m_core.have_block(get_block_hash(b))) {
+      return;
+    }
+
+    std::unordered_set<crypto::hash> sent_txs;
+    for (const blobdata& tx_blob : arg.b.txs) {
+      sent_txs.insert(get_blob_hash(tx_blob));
+    }
+
+    NOTIFY_REQUEST_BLOCK_TXS::request req = AUTO_VAL_INIT(req);
+    for (const crypto::hash& tx_id : b.txHashes) {
+      if (!sent_txs.count(tx_id) && !m_core.pool_has_tx(tx_id)) {
+        req.txs.push_back(tx_id);
+      }
+    }
+
+    crypto::hash block_id = get_block_hash(b);
+    if (req.txs.empty()) {
+      bool full_block_requested = context.m_requested_full_block == block_id;
+      context.m_requested_full_block = null_hash;
+      if (process_new_block(arg, context) || full_block_requested) {
+        return;
+      }
+
+      // transactions found in the pool left it before the block was added, the whole block is requested instead
+      LOG_PRINT_CCONTEXT_L1("transactions of block " << epee::string_tools::pod_to_hex(block_id) << " left the pool, requesting all of them");
+      context.m_requested_full_block = block_id;
+      req.txs.assign(b.txHashes.begin(), b.txHashes.end());
+    } else if (txs_requested) {
+      if (context.m_requested_full_block == block_id) {
+        LOG_ERROR_CCONTEXT("sent block without requested transactions, dropping connection");
+        m_p2p->drop_connection(context);
+        return;
+      }
+
+      // transactions announced earlier may have left the pool since, the whole block is requested instead
+      LOG_PRINT_CCONTEXT_L1("transactions of block " << epee::string_tools::pod_to_hex(block_id) << " left the pool, requesting all of them");
+      context.m_requested_full_block = block_id;
+      req.txs.assign(b.txHashes.begin(), b.txHashes.end());
+    }
+
+    req.block_id = block_id;
+    req.hop = arg.hop;
+    LOG_PRINT_CCONTEXT_L2("-->>NOTIFY_REQUEST_BLOCK_TXS: txs.size()=" << req.txs.size());
+    post_notify<NOTIFY_REQUEST_BLOCK_TXS>(req, context);
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  bool t_cryptonote_protocol_handler<t_core>::process_new_block(NOTIFY_NEW_BLOCK::request& arg, cryptonote_connection_context& context) {
     for (auto tx_blob_it = arg.b.txs.begin(); tx_blob_it != arg.b.txs.end(); tx_blob_it++) {
       cryptonote::tx_verification_context tvc = AUTO_VAL_INIT(tvc);
       m_core.handle_incoming_tx(*tx_blob_it, tvc, true);
       if (tvc.m_verifivation_failed) {
         LOG_PRINT_CCONTEXT_L0("Block verification failed: transaction verification failed, dropping connection");
         m_p2p->drop_connection(context);
-        return 1;
+        return true;
       }
     }
 
     block_verification_context bvc = boost::value_initialized<block_verification_context>();
     m_core.handle_incoming_block_blob(arg.b.block, bvc, true, false);
+    if (bvc.m_missing_transactions) {
+      // pool transactions can be evicted or taken by another block before this one is added, the peer isn't to blame
+      LOG_PRINT_CCONTEXT_L1("Block transactions are missing in the pool");
+      return false;
+    }
     if (bvc.m_verifivation_failed) {
       LOG_PRINT_CCONTEXT_L1("Block verification failed, dropping connection");
       m_p2p->drop_connection(context);
-      return 1;
+      return true;
     }
     if (bvc.m_added_to_main_chain) {
       ++arg.hop;
@@ -229,7 +390,7 @@ namespace cryptonote
       post_notify<NOTIFY_REQUEST_CHAIN>(r, context);
     }
 
-    return 1;
+    return true;
   }
   //------------------------------------------------------------------------------------------------------------------------
   template<class t_core> 
@@ -239,6 +400,37 @@ namespace cryptonote
     if(context.m_state != cryptonote_connection_context::state_normal)
       return 1;
 
+    std::vector<crypto::hash> tx_ids;
+    tx_ids.reserve(arg.txs.size());
+    for (const blobdata& tx_blob : arg.txs) {
+      tx_ids.push_back(get_blob_hash(tx_blob));
+    }
+
+    if (context.m_version >= P2P_PROTOCOL_VERSION_2) {
+      m_inventory.addKnown(context.m_connection_id, tx_ids);
+    }
+
+    // verification runs on the admission workers so the network thread can serve the peer's next message
+    std::shared_ptr<NOTIFY_NEW_TRANSACTIONS::request> batch = std::make_shared<NOTIFY_NEW_TRANSACTIONS::request>();
+    batch->txs.swap(arg.txs);
+    cryptonote_connection_context batch_context = context;
+    bool queued = m_admissionQueue.push(context.m_connection_id, [this, batch, batch_context]() mutable {
+      admit_transactions(*batch, batch_context);
+    });
+
+    if (queued) {
+      m_inventory.finishRequests(tx_ids);
+    } else {
+      // requests of dropped transactions expire and are sent to another peer
+      LOG_PRINT_CCONTEXT_L1("too many transactions waiting for verification, dropped " << batch->txs.size() << " of them");
+    }
+
+    return 1;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  void t_cryptonote_protocol_handler<t_core>::admit_transactions(NOTIFY_NEW_TRANSACTIONS::request& arg, cryptonote_connection_context& context)
+  {
     for(auto tx_blob_it = arg.txs.begin(); tx_blob_it!=arg.txs.end();)
     {
       cryptonote::tx_verification_context tvc = AUTO_VAL_INIT(tvc);
@@ -247,7 +439,7 @@ namespace cryptonote
       {
         LOG_PRINT_CCONTEXT_L0("Tx verification failed, dropping connection");
         m_p2p->drop_connection(context);
-        return 1;
+        return;
       }
       if(tvc.m_should_be_relayed)
         ++tx_blob_it;
@@ -257,11 +449,156 @@ namespace cryptonote
 
     if(arg.txs.size())
     {
-      //TODO: add announce usage here
       relay_transactions(arg, context);
     }
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  int t_cryptonote_protocol_handler<t_core>::handle_notify_tx_inventory(int command, NOTIFY_TX_INVENTORY::request& arg, cryptonote_connection_context& context)
+  {
+    LOG_PRINT_CCONTEXT_L2("NOTIFY_TX_INVENTORY: txs.size()=" << arg.txs.size());
+    if(context.m_state != cryptonote_connection_context::state_normal)
+      return 1;
 
-    return true;
+    if (arg.txs.size() > TX_INVENTORY_MAX_COUNT) {
+      LOG_ERROR_CCONTEXT("sent too many transaction hashes: " << arg.txs.size() << ", dropping connection");
+      m_p2p->drop_connection(context);
+      return 1;
+    }
+
+    std::vector<crypto::hash> tx_ids(arg.txs.begin(), arg.txs.end());
+    m_inventory.addKnown(context.m_connection_id, tx_ids);
+
+    std::vector<crypto::hash> unknown_ids;
+    for (const crypto::hash& tx_id : tx_ids) {
+      if (!m_core.have_tx(tx_id)) {
+        unknown_ids.push_back(tx_id);
+      }
+    }
+
+    // transactions announced by several peers are requested from the first one only, the next one if it doesn't send them
+    std::vector<crypto::hash> requested_ids = m_inventory.startRequests(context.m_connection_id, unknown_ids);
+    if (!requested_ids.empty()) {
+      NOTIFY_REQUEST_TXS::request req;
+      req.txs.assign(requested_ids.begin(), requested_ids.end());
+      LOG_PRINT_CCONTEXT_L2("-->>NOTIFY_REQUEST_TXS: txs.size()=" << req.txs.size());
+      post_notify<NOTIFY_REQUEST_TXS>(req, context);
+    }
+
+    return 1;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  int t_cryptonote_protocol_handler<t_core>::handle_request_txs(int command, NOTIFY_REQUEST_TXS::request& arg, cryptonote_connection_context& context)
+  {
+    LOG_PRINT_CCONTEXT_L2("NOTIFY_REQUEST_TXS: txs.size()=" << arg.txs.size());
+    if (arg.txs.size() > TX_INVENTORY_MAX_COUNT) {
+      LOG_ERROR_CCONTEXT("requested too many transactions: " << arg.txs.size() << ", dropping connection");
+      m_p2p->drop_connection(context);
+      return 1;
+    }
+
+    size_t served = m_inventory.takeServed(context.m_connection_id, arg.txs.size());
+    if (served < arg.txs.size()) {
+      LOG_PRINT_CCONTEXT_L1("requests transactions too often, not sending " << arg.txs.size() - served << " of them");
+    }
+
+    std::list<Transaction> txs;
+    std::list<crypto::hash> missed_txs;
+    auto end = arg.txs.begin();
+    std::advance(end, served);
+    m_core.get_transactions(std::vector<crypto::hash>(arg.txs.begin(), end), txs, missed_txs, true);
+
+    // transactions that left the pool meanwhile are simply not sent
+    NOTIFY_NEW_TRANSACTIONS::request rsp;
+    for (const Transaction& tx : txs) {
+      rsp.txs.push_back(tx_to_blob(tx));
+    }
+
+    if (!rsp.txs.empty()) {
+      post_notify<NOTIFY_NEW_TRANSACTIONS>(rsp, context);
+    }
+
+    return 1;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  int t_cryptonote_protocol_handler<t_core>::handle_request_block_headers(int command, NOTIFY_REQUEST_BLOCK_HEADERS::request& arg, cryptonote_connection_context& context)
+  {
+    LOG_PRINT_CCONTEXT_L2("NOTIFY_REQUEST_BLOCK_HEADERS: blocks.size()=" << arg.blocks.size());
+    if (arg.blocks.size() > BLOCK_HEADERS_SYNCHRONIZING_DEFAULT_COUNT) {
+      LOG_ERROR_CCONTEXT("requested too many block headers: " << arg.blocks.size() << ", dropping connection");
+      m_p2p->drop_connection(context);
+      return 1;
+    }
+
+    // a block blob holds the header, the miner transaction and the transaction hashes, which is all the block id and
+    // the proof of work commit to
+    NOTIFY_RESPONSE_BLOCK_HEADERS::request rsp;
+    for (const crypto::hash& block_id : arg.blocks) {
+      Block b;
+      if (!m_core.get_block_by_hash(block_id, b)) {
+        break;
+      }
+
+      rsp.headers.push_back(block_to_blob(b));
+    }
+
+    LOG_PRINT_CCONTEXT_L2("-->>NOTIFY_RESPONSE_BLOCK_HEADERS: headers.size()=" << rsp.headers.size());
+    post_notify<NOTIFY_RESPONSE_BLOCK_HEADERS>(rsp, context);
+    return 1;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  int t_cryptonote_protocol_handler<t_core>::handle_response_block_headers(int command, NOTIFY_RESPONSE_BLOCK_HEADERS::request& arg, cryptonote_connection_context& context)
+  {
+    LOG_PRINT_CCONTEXT_L2("NOTIFY_RESPONSE_BLOCK_HEADERS: headers.size()=" << arg.headers.size());
+    if (context.m_requested_headers.empty() || context.m_requested_headers.size() < arg.headers.size()) {
+      LOG_ERROR_CCONTEXT("sent unrequested block headers, dropping connection");
+      m_p2p->drop_connection(context);
+      return 1;
+    }
+
+    std::vector<Block> headers;
+    std::vector<crypto::hash> ids;
+    auto requested_it = context.m_requested_headers.begin();
+    for (const blobdata& header_blob : arg.headers) {
+      headers.push_back(Block());
+      if (header_blob.size() > m_core.currency().maxBlockBlobSize() || !parse_and_validate_block_from_blob(header_blob, headers.back()) ||
+          get_block_hash(headers.back()) != *requested_it) {
+        LOG_ERROR_CCONTEXT("sent wrong block header, dropping connection");
+        m_p2p->drop_connection(context);
+        return 1;
+      }
+
+      ids.push_back(*requested_it++);
+    }
+
+    if (ids.size() < context.m_requested_headers.size()) {
+      // the peer switched to another chain meanwhile
+      LOG_PRINT_CCONTEXT_L1("sent " << ids.size() << " of " << context.m_requested_headers.size() << " requested block headers");
+      context.m_needed_headers.clear();
+    }
+
+    context.m_requested_headers.clear();
+    uint64_t height = context.m_header_chain->height();
+    if (!m_core.check_block_headers(*context.m_header_chain, headers)) {
+      LOG_ERROR_CCONTEXT("sent block headers failing checks, dropping connection");
+      m_p2p->drop_connection(context);
+      return 1;
+    }
+
+    if (!ids.empty()) {
+      schedule_checked_blocks(context, height, ids);
+    }
+
+    if (context.m_needed_headers.empty()) {
+      // the rest of the chain is requested again, from the last checked header on
+      context.m_last_response_height = context.m_header_chain->height() - 1;
+    }
+
+    request_missing_objects(context, false);
+    return 1;
   }
   //------------------------------------------------------------------------------------------------------------------------
   template<class t_core> 
@@ -296,11 +633,15 @@ namespace cryptonote
 
     context.m_remote_blockchain_height = arg.current_blockchain_height;
 
+    bool scheduled = m_downloads.hasSpan(context.m_connection_id);
     size_t count = 0;
+    std::vector<Block> blocks;
+    blocks.reserve(arg.blocks.size());
     for (const block_complete_entry& block_entry : arg.blocks)
     {
       ++count;
-      Block b;
+      blocks.emplace_back();
+      Block& b = blocks.back();
       if(!parse_and_validate_block_from_blob(block_entry.block, b))
       {
         LOG_ERROR_CCONTEXT("sent wrong block: failed to parse and validate block: \r\n" 
@@ -309,7 +650,7 @@ namespace cryptonote
         return 1;
       }
       //to avoid concurrency in core between connections, suspend connections which delivered block later then first one
-      if(count == 2)
+      if(count == 2 && !scheduled)
       { 
         if(m_core.have_block(get_block_hash(b)))
         {
@@ -348,61 +689,136 @@ namespace cryptonote
       return 1;
     }
 
-    {
-      m_core.pause_mining();
-      epee::misc_utils::auto_scope_leave_caller scope_exit_handler = epee::misc_utils::create_scope_leave_handler(
-        std::bind(&t_core::update_block_template_and_resume_mining, &m_core));
+    if (scheduled) {
+      if (m_downloads.deliverSpan(context.m_connection_id, std::move(arg.blocks)) == CryptoNote::BlockDownloadScheduler::Delivery::accepted) {
+        add_scheduled_blocks(context);
+      } else {
+        LOG_PRINT_CCONTEXT_L1("Blocks were requested from another peer meanwhile, ignoring them");
+      }
+    } else if (!add_blocks(arg.blocks, blocks, context)) {
+      m_p2p->drop_connection(context);
+      return 1;
+    }
 
-      for (const block_complete_entry& block_entry : arg.blocks) {
-        if (m_stop) {
-          break;
-        }
+    if (!m_stop) {
+      request_missing_objects(context, true);
+      wake_waiting_connections();
+    }
 
-        //process transactions
-        TIME_MEASURE_START(transactions_process_time);
-        for (auto& tx_blob : block_entry.txs) {
-          tx_verification_context tvc = AUTO_VAL_INIT(tvc);
-          m_core.handle_incoming_tx(tx_blob, tvc, true);
-          if (tvc.m_verifivation_failed) {
-            LOG_ERROR_CCONTEXT("transaction verification failed on NOTIFY_RESPONSE_GET_OBJECTS, \r\ntx_id = " 
-              << epee::string_tools::pod_to_hex(get_blob_hash(tx_blob)) << ", dropping connection");
-            m_p2p->drop_connection(context);
-            return 1;
-          }
-        }
-        TIME_MEASURE_FINISH(transactions_process_time);
+    return 1;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  bool t_cryptonote_protocol_handler<t_core>::add_blocks(const std::list<block_complete_entry>& entries, const std::vector<Block>& blocks, cryptonote_connection_context& context)
+  {
+    // proof of work depends only on block headers, so it is computed for the whole batch in the background while blocks are added
+    m_core.precompute_blocks_longhash(blocks);
 
-        //process block
-        TIME_MEASURE_START(block_process_time);
-        block_verification_context bvc = boost::value_initialized<block_verification_context>();
-        m_core.handle_incoming_block_blob(block_entry.block, bvc, false, false);
+    m_core.pause_mining();
+    epee::misc_utils::auto_scope_leave_caller scope_exit_handler = epee::misc_utils::create_scope_leave_handler(
+      std::bind(&t_core::update_block_template_and_resume_mining, &m_core));
 
-        if (bvc.m_verifivation_failed) {
-          LOG_PRINT_CCONTEXT_L1("Block verification failed, dropping connection");
-          m_p2p->drop_connection(context);
-          return 1;
-        } else if (bvc.m_marked_as_orphaned) {
-          LOG_PRINT_CCONTEXT_L0("Block received at sync phase was marked as orphaned, dropping connection");
-          m_p2p->drop_connection(context);
-          return 1;
+    for (const block_complete_entry& block_entry : entries) {
+      if (m_stop) {
+        break;
+      }
+
+      //process transactions
+      TIME_MEASURE_START(transactions_process_time);
+      for (auto& tx_blob : block_entry.txs) {
+        tx_verification_context tvc = AUTO_VAL_INIT(tvc);
+        m_core.handle_incoming_tx(tx_blob, tvc, true);
+        if (tvc.m_verifivation_failed) {
+          LOG_ERROR_CCONTEXT("transaction verification failed on NOTIFY_RESPONSE_GET_OBJECTS, \r\ntx_id = " 
+            << epee::string_tools::pod_to_hex(get_blob_hash(tx_blob)));
+          return false;
         }
+      }
+      TIME_MEASURE_FINISH(transactions_process_time);
+
+      //process block
+      TIME_MEASURE_START(block_process_time);
+      block_verification_context bvc = boost::value_initialized<block_verification_context>();
+      m_core.handle_incoming_block_blob(block_entry.block, bvc, false, false);
 
-        TIME_MEASURE_FINISH(block_process_time);
-        LOG_PRINT_CCONTEXT_L2("Block process time: " << block_process_time + transactions_process_time <<
-          " (" << transactions_process_time << " / " << block_process_time << ") ms");
+      if (bvc.m_verifivation_failed) {
+        LOG_PRINT_CCONTEXT_L1("Block verification failed");
+        return false;
+      } else if (bvc.m_marked_as_orphaned) {
+        LOG_PRINT_CCONTEXT_L0("Block received at sync phase was marked as orphaned");
+        return false;
       }
+
+      TIME_MEASURE_FINISH(block_process_time);
+      LOG_PRINT_CCONTEXT_L2("Block process time: " << block_process_time + transactions_process_time <<
+        " (" << transactions_process_time << " / " << block_process_time << ") ms");
     }
 
-    if (!m_stop) {
-      request_missing_objects(context, true);
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  void t_cryptonote_protocol_handler<t_core>::add_scheduled_blocks(cryptonote_connection_context& context)
+  {
+    // spans delivered by other connections are added here too, but only by one connection at a time and in height order
+    bool feeding = false;
+    std::list<block_complete_entry> entries;
+    CryptoNote::BlockDownloadScheduler::PeerId deliverer;
+    while (!m_stop && m_downloads.takeReady(feeding, entries, deliverer)) {
+      std::vector<Block> blocks;
+      blocks.reserve(entries.size());
+      bool added = true;
+      for (const block_complete_entry& block_entry : entries) {
+        blocks.emplace_back();
+        if (!parse_and_validate_block_from_blob(block_entry.block, blocks.back())) {
+          added = false;
+          break;
+        }
+      }
+
+      if (added) {
+        added = add_blocks(entries, blocks, context);
+      }
+
+      if (!added) {
+        LOG_PRINT_CCONTEXT_L0("Failed to add downloaded blocks, downloading them again and dropping the connection which delivered them");
+        m_downloads.retryTaken();
+        m_p2p->for_each_connection([&](cryptonote_connection_context& ctx, nodetool::peerid_type peer_id)->bool {
+          if (ctx.m_connection_id == deliverer) {
+            m_p2p->drop_connection(ctx);
+            return false;
+          }
+          return true;
+        });
+        break;
+      }
+    }
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  void t_cryptonote_protocol_handler<t_core>::wake_waiting_connections()
+  {
+    std::vector<CryptoNote::BlockDownloadScheduler::PeerId> peers = m_downloads.takeWaitingPeers();
+    if (peers.empty()) {
+      return;
     }
 
-    return 1;
+    // only the scheduler knows which connections wait, their own state is read on their callbacks
+    m_p2p->for_each_connection([&](cryptonote_connection_context& context, nodetool::peerid_type peer_id)->bool {
+      if (std::find(peers.begin(), peers.end(), context.m_connection_id) != peers.end()) {
+        ++context.m_callback_request_count;
+        m_p2p->request_callback(context);
+      }
+      return true;
+    });
   }
   //------------------------------------------------------------------------------------------------------------------------
   template<class t_core> 
   bool t_cryptonote_protocol_handler<t_core>::on_idle()
   {
+    // picks up spans whose peers didn't deliver them in time
+    wake_waiting_connections();
+    send_tx_inventories();
     return m_core.on_idle();
   }
   //------------------------------------------------------------------------------------------------------------------------
@@ -443,6 +859,40 @@ namespace cryptonote
       }
       LOG_PRINT_CCONTEXT_L2("-->>NOTIFY_REQUEST_GET_OBJECTS: blocks.size()=" << req.blocks.size() << ", txs.size()=" << req.txs.size());
       post_notify<NOTIFY_REQUEST_GET_OBJECTS>(req, context);    
+    }else if(context.m_needed_headers.size() && !(context.m_shares_download && m_downloads.isActive() &&
+      context.m_header_chain->height() >= m_core.get_current_blockchain_height() + BLOCK_HEADERS_SYNCHRONIZING_AHEAD_COUNT))
+    {
+      //headers of the chain are checked before its blocks are requested from any peer, but a peer helping a shared
+      //download checks only so far ahead of it
+      auto end = context.m_needed_headers.begin();
+      std::advance(end, std::min(context.m_needed_headers.size(), BLOCK_HEADERS_SYNCHRONIZING_DEFAULT_COUNT));
+      context.m_requested_headers.splice(context.m_requested_headers.end(), context.m_needed_headers, context.m_needed_headers.begin(), end);
+      NOTIFY_REQUEST_BLOCK_HEADERS::request req;
+      req.blocks = context.m_requested_headers;
+      LOG_PRINT_CCONTEXT_L2("-->>NOTIFY_REQUEST_BLOCK_HEADERS: blocks.size()=" << req.blocks.size());
+      post_notify<NOTIFY_REQUEST_BLOCK_HEADERS>(req, context);
+    }else if(context.m_shares_download && m_downloads.isActive())
+    {
+      context.m_waiting_for_blocks = true;
+      std::vector<crypto::hash> ids;
+      CryptoNote::BlockDownloadScheduler::Reservation reservation = m_downloads.reserveSpan(context.m_connection_id, context.m_last_response_height, ids);
+      if (reservation == CryptoNote::BlockDownloadScheduler::Reservation::reserved) {
+        context.m_waiting_for_blocks = false;
+        NOTIFY_REQUEST_GET_OBJECTS::request req;
+        req.blocks.assign(ids.begin(), ids.end());
+        context.m_requested_objects.insert(ids.begin(), ids.end());
+        LOG_PRINT_CCONTEXT_L2("-->>NOTIFY_REQUEST_GET_OBJECTS: blocks.size()=" << req.blocks.size() << ", shared download");
+        post_notify<NOTIFY_REQUEST_GET_OBJECTS>(req, context);
+      } else if (reservation == CryptoNote::BlockDownloadScheduler::Reservation::waiting) {
+        LOG_PRINT_CCONTEXT_L2("Waiting for blocks to download");
+      } else {
+        // the blocks left to download are beyond the chain known of this peer, it goes on synchronizing on its own
+        LOG_PRINT_CCONTEXT_L1("Can't help the shared download, leaving it");
+        context.m_waiting_for_blocks = false;
+        context.m_shares_download = false;
+        context.m_needed_headers.clear();
+        return request_missing_objects(context, false);
+      }
     }else if(context.m_last_response_height < context.m_remote_blockchain_height-1)
     {//we have to fetch more objects ids, request blockchain entry
      
@@ -530,25 +980,216 @@ namespace cryptonote
       m_p2p->drop_connection(context);
     }
 
+    std::vector<crypto::hash> ids;
+    uint64_t height = arg.start_height;
+    crypto::hash prev_id = null_hash;
     for (auto& bl_id : arg.m_block_ids) {
-      if(!m_core.have_block(bl_id))
-        context.m_needed_objects.push_back(bl_id);
+      if (ids.empty() && m_core.have_block(bl_id)) {
+        ++height;
+        prev_id = bl_id;
+      } else {
+        ids.push_back(bl_id);
+      }
+    }
+
+    if (context.m_version >= P2P_PROTOCOL_VERSION_3 && !ids.empty() && start_header_sync(context, height, prev_id, ids)) {
+      request_missing_objects(context, false);
+      return 1;
+    }
+
+    // a chain other than the one being downloaded from other peers is downloaded from this peer alone
+    context.m_shares_download = !ids.empty() && m_downloads.addChain(context.m_connection_id, height, ids);
+    if (!context.m_shares_download) {
+      for (auto& bl_id : ids) {
+        if(!m_core.have_block(bl_id))
+          context.m_needed_objects.push_back(bl_id);
+      }
     }
 
     request_missing_objects(context, false);
     return 1;
   }
   //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  bool t_cryptonote_protocol_handler<t_core>::start_header_sync(cryptonote_connection_context& context, uint64_t height, const crypto::hash& prev_id, const std::vector<crypto::hash>& ids)
+  {
+    if (!context.m_header_chain) {
+      context.m_header_chain = std::make_shared<CryptoNote::BlockHeaderChain>(m_core.currency());
+    }
+
+    // headers checked with an earlier chain entry aren't requested again
+    CryptoNote::BlockHeaderChain& chain = *context.m_header_chain;
+    chain.forgetBelow(m_core.get_current_blockchain_height());
+    size_t checked = chain.countChecked(height, ids);
+    if (checked == 0 || (checked < ids.size() && chain.height() != height + checked)) {
+      // a chain forking off an alternative chain is downloaded without checking headers first
+      if (!m_core.start_header_chain(height, prev_id, chain)) {
+        return false;
+      }
+
+      checked = 0;
+    }
+
+    context.m_shares_download = false;
+    context.m_needed_headers.assign(ids.begin() + checked, ids.end());
+    context.m_requested_headers.clear();
+    if (checked != 0) {
+      schedule_checked_blocks(context, height, std::vector<crypto::hash>(ids.begin(), ids.begin() + checked));
+    }
+
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  void t_cryptonote_protocol_handler<t_core>::schedule_checked_blocks(cryptonote_connection_context& context, uint64_t height, const std::vector<crypto::hash>& ids)
+  {
+    if (m_downloads.addChain(context.m_connection_id, height, ids)) {
+      context.m_shares_download = true;
+    } else if (!context.m_shares_download) {
+      // a chain other than the one being downloaded from other peers is downloaded from this peer alone
+      for (auto& bl_id : ids) {
+        if (!m_core.have_block(bl_id)) {
+          context.m_needed_objects.push_back(bl_id);
+        }
+      }
+    } else {
+      // the shared download switched to another chain meanwhile, this one is requested again once it's done
+      context.m_needed_headers.clear();
+    }
+  }
+  //------------------------------------------------------------------------------------------------------------------------
   template<class t_core> 
   void t_cryptonote_protocol_handler<t_core>::relay_block(NOTIFY_NEW_BLOCK::request& arg, cryptonote_connection_context& exclude_context)
   {
-    relay_post_notify<NOTIFY_NEW_BLOCK>(arg, exclude_context);
+    NOTIFY_NEW_COMPACT_BLOCK::request compact_arg = AUTO_VAL_INIT(compact_arg);
+    compact_arg.block = arg.b.block;
+    compact_arg.current_blockchain_height = arg.current_blockchain_height;
+    compact_arg.hop = arg.hop;
+    std::shared_ptr<std::string> compact_blob = std::make_shared<std::string>();
+    epee::serialization::store_t_to_binary(compact_arg, *compact_blob);
+    epee::net_utils::shared_buffer compact_buffer = compact_blob;
+
+    // the full block is sent only to peers that don't understand compact ones, every peer queues the same buffer
+    std::shared_ptr<std::string> full_blob = std::make_shared<std::string>();
+    epee::net_utils::shared_buffer full_buffer = full_blob;
+    bool full_block_filled = false;
+    bool full_block_ready = false;
+    m_p2p->for_each_connection([&](cryptonote_connection_context& context, nodetool::peerid_type peer_id)->bool {
+      if (!peer_id || context.m_connection_id == exclude_context.m_connection_id) {
+        return true;
+      }
+
+      if (context.m_version >= P2P_PROTOCOL_VERSION_1) {
+        m_p2p->invoke_notify_to_peer(NOTIFY_NEW_COMPACT_BLOCK::ID, compact_buffer, context);
+        return true;
+      }
+
+      if (!full_block_filled) {
+        full_block_filled = true;
+        full_block_ready = fill_block_txs(arg);
+        if (full_block_ready) {
+          epee::serialization::store_t_to_binary(arg, *full_blob);
+        }
+      }
+
+      if (!full_block_ready) {
+        // the other peers still get the block
+        LOG_PRINT_CCONTEXT_L2("full block isn't available, not relaying it");
+        return true;
+      }
+
+      m_p2p->invoke_notify_to_peer(NOTIFY_NEW_BLOCK::ID, full_buffer, context);
+      return true;
+    });
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  bool t_cryptonote_protocol_handler<t_core>::fill_block_txs(NOTIFY_NEW_BLOCK::request& arg)
+  {
+    Block b;
+    if (!parse_and_validate_block_from_blob(arg.b.block, b)) {
+      LOG_ERROR("Failed to parse relayed block");
+      return false;
+    }
+
+    if (arg.b.txs.size() == b.txHashes.size()) {
+      return true;
+    }
+
+    // a block completed from the pool has the transactions in the blockchain by now
+    std::list<Transaction> txs;
+    std::list<crypto::hash> missed_txs;
+    m_core.get_transactions(b.txHashes, txs, missed_txs);
+    if (!missed_txs.empty()) {
+      LOG_PRINT_L1("Block " << get_block_hash(b) << " is no longer in the blockchain, not relaying it to old peers");
+      return false;
+    }
+
+    arg.b.txs.clear();
+    for (const Transaction& tx : txs) {
+      arg.b.txs.push_back(tx_to_blob(tx));
+    }
+
+    return true;
   }
   //------------------------------------------------------------------------------------------------------------------------
   template<class t_core> 
   void t_cryptonote_protocol_handler<t_core>::relay_transactions(NOTIFY_NEW_TRANSACTIONS::request& arg, cryptonote_connection_context& exclude_context)
   {
-    relay_post_notify<NOTIFY_NEW_TRANSACTIONS>(arg, exclude_context);
+    std::vector<crypto::hash> tx_ids;
+    tx_ids.reserve(arg.txs.size());
+    for (const blobdata& tx_blob : arg.txs) {
+      tx_ids.push_back(get_blob_hash(tx_blob));
+    }
+
+    // upgraded peers get the hashes with the next inventory, the others get the transactions right away
+    std::shared_ptr<std::string> blob = std::make_shared<std::string>();
+    epee::net_utils::shared_buffer buffer = blob;
+    m_p2p->for_each_connection([&](cryptonote_connection_context& context, nodetool::peerid_type peer_id)->bool {
+      if (!peer_id || context.m_connection_id == exclude_context.m_connection_id) {
+        return true;
+      }
+
+      if (context.m_version >= P2P_PROTOCOL_VERSION_2) {
+        m_inventory.queue(context.m_connection_id, tx_ids);
+      } else {
+        if (blob->empty()) {
+          epee::serialization::store_t_to_binary(arg, *blob);
+        }
+
+        m_p2p->invoke_notify_to_peer(NOTIFY_NEW_TRANSACTIONS::ID, buffer, context);
+      }
+
+      return true;
+    });
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  void t_cryptonote_protocol_handler<t_core>::send_tx_inventories()
+  {
+    std::map<CryptoNote::TransactionInventory::PeerId, std::vector<crypto::hash>> requests = m_inventory.expireRequests();
+    m_p2p->for_each_connection([&](cryptonote_connection_context& context, nodetool::peerid_type peer_id)->bool {
+      if (context.m_version < P2P_PROTOCOL_VERSION_2) {
+        return true;
+      }
+
+      auto request_it = requests.find(context.m_connection_id);
+      if (request_it != requests.end()) {
+        NOTIFY_REQUEST_TXS::request req;
+        req.txs.assign(request_it->second.begin(), request_it->second.end());
+        LOG_PRINT_CCONTEXT_L2("-->>NOTIFY_REQUEST_TXS: txs.size()=" << req.txs.size() << ", requested from another peer before");
+        post_notify<NOTIFY_REQUEST_TXS>(req, context);
+      }
+
+      std::vector<crypto::hash> tx_ids = m_inventory.takeQueued(context.m_connection_id, TX_INVENTORY_MAX_COUNT);
+      if (!tx_ids.empty()) {
+        NOTIFY_TX_INVENTORY::request inventory;
+        inventory.txs.assign(tx_ids.begin(), tx_ids.end());
+        post_notify<NOTIFY_TX_INVENTORY>(inventory, context);
+      }
+
+      return true;
+    });
   }
   //------------------------------------------------------------------------------------------------------------------------
   template<class t_core> 
@@ -212,7 +212,7 @@ int main(int argc, char* argv[])
   }
 
   LOG_PRINT_L0("Starting core rpc server...");
-  res = rpc_server.run(2, false);
+  res = rpc_server.run(2 + cryptonote::core_rpc_server::LONG_POLL_MAX_CONNECTIONS, false);
   CHECK_AND_ASSERT_MES(res, 1, "Failed to initialize core rpc server.");
   LOG_PRINT_L0("Core rpc server started ok");
 
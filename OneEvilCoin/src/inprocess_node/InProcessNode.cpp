@@ -494,5 +494,43 @@ void InProcessNode::getPoolSymmetricDifferenceAsync(std::vector<crypto::hash>& k
   callback(ec);
 }
 
+void InProcessNode::getPoolChanges(crypto::hash knownBlockId, uint64_t knownPoolVersion, bool& isBcActual, bool& isPoolVersionActual, uint64_t& poolVersion,
+  std::vector<cryptonote::Transaction>& newTxs, std::vector<crypto::hash>& deletedTxIds, const Callback& callback) {
+
+  std::unique_lock<std::mutex> lock(mutex);
+  if (state != INITIALIZED) {
+    lock.unlock();
+    callback(make_error_code(cryptonote::error::NOT_INITIALIZED));
+    return;
+  }
+
+  ioService.post(
+    std::bind(&InProcessNode::getPoolChangesAsync,
+      this,
+      knownBlockId,
+      knownPoolVersion,
+      std::ref(isBcActual),
+      std::ref(isPoolVersionActual),
+      std::ref(poolVersion),
+      std::ref(newTxs),
+      std::ref(deletedTxIds),
+      callback
+    )
+  );
+}
+
+void InProcessNode::getPoolChangesAsync(crypto::hash knownBlockId, uint64_t knownPoolVersion, bool& isBcActual, bool& isPoolVersionActual, uint64_t& poolVersion,
+  std::vector<cryptonote::Transaction>& newTxs, std::vector<crypto::hash>& deletedTxIds, const Callback& callback) {
+  std::error_code ec = std::error_code();
+
+  std::unique_lock<std::mutex> lock(mutex);
+  if (!core.getPoolChanges(knownBlockId, knownPoolVersion, isBcActual, isPoolVersionActual, poolVersion, newTxs, deletedTxIds)) {
+    ec = make_error_code(cryptonote::error::INTERNAL_NODE_ERROR);
+  }
+
+  lock.unlock();
+  callback(ec);
+}
+
 } //namespace CryptoNote
 
@@ -65,6 +65,8 @@ public:
       const Callback& callback) override;
   virtual void getPoolSymmetricDifference(std::vector<crypto::hash>&& known_pool_tx_ids, crypto::hash known_block_id, bool& is_bc_actual, std::vector<cryptonote::Transaction>& new_txs,
     std::vector<crypto::hash>& deleted_tx_ids, const Callback& callback) override;
+  virtual void getPoolChanges(crypto::hash knownBlockId, uint64_t knownPoolVersion, bool& isBcActual, bool& isPoolVersionActual, uint64_t& poolVersion,
+    std::vector<cryptonote::Transaction>& newTxs, std::vector<crypto::hash>& deletedTxIds, const Callback& callback) override;
 
 private:
   virtual void peerCountUpdated(size_t count) override;
@@ -92,6 +94,8 @@ private:
 
   void getPoolSymmetricDifferenceAsync(std::vector<crypto::hash>& known_pool_tx_ids, crypto::hash known_block_id, bool& is_bc_actual, std::vector<cryptonote::Transaction>& new_txs,
     std::vector<crypto::hash>& deleted_tx_ids, const Callback& callback);
+  void getPoolChangesAsync(crypto::hash knownBlockId, uint64_t knownPoolVersion, bool& isBcActual, bool& isPoolVersionActual, uint64_t& poolVersion,
+    std::vector<cryptonote::Transaction>& newTxs, std::vector<crypto::hash>& deletedTxIds, const Callback& callback);
 
   void workerFunc();
 
@@ -312,4 +312,12 @@ void NodeRpcProxy::getPoolSymmetricDifference(std::vector<crypto::hash>&& known_
   callback(std::error_code()); 
 };
 
+void NodeRpcProxy::getPoolChanges(crypto::hash knownBlockId, uint64_t knownPoolVersion, bool& isBcActual, bool& isPoolVersionActual, uint64_t& poolVersion,
+  std::vector<cryptonote::Transaction>& newTxs, std::vector<crypto::hash>& deletedTxIds, const Callback& callback) {
+  isBcActual = true;
+  isPoolVersionActual = false;
+  poolVersion = 0;
+  callback(std::error_code());
+}
+
 }
@@ -133,6 +133,7 @@ namespace nodetool
     virtual void relay_notify_to_all(int command, const std::string& data_buff, const epee::net_utils::connection_context_base& context) override;
     virtual bool invoke_command_to_peer(int command, const std::string& req_buff, std::string& resp_buff, const epee::net_utils::connection_context_base& context) override;
     virtual bool invoke_notify_to_peer(int command, const std::string& req_buff, const epee::net_utils::connection_context_base& context) override;
+    virtual bool invoke_notify_to_peer(int command, const epee::net_utils::shared_buffer& req_buff, const epee::net_utils::connection_context_base& context) override;
     virtual bool drop_connection(const epee::net_utils::connection_context_base& context) override;
     virtual void request_callback(const epee::net_utils::connection_context_base& context) override;
     virtual void for_each_connection(std::function<bool(typename t_payload_net_handler::connection_context&, peerid_type)> f) override;
@@ -838,9 +838,11 @@ namespace nodetool
       return true;
     });
 
+    // all connections queue the same buffer
+    epee::net_utils::shared_buffer buffer = std::make_shared<const std::string>(data_buff);
     BOOST_FOREACH(const auto& c_id, connections)
     {
-      m_net_server.get_config_object().notify(command, data_buff, c_id);
+      m_net_server.get_config_object().notify(command, buffer, c_id);
     }
   }
   //-----------------------------------------------------------------------------------
@@ -858,6 +860,13 @@ namespace nodetool
   }
   //-----------------------------------------------------------------------------------
   template<class t_payload_net_handler>
+  bool node_server<t_payload_net_handler>::invoke_notify_to_peer(int command, const epee::net_utils::shared_buffer& req_buff, const epee::net_utils::connection_context_base& context)
+  {
+    int res = m_net_server.get_config_object().notify(command, req_buff, context.m_connection_id);
+    return res > 0;
+  }
+  //-----------------------------------------------------------------------------------
+  template<class t_payload_net_handler>
   bool node_server<t_payload_net_handler>::invoke_command_to_peer(int command, const std::string& req_buff, std::string& resp_buff, const epee::net_utils::connection_context_base& context)
   {
     int res = m_net_server.get_config_object().invoke(command, req_buff, resp_buff, context.m_connection_id);
@@ -33,6 +33,7 @@ namespace nodetool
     virtual void relay_notify_to_all(int command, const std::string& data_buff, const epee::net_utils::connection_context_base& context)=0;
     virtual bool invoke_command_to_peer(int command, const std::string& req_buff, std::string& resp_buff, const epee::net_utils::connection_context_base& context)=0;
     virtual bool invoke_notify_to_peer(int command, const std::string& req_buff, const epee::net_utils::connection_context_base& context)=0;
+    virtual bool invoke_notify_to_peer(int command, const epee::net_utils::shared_buffer& req_buff, const epee::net_utils::connection_context_base& context)=0;
     virtual bool drop_connection(const epee::net_utils::connection_context_base& context)=0;
     virtual void request_callback(const epee::net_utils::connection_context_base& context)=0;
     virtual uint64_t get_connections_count()=0;
@@ -53,6 +54,10 @@ namespace nodetool
     {
       return true;
     }
+    virtual bool invoke_notify_to_peer(int command, const epee::net_utils::shared_buffer& req_buff, const epee::net_utils::connection_context_base& context)
+    {
+      return true;
+    }
     virtual bool drop_connection(const epee::net_utils::connection_context_base& context)
     {
       return false;
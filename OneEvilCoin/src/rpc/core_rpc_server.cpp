@@ -44,7 +44,10 @@ namespace cryptonote
     command_line::add_arg(desc, arg_rpc_bind_port);
   }
   //------------------------------------------------------------------------------------------------------------------------------
-  core_rpc_server::core_rpc_server(core& cr, nodetool::node_server<cryptonote::t_cryptonote_protocol_handler<cryptonote::core> >& p2p):m_core(cr), m_p2p(p2p)
+  const size_t core_rpc_server::LONG_POLL_MAX_CONNECTIONS;
+  const size_t core_rpc_server::LONG_POLL_TIMEOUT_SECONDS;
+  //------------------------------------------------------------------------------------------------------------------------------
+  core_rpc_server::core_rpc_server(core& cr, nodetool::node_server<cryptonote::t_cryptonote_protocol_handler<cryptonote::core> >& p2p):m_core(cr), m_p2p(p2p), m_long_polls(0)
   {}
   //------------------------------------------------------------------------------------------------------------------------------
   bool core_rpc_server::handle_command_line(const boost::program_options::variables_map& vm)
@@ -92,12 +95,16 @@ namespace cryptonote
     res.difficulty = m_core.get_blockchain_storage().get_difficulty_for_next_block();
     res.tx_count = m_core.get_blockchain_storage().get_total_transactions() - res.height; //without coinbase
     res.tx_pool_size = m_core.get_pool_transactions_count();
+    res.tx_pool_bytes = m_core.get_pool_memory_usage();
+    res.tx_pool_evicted = m_core.get_pool_evicted_transactions_count();
     res.alt_blocks_count = m_core.get_blockchain_storage().get_alternative_blocks_count();
     uint64_t total_conn = m_p2p.get_connections_count();
     res.outgoing_connections_count = m_p2p.get_outgoing_connections_count();
     res.incoming_connections_count = total_conn - res.outgoing_connections_count;
     res.white_peerlist_size = m_p2p.get_peerlist_manager().get_white_peers_count();
     res.grey_peerlist_size = m_p2p.get_peerlist_manager().get_gray_peers_count();
+    res.slow_hash_variant = crypto::cn_slow_hash_variant();
+    res.slow_hash_pages = crypto::scratchpad_pages_name(m_core.get_blockchain_storage().getScratchpadPages());
     res.status = CORE_RPC_STATUS_OK;
     return true;
   }
@@ -105,21 +112,12 @@ namespace cryptonote
   bool core_rpc_server::on_get_blocks(const COMMAND_RPC_GET_BLOCKS_FAST::request& req, COMMAND_RPC_GET_BLOCKS_FAST::response& res, connection_context& cntx)
   {
     CHECK_CORE_READY();
-    std::list<std::pair<Block, std::list<Transaction> > > bs;
-    if(!m_core.find_blockchain_supplement(req.block_ids, bs, res.current_height, res.start_height, COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT))
+    if(!m_core.find_blockchain_supplement(req.block_ids, res.blocks, res.current_height, res.start_height, COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT))
     {
       res.status = "Failed";
       return false;
     }
 
-    for (auto& b : bs) {
-      res.blocks.resize(res.blocks.size()+1);
-      res.blocks.back().block = block_to_blob(b.first);
-      for (auto& t : b.second) {
-        res.blocks.back().txs.push_back(tx_to_blob(t));
-      }
-    }
-
     res.status = CORE_RPC_STATUS_OK;
     return true;
   }
@@ -338,21 +336,6 @@ namespace cryptonote
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------------
-  uint64_t slow_memmem(void* start_buff, size_t buflen,void* pat,size_t patlen)
-  {
-    void* buf = start_buff;
-    void* end=(char*)buf+buflen-patlen;
-    while((buf=memchr(buf,((char*)pat)[0],buflen)))
-    {
-      if(buf>end)
-        return 0;
-      if(memcmp(buf,pat,patlen)==0)
-        return (char*)buf - (char*)start_buff;
-      buf=(char*)buf+1;
-    }
-    return 0;
-  }
-  //------------------------------------------------------------------------------------------------------------------------------
   bool core_rpc_server::on_getblocktemplate(const COMMAND_RPC_GETBLOCKTEMPLATE::request& req, COMMAND_RPC_GETBLOCKTEMPLATE::response& res, epee::json_rpc::error& error_resp, connection_context& cntx)
   {
     if(!check_core_ready())
@@ -362,10 +345,10 @@ namespace cryptonote
       return false;
     }
 
-    if(req.reserve_size > TX_EXTRA_NONCE_MAX_COUNT)
+    if(req.reserve_size > TX_EXTRA_NONCE_MAX_COUNT - CryptoNote::BlockTemplateCache::INSTANCE_TAG_SIZE)
     {
       error_resp.code = CORE_RPC_ERROR_CODE_TOO_BIG_RESERVE_SIZE;
-      error_resp.message = "To big reserved size, maximum 255";
+      error_resp.message = "To big reserved size, maximum 251";
       return false;
     }
 
@@ -378,52 +361,30 @@ namespace cryptonote
       return false;
     }
 
-    Block b = AUTO_VAL_INIT(b);
-    cryptonote::blobdata blob_reserve;
-    blob_reserve.resize(req.reserve_size, 0);
-    if(!m_core.get_block_template(b, acc, res.difficulty, res.height, blob_reserve))
+    res.template_version = m_core.get_block_template_version();
+    if(req.wait_template_version != 0 && req.wait_template_version == res.template_version)
     {
-      error_resp.code = CORE_RPC_ERROR_CODE_INTERNAL_ERROR;
-      error_resp.message = "Internal error: failed to create block template";
-      LOG_ERROR("Failed to create block template");
-      return false;
+      if(m_long_polls.fetch_add(1) < LONG_POLL_MAX_CONNECTIONS)
+      {
+        res.template_version = m_core.wait_block_template_change(req.wait_template_version, std::chrono::seconds(LONG_POLL_TIMEOUT_SECONDS));
+      }
+      --m_long_polls;
     }
 
-    blobdata block_blob = t_serializable_object_to_blob(b);
-    crypto::public_key tx_pub_key = cryptonote::get_tx_pub_key_from_extra(b.minerTx);
-    if(tx_pub_key == null_pkey)
+    CryptoNote::BlockTemplateInstance instance;
+    if(!m_core.get_block_template_instance(acc, req.reserve_size, instance))
     {
       error_resp.code = CORE_RPC_ERROR_CODE_INTERNAL_ERROR;
       error_resp.message = "Internal error: failed to create block template";
-      LOG_ERROR("Failed to find tx pub key in coinbase extra");
+      LOG_ERROR("Failed to create block template");
       return false;
     }
 
-    if(0 < req.reserve_size)
-    {
-      res.reserved_offset = slow_memmem((void*)block_blob.data(), block_blob.size(), &tx_pub_key, sizeof(tx_pub_key));
-      if(!res.reserved_offset)
-      {
-        error_resp.code = CORE_RPC_ERROR_CODE_INTERNAL_ERROR;
-        error_resp.message = "Internal error: failed to create block template";
-        LOG_ERROR("Failed to find tx pub key in blockblob");
-        return false;
-      }
-      res.reserved_offset += sizeof(tx_pub_key) + 3; //3 bytes: tag for TX_EXTRA_TAG_PUBKEY(1 byte), tag for TX_EXTRA_NONCE(1 byte), counter in TX_EXTRA_NONCE(1 byte)
-      if(res.reserved_offset + req.reserve_size > block_blob.size())
-      {
-        error_resp.code = CORE_RPC_ERROR_CODE_INTERNAL_ERROR;
-        error_resp.message = "Internal error: failed to create block template";
-        LOG_ERROR("Failed to calculate offset for reserved bytes");
-        return false;
-      }
-    }
-    else
-    {
-      res.reserved_offset = 0;
-    }
-
-    res.blocktemplate_blob = string_tools::buff_to_hex_nodelimer(block_blob);
+    res.difficulty = instance.difficulty;
+    res.height = instance.height;
+    res.reserved_offset = instance.reservedOffset;
+    res.template_version = instance.version;
+    res.blocktemplate_blob = string_tools::buff_to_hex_nodelimer(instance.blob);
     res.status = CORE_RPC_STATUS_OK;
 
     return true;
@@ -453,8 +414,22 @@ namespace cryptonote
       return false;
     }
 
+    Block b = AUTO_VAL_INIT(b);
+    if (blockblob.size() > m_core.currency().maxBlockBlobSize() || !parse_and_validate_block_from_blob(blockblob, b)) {
+      error_resp.code = CORE_RPC_ERROR_CODE_WRONG_BLOCKBLOB;
+      error_resp.message = "Wrong block blob";
+      return false;
+    }
+
+    // several workers may submit the same block, only the first one needs the exclusive chain lock
+    if (m_core.have_block(get_block_hash(b))) {
+      error_resp.code = CORE_RPC_ERROR_CODE_BLOCK_NOT_ACCEPTED;
+      error_resp.message = "Block not accepted, already known";
+      return false;
+    }
+
     cryptonote::block_verification_context bvc = AUTO_VAL_INIT(bvc);
-    m_core.handle_incoming_block_blob(blockblob, bvc, true, true);
+    m_core.handle_incoming_block(b, bvc, true, true);
     if (!bvc.m_added_to_main_chain) {
       error_resp.code = CORE_RPC_ERROR_CODE_BLOCK_NOT_ACCEPTED;
       error_resp.message = "Block not accepted";
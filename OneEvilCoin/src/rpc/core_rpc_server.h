@@ -20,6 +20,8 @@
 #include <boost/program_options/options_description.hpp>
 #include <boost/program_options/variables_map.hpp>
 
+#include <atomic>
+
 #include "net/http_server_impl_base.h"
 #include "core_rpc_server_commands_defs.h"
 #include "cryptonote_core/cryptonote_core.h"
@@ -36,6 +38,10 @@ namespace cryptonote
   public:
     typedef epee::net_utils::connection_context_base connection_context;
 
+    // getblocktemplate long-polls are served by dedicated threads, so they never starve other requests
+    static const size_t LONG_POLL_MAX_CONNECTIONS = 4;
+    static const size_t LONG_POLL_TIMEOUT_SECONDS = 30;
+
     core_rpc_server(core& cr, nodetool::node_server<cryptonote::t_cryptonote_protocol_handler<cryptonote::core> >& p2p);
 
     static void init_options(boost::program_options::options_description& desc);
@@ -100,5 +106,6 @@ namespace cryptonote
     nodetool::node_server<cryptonote::t_cryptonote_protocol_handler<cryptonote::core> >& m_p2p;
     std::string m_port;
     std::string m_bind_ip;
+    std::atomic<size_t> m_long_polls;
   };
 }
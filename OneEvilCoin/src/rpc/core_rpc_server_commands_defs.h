@@ -236,11 +236,15 @@ namespace cryptonote
       uint64_t difficulty;
       uint64_t tx_count;
       uint64_t tx_pool_size;
+      uint64_t tx_pool_bytes;
+      uint64_t tx_pool_evicted;
       uint64_t alt_blocks_count;
       uint64_t outgoing_connections_count;
       uint64_t incoming_connections_count;
       uint64_t white_peerlist_size;
       uint64_t grey_peerlist_size;
+      std::string slow_hash_variant;
+      std::string slow_hash_pages;
 
       BEGIN_KV_SERIALIZE_MAP()
         KV_SERIALIZE(status)
@@ -248,11 +252,15 @@ namespace cryptonote
         KV_SERIALIZE(difficulty)
         KV_SERIALIZE(tx_count)
         KV_SERIALIZE(tx_pool_size)
+        KV_SERIALIZE(tx_pool_bytes)
+        KV_SERIALIZE(tx_pool_evicted)
         KV_SERIALIZE(alt_blocks_count)
         KV_SERIALIZE(outgoing_connections_count)
         KV_SERIALIZE(incoming_connections_count)
         KV_SERIALIZE(white_peerlist_size)
         KV_SERIALIZE(grey_peerlist_size)
+        KV_SERIALIZE(slow_hash_variant)
+        KV_SERIALIZE(slow_hash_pages)
       END_KV_SERIALIZE_MAP()
     };
   };
@@ -330,10 +338,12 @@ namespace cryptonote
     {
       uint64_t reserve_size;       //max 255 bytes
       std::string wallet_address;
+      uint64_t wait_template_version; //if equal to the current template_version, wait for a new template
 
       BEGIN_KV_SERIALIZE_MAP()
         KV_SERIALIZE(reserve_size)
         KV_SERIALIZE(wallet_address)
+        KV_SERIALIZE(wait_template_version)
       END_KV_SERIALIZE_MAP()
     };
 
@@ -343,6 +353,7 @@ namespace cryptonote
       uint64_t height;
       uint64_t reserved_offset;
       blobdata blocktemplate_blob;
+      uint64_t template_version;
       std::string status;
 
       BEGIN_KV_SERIALIZE_MAP()
@@ -350,6 +361,7 @@ namespace cryptonote
         KV_SERIALIZE(height)
         KV_SERIALIZE(reserved_offset)
         KV_SERIALIZE(blocktemplate_blob)
+        KV_SERIALIZE(template_version)
         KV_SERIALIZE(status)
       END_KV_SERIALIZE_MAP()
     };
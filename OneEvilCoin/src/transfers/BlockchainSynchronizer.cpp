@@ -18,6 +18,7 @@
 #include "BlockchainSynchronizer.h"
 #include "cryptonote_core/TransactionApi.h"
 #include "cryptonote_core/cryptonote_format_utils.h"
+#include <algorithm>
 #include <functional>
 #include <unordered_set>
 #include <sstream>
@@ -37,7 +38,8 @@ inline std::vector<uint8_t> stringToVector(const std::string& s) {
 namespace CryptoNote {
 
 BlockchainSynchronizer::BlockchainSynchronizer(INode& node, const crypto::hash& genesisBlockHash) :
-m_node(node), m_genesisBlockHash(genesisBlockHash), m_currentState(State::stopped), m_futureState(State::stopped), shouldSyncConsumersPool(true) {
+m_node(node), m_genesisBlockHash(genesisBlockHash), m_currentState(State::stopped), m_futureState(State::stopped), shouldSyncConsumersPool(true),
+isPoolVersionKnown(false), knownPoolVersion(0) {
 }
 
 BlockchainSynchronizer::~BlockchainSynchronizer() {
@@ -452,6 +454,50 @@ BlockchainSynchronizer::UpdateConsumersResult BlockchainSynchronizer::updateCons
 }
 
 void BlockchainSynchronizer::startPoolSync() {
+  GetPoolResponse changesResponse;
+  bool isPoolVersionActual = false;
+  uint64_t poolVersion = 0;
+
+  asyncOperationCompleted = std::promise<std::error_code>();
+  asyncOperationWaitFuture = asyncOperationCompleted.get_future();
+
+  changesResponse.isLastKnownBlockActual = false;
+
+  m_node.getPoolChanges(lastBlockId, knownPoolVersion, changesResponse.isLastKnownBlockActual, isPoolVersionActual, poolVersion,
+    changesResponse.newTxs, changesResponse.deletedTxIds, std::bind(&BlockchainSynchronizer::onGetPoolChanges, this, std::placeholders::_1));
+
+  std::error_code changesEc = asyncOperationWaitFuture.get();
+
+  if (changesEc) {
+    m_observerManager.notify(
+      &IBlockchainSynchronizerObserver::synchronizationCompleted,
+      changesEc);
+    setFutureStateIf(State::idle, std::bind(
+      [](State futureState) -> bool {
+      return futureState != State::stopped;
+    }, std::ref(m_futureState)));
+    return;
+  }
+
+  if (!changesResponse.isLastKnownBlockActual) { //bc outdated
+    setFutureState(State::blockchainSync);
+    return;
+  }
+
+  if (isPoolVersionKnown && isPoolVersionActual && !shouldSyncConsumersPool) { //node told only the changes since the known version
+    filterPoolChanges(changesResponse);
+    std::error_code processingEc = processPoolTxs(changesResponse);
+    isPoolVersionKnown = !processingEc;
+    knownPoolVersion = poolVersion;
+    m_observerManager.notify(
+      &IBlockchainSynchronizerObserver::synchronizationCompleted,
+      processingEc);
+    return;
+  }
+
+  // the node can't tell the changes, take the full difference and remember the version it was taken at
+  isPoolVersionKnown = false;
+
   GetPoolResponse unionResponse;
   GetPoolRequest unionRequest = getUnionPoolHistory();
 
@@ -478,9 +524,15 @@ void BlockchainSynchronizer::startPoolSync() {
       setFutureState(State::blockchainSync);
     } else {
       if (!shouldSyncConsumersPool) { //usual case, start pool processing
+        std::error_code processingEc = processPoolTxs(unionResponse);
+        if (!processingEc) {
+          isPoolVersionKnown = true;
+          knownPoolVersion = poolVersion;
+        }
+
         m_observerManager.notify(
           &IBlockchainSynchronizerObserver::synchronizationCompleted,
-          processPoolTxs(unionResponse));
+          processingEc);
       } else {// first launch, we should sync consumers' pools, so let's ask for intersection
         GetPoolResponse intersectionResponse;
         GetPoolRequest intersectionRequest = getIntersectedPoolHistory();
@@ -517,6 +569,8 @@ void BlockchainSynchronizer::startPoolSync() {
 
             if (!ec3) {
               shouldSyncConsumersPool = false;
+              isPoolVersionKnown = true;
+              knownPoolVersion = poolVersion;
             }
           }
         }
@@ -530,6 +584,21 @@ void BlockchainSynchronizer::onGetPoolChanges(std::error_code ec) {
   detachedPromise.set_value(ec);
 }
 
+// Changes since a pool version are not checked against what the consumers know, so drop transactions they already
+// have, e.g. the ones a wallet sent itself, and deletions of transactions they never had
+void BlockchainSynchronizer::filterPoolChanges(GetPoolResponse& response) {
+  std::vector<crypto::hash> knownTxIds = getUnionPoolHistory().knownTxIds;
+  std::unordered_set<crypto::hash> knownSet(knownTxIds.begin(), knownTxIds.end());
+
+  response.newTxs.erase(std::remove_if(response.newTxs.begin(), response.newTxs.end(), [&knownSet](const cryptonote::Transaction& tx) {
+    return knownSet.count(cryptonote::get_transaction_hash(tx)) != 0;
+  }), response.newTxs.end());
+
+  response.deletedTxIds.erase(std::remove_if(response.deletedTxIds.begin(), response.deletedTxIds.end(), [&knownSet](const crypto::hash& id) {
+    return knownSet.count(id) == 0;
+  }), response.deletedTxIds.end());
+}
+
 std::error_code BlockchainSynchronizer::processPoolTxs(GetPoolResponse& response) {
   std::error_code error;
   {
@@ -104,6 +104,7 @@ private:
   UpdateConsumersResult updateConsumers(const BlockchainInterval& interval, const std::vector<CompleteBlock>& blocks);
   void onGetPoolChanges(std::error_code ec);
   std::error_code processPoolTxs(GetPoolResponse& response);
+  void filterPoolChanges(GetPoolResponse& response);
   
   ///second parameter is used only in case of errors returned into callback from INode, such as aborted or connection lost
   bool setFutureState(State s); 
@@ -139,6 +140,9 @@ private:
   std::mutex m_stateMutex;
 
   bool shouldSyncConsumersPool;
+  // pool version the consumers are synchronized with, lets pool sync ask the node only for later changes
+  bool isPoolVersionKnown;
+  uint64_t knownPoolVersion;
 };
 
 }
@@ -21,6 +21,7 @@
 
 #include <boost/program_options/variables_map.hpp>
 
+#include "cryptonote_core/BlockHeaderChain.h"
 #include "cryptonote_core/cryptonote_basic_impl.h"
 #include "cryptonote_core/Currency.h"
 #include "cryptonote_core/verification_context.h"
@@ -68,9 +69,16 @@ namespace tests
     bool get_short_chain_history(std::list<crypto::hash>& ids);
     bool get_stat_info(cryptonote::core_stat_info& st_inf){return true;}
     bool have_block(const crypto::hash& id);
+    bool pool_has_tx(const crypto::hash& id){return false;}
+    bool have_tx(const crypto::hash& id){return false;}
+    bool get_block_by_hash(const crypto::hash& h, cryptonote::Block& blk){return false;}
+    void get_transactions(const std::vector<crypto::hash>& txs_ids, std::list<cryptonote::Transaction>& txs, std::list<crypto::hash>& missed_txs, bool checkTxPool = false){missed_txs.assign(txs_ids.begin(), txs_ids.end());}
     bool get_blockchain_top(uint64_t& height, crypto::hash& top_id);
     bool handle_incoming_tx(const cryptonote::blobdata& tx_blob, cryptonote::tx_verification_context& tvc, bool keeped_by_block);
     bool handle_incoming_block_blob(const cryptonote::blobdata& block_blob, cryptonote::block_verification_context& bvc, bool control_miner, bool relay_block);
+    void precompute_blocks_longhash(const std::vector<cryptonote::Block>& blocks){}
+    bool start_header_chain(uint64_t height, const crypto::hash& prev_id, CryptoNote::BlockHeaderChain& chain){return false;}
+    bool check_block_headers(CryptoNote::BlockHeaderChain& chain, const std::vector<cryptonote::Block>& headers){return false;}
     void pause_mining(){}
     void update_block_template_and_resume_mining(){}
     bool on_idle(){return true;}
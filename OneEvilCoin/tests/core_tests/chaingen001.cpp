@@ -17,6 +17,8 @@
 
 #include "chaingen001.h"
 
+#include "cryptonote_protocol/cryptonote_protocol_defs.h"
+
 using namespace std;
 
 using namespace epee;
@@ -128,6 +130,40 @@ bool gen_simple_chain_001::generate(std::vector<test_event_entry> &events)
 
 bool gen_simple_chain_001::verify_callback_1(cryptonote::core& c, size_t ev_index, const std::vector<test_event_entry> &events)
 {
+  DEFINE_TESTS_ERROR_CONTEXT("gen_simple_chain_001::verify_callback_1");
+
+  // raw blobs served from storage must match the serialized blocks and transactions
+  std::list<cryptonote::Block> blocks;
+  CHECK_TEST_CONDITION(c.get_blocks(0, c.get_current_blockchain_height(), blocks));
+
+  uint64_t height = 0;
+  for (const auto& b : blocks)
+  {
+    block_complete_entry rawBlock;
+    CHECK_TEST_CONDITION(c.get_blockchain_storage().getRawBlock(height, rawBlock));
+    CHECK_TEST_CONDITION(rawBlock.block == block_to_blob(b));
+
+    std::list<cryptonote::Transaction> txs;
+    std::list<crypto::hash> missedTxs;
+    c.get_blockchain_storage().get_transactions(b.txHashes, txs, missedTxs);
+    CHECK_TEST_CONDITION(missedTxs.empty());
+    CHECK_EQ(txs.size(), rawBlock.txs.size());
+
+    std::list<blobdata> rawTxs;
+    c.get_blockchain_storage().getRawTransactions(std::list<crypto::hash>(b.txHashes.begin(), b.txHashes.end()), rawTxs, missedTxs);
+    CHECK_TEST_CONDITION(missedTxs.empty());
+    CHECK_TEST_CONDITION(rawTxs == rawBlock.txs);
+
+    auto rawTx = rawBlock.txs.begin();
+    for (const auto& tx : txs)
+    {
+      CHECK_TEST_CONDITION(*rawTx == tx_to_blob(tx));
+      ++rawTx;
+    }
+
+    ++height;
+  }
+
   return true;
 }
 
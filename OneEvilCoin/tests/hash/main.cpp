@@ -16,10 +16,12 @@
 // along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <cstddef>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <ios>
 #include <string>
+#include <vector>
 
 #include "warnings.h"
 #include "crypto/hash.h"
@@ -30,6 +32,16 @@ using namespace crypto;
 typedef crypto::hash chash;
 
 cn_context *context;
+cn_multi_context *multi_context;
+
+struct test_vector {
+  vector<char> data;
+  chash expected;
+};
+
+// previous test vectors, rehashed in the other lanes of the multi way slow hash
+vector<test_vector> history;
+bool lane_error = false;
 
 extern "C" {
 
@@ -46,6 +58,33 @@ POP_WARNINGS
   static void slow_hash(const void *data, size_t length, char *hash) {
     cn_slow_hash(*context, data, length, *reinterpret_cast<chash *>(hash));
   }
+
+  static void slow_hash_multi(const void *data, size_t length, char *hash) {
+    const void *lane_data[SLOW_HASH_MAX_WAYS];
+    size_t lane_length[SLOW_HASH_MAX_WAYS];
+    chash lane_hash[SLOW_HASH_MAX_WAYS];
+    size_t ways = multi_context->ways();
+    size_t last = ways - 1;
+    for (size_t i = 0; i < last; i++) {
+      if (i < history.size()) {
+        lane_data[i] = history[i].data.data();
+        lane_length[i] = history[i].data.size();
+      } else {
+        lane_data[i] = data;
+        lane_length[i] = length;
+      }
+    }
+    lane_data[last] = data;
+    lane_length[last] = length;
+    cn_slow_hash_multi(*multi_context, lane_data, lane_length, lane_hash);
+    for (size_t i = 0; i < last; i++) {
+      if (lane_hash[i] != (i < history.size() ? history[i].expected : lane_hash[last])) {
+        cerr << "Hash mismatch in lane " << i << " of " << ways << endl;
+        lane_error = true;
+      }
+    }
+    memcpy(hash, &lane_hash[last], sizeof(chash));
+  }
 }
 
 extern "C" typedef void hash_f(const void *, size_t, char *);
@@ -53,6 +92,7 @@ struct hash_func {
   const string name;
   hash_f &f;
 } hashes[] = {{"fast", cn_fast_hash}, {"slow", slow_hash}, {"tree", hash_tree},
+  {"slow-2way", slow_hash_multi}, {"slow-4way", slow_hash_multi},
   {"extra-blake", hash_extra_blake}, {"extra-groestl", hash_extra_groestl},
   {"extra-jh", hash_extra_jh}, {"extra-skein", hash_extra_skein}};
 
@@ -81,6 +121,9 @@ int main(int argc, char *argv[]) {
   if (f == slow_hash) {
     context = new cn_context();
   }
+  if (f == slow_hash_multi) {
+    multi_context = new cn_multi_context(hf->name == "slow-2way" ? 2 : 4);
+  }
   input.open(argv[2], ios_base::in);
   for (;;) {
     ++test;
@@ -93,6 +136,12 @@ int main(int argc, char *argv[]) {
     input.clear(input.rdstate());
     get(input, data);
     f(data.data(), data.size(), (char *) &actual);
+    if (f == slow_hash_multi) {
+      history.insert(history.begin(), test_vector{data, expected});
+      if (history.size() >= SLOW_HASH_MAX_WAYS) {
+        history.pop_back();
+      }
+    }
     if (expected != actual) {
       size_t i;
       cerr << "Hash mismatch on test " << test << endl << "Input: ";
@@ -115,5 +164,5 @@ int main(int argc, char *argv[]) {
       error = true;
     }
   }
-  return error ? 1 : 0;
+  return error || lane_error ? 1 : 0;
 }
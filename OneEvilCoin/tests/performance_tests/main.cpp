@@ -29,6 +29,7 @@
 #include "generate_key_image.h"
 #include "generate_key_image_helper.h"
 #include "is_out_to_acc.h"
+#include "swapped_vector.h"
 
 int main(int argc, char** argv)
 {
@@ -73,6 +74,9 @@ int main(int argc, char** argv)
 
   TEST_PERFORMANCE0(test_cn_slow_hash);
 
+  TEST_PERFORMANCE1(test_swapped_vector_random_read, false);
+  TEST_PERFORMANCE1(test_swapped_vector_random_read, true);
+
   std::cout << "Tests finished. Elapsed time: " << timer.elapsed_ms() / 1000 << " sec" << std::endl;
 
   return 0;
@@ -0,0 +1,84 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <random>
+
+#include <boost/filesystem.hpp>
+
+#include "cryptonote_core/SwappedVector.h"
+#include "serialization/string.h"
+
+// Random-index reads from a SwappedVector whose cache is much smaller than the stored chain,
+// so almost every read is a miss served either from the mapped file or through std::fstream.
+template<bool useMapping>
+class test_swapped_vector_random_read
+{
+public:
+  static const size_t loop_count = 100;
+  static const size_t item_count = 20000;
+  static const size_t reads_per_call = 1000;
+  static const size_t pool_size = 16;
+
+  ~test_swapped_vector_random_read()
+  {
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(m_directory, ec);
+  }
+
+  bool init()
+  {
+    m_directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    if (!boost::filesystem::create_directory(m_directory))
+      return false;
+
+    std::string itemsFileName = (m_directory / "items.bin").string();
+    std::string indexesFileName = (m_directory / "indexes.bin").string();
+    if (!m_vector.open(itemsFileName, indexesFileName, pool_size, useMapping))
+      return false;
+
+    // Item sizes roughly follow those of blocks with a handful of transactions
+    std::uniform_int_distribution<size_t> sizeDistribution(200, 8000);
+    for (size_t i = 0; i < item_count; ++i)
+    {
+      std::string item(sizeDistribution(m_generator), static_cast<char>(i));
+      m_vector.push_back(item);
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    std::uniform_int_distribution<uint64_t> indexDistribution(0, item_count - 1);
+    for (size_t i = 0; i < reads_per_call; ++i)
+    {
+      uint64_t index = indexDistribution(m_generator);
+      if ((*m_vector[index])[0] != static_cast<char>(index))
+        return false;
+    }
+
+    return true;
+  }
+
+private:
+  boost::filesystem::path m_directory;
+  SwappedVector<std::string> m_vector;
+  std::mt19937_64 m_generator;
+};
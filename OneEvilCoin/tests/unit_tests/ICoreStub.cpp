@@ -81,6 +81,11 @@ bool ICoreStub::getPoolSymmetricDifference(const std::vector<crypto::hash>& know
   return true;
 }
 
+bool ICoreStub::getPoolChanges(const crypto::hash& knownBlockId, uint64_t knownPoolVersion, bool& isBcActual, bool& isPoolVersionActual, uint64_t& poolVersion,
+    std::vector<cryptonote::Transaction>& newTxs, std::vector<crypto::hash>& deletedTxIds) {
+  return true;
+}
+
 bool ICoreStub::queryBlocks(const std::list<crypto::hash>& block_ids, uint64_t timestamp,
     uint64_t& start_height, uint64_t& current_height, uint64_t& full_offset, std::list<cryptonote::BlockFullInfo>& entries) {
   //stub
@@ -41,6 +41,8 @@ public:
   virtual cryptonote::i_cryptonote_protocol* get_protocol();
   virtual bool handle_incoming_tx(cryptonote::blobdata const& tx_blob, cryptonote::tx_verification_context& tvc, bool keeped_by_block);
   virtual bool getPoolSymmetricDifference(const std::vector<crypto::hash>& known_pool_tx_ids, const crypto::hash& known_block_id, bool& isBcActual, std::vector<cryptonote::Transaction>& new_txs, std::vector<crypto::hash>& deleted_tx_ids) override;
+  virtual bool getPoolChanges(const crypto::hash& knownBlockId, uint64_t knownPoolVersion, bool& isBcActual, bool& isPoolVersionActual, uint64_t& poolVersion,
+      std::vector<cryptonote::Transaction>& newTxs, std::vector<crypto::hash>& deletedTxIds) override;
   virtual bool queryBlocks(const std::list<crypto::hash>& block_ids, uint64_t timestamp,
       uint64_t& start_height, uint64_t& current_height, uint64_t& full_offset, std::list<cryptonote::BlockFullInfo>& entries);
 
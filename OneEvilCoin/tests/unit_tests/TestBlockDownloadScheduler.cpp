@@ -0,0 +1,241 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "cryptonote_core/BlockDownloadScheduler.h"
+
+using namespace CryptoNote;
+
+namespace {
+  typedef BlockDownloadScheduler::Reservation Reservation;
+
+  std::vector<crypto::hash> makeIds(size_t count, uint8_t seed) {
+    std::vector<crypto::hash> ids(count);
+    for (size_t i = 0; i < count; ++i) {
+      ids[i] = cryptonote::null_hash;
+      reinterpret_cast<uint8_t*>(&ids[i])[0] = seed;
+      reinterpret_cast<uint8_t*>(&ids[i])[1] = static_cast<uint8_t>(i);
+    }
+
+    return ids;
+  }
+
+  BlockDownloadScheduler::PeerId makePeer(uint8_t n) {
+    BlockDownloadScheduler::PeerId peer = BlockDownloadScheduler::PeerId();
+    peer.data[0] = n;
+    return peer;
+  }
+
+  std::list<cryptonote::block_complete_entry> makeBlocks(const std::string& tag) {
+    std::list<cryptonote::block_complete_entry> blocks(1);
+    blocks.front().block = tag;
+    return blocks;
+  }
+
+  class BlockDownloadSchedulerTest : public ::testing::Test {
+  public:
+    BlockDownloadSchedulerTest() : scheduler(2, 2, std::chrono::seconds(60)), ids(makeIds(6, 1)) {
+    }
+
+  protected:
+    BlockDownloadScheduler scheduler;
+    std::vector<crypto::hash> ids;
+  };
+
+  TEST_F(BlockDownloadSchedulerTest, givesDifferentSpansToPeersWithinWindow) {
+    ASSERT_TRUE(scheduler.addChain(makePeer(9), 10, ids));
+
+    std::vector<crypto::hash> span;
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(1), 100, span));
+    ASSERT_EQ(std::vector<crypto::hash>(ids.begin(), ids.begin() + 2), span);
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(2), 100, span));
+    ASSERT_EQ(std::vector<crypto::hash>(ids.begin() + 2, ids.begin() + 4), span);
+
+    ASSERT_EQ(Reservation::waiting, scheduler.reserveSpan(makePeer(3), 100, span));
+    ASSERT_TRUE(scheduler.takeWaitingPeers().empty());
+  }
+
+  TEST_F(BlockDownloadSchedulerTest, doesNotGiveSpansAbovePeerHeight) {
+    ASSERT_TRUE(scheduler.addChain(makePeer(9), 10, ids));
+
+    std::vector<crypto::hash> span;
+    ASSERT_EQ(Reservation::unreachable, scheduler.reserveSpan(makePeer(1), 10, span));
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(1), 11, span));
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(2), 13, span));
+    ASSERT_EQ(Reservation::waiting, scheduler.reserveSpan(makePeer(2), 13, span));
+  }
+
+  TEST_F(BlockDownloadSchedulerTest, wakesOnlyWaitingPeersReachingSpans) {
+    ASSERT_TRUE(scheduler.addChain(makePeer(9), 10, ids));
+
+    std::vector<crypto::hash> span;
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(1), 100, span));
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(2), 100, span));
+    ASSERT_EQ(Reservation::waiting, scheduler.reserveSpan(makePeer(3), 100, span));
+    ASSERT_EQ(Reservation::waiting, scheduler.reserveSpan(makePeer(4), 13, span));
+
+    bool feeding = false;
+    std::list<cryptonote::block_complete_entry> blocks;
+    BlockDownloadScheduler::PeerId deliverer;
+    ASSERT_EQ(BlockDownloadScheduler::Delivery::accepted, scheduler.deliverSpan(makePeer(1), makeBlocks("first")));
+    ASSERT_TRUE(scheduler.takeReady(feeding, blocks, deliverer));
+
+    ASSERT_EQ(std::vector<BlockDownloadScheduler::PeerId>{makePeer(3)}, scheduler.takeWaitingPeers());
+  }
+
+  TEST_F(BlockDownloadSchedulerTest, endsDownloadWhenNoPeerReachesSpans) {
+    ASSERT_TRUE(scheduler.addChain(makePeer(9), 10, ids));
+
+    std::vector<crypto::hash> span;
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(1), 100, span));
+    ASSERT_EQ(Reservation::waiting, scheduler.reserveSpan(makePeer(2), 11, span));
+    scheduler.releasePeer(makePeer(1));
+
+    ASSERT_EQ(std::vector<BlockDownloadScheduler::PeerId>{makePeer(2)}, scheduler.takeWaitingPeers());
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(2), 11, span));
+    ASSERT_EQ(std::vector<crypto::hash>(ids.begin(), ids.begin() + 2), span);
+
+    ASSERT_EQ(Reservation::waiting, scheduler.reserveSpan(makePeer(3), 11, span));
+    ASSERT_TRUE(scheduler.takeWaitingPeers().empty());
+    scheduler.releasePeer(makePeer(9));
+
+    ASSERT_EQ(std::vector<BlockDownloadScheduler::PeerId>{makePeer(3)}, scheduler.takeWaitingPeers());
+    ASSERT_FALSE(scheduler.isActive());
+  }
+
+  TEST_F(BlockDownloadSchedulerTest, handsOutBlocksInHeightOrder) {
+    ASSERT_TRUE(scheduler.addChain(makePeer(9), 10, ids));
+
+    std::vector<crypto::hash> span;
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(1), 100, span));
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(2), 100, span));
+
+    bool feeding = false;
+    std::list<cryptonote::block_complete_entry> blocks;
+    BlockDownloadScheduler::PeerId deliverer;
+    ASSERT_EQ(BlockDownloadScheduler::Delivery::accepted, scheduler.deliverSpan(makePeer(2), makeBlocks("second")));
+    ASSERT_FALSE(scheduler.takeReady(feeding, blocks, deliverer));
+
+    ASSERT_EQ(BlockDownloadScheduler::Delivery::accepted, scheduler.deliverSpan(makePeer(1), makeBlocks("first")));
+    ASSERT_TRUE(scheduler.takeReady(feeding, blocks, deliverer));
+    ASSERT_EQ("first", blocks.front().block);
+    ASSERT_EQ(makePeer(1), deliverer);
+
+    bool otherFeeding = false;
+    ASSERT_FALSE(scheduler.takeReady(otherFeeding, blocks, deliverer));
+
+    ASSERT_TRUE(scheduler.takeReady(feeding, blocks, deliverer));
+    ASSERT_EQ("second", blocks.front().block);
+    ASSERT_FALSE(scheduler.takeReady(feeding, blocks, deliverer));
+    ASSERT_FALSE(feeding);
+  }
+
+  TEST_F(BlockDownloadSchedulerTest, wakesWaitingPeersWhenWindowMoves) {
+    ASSERT_TRUE(scheduler.addChain(makePeer(9), 10, ids));
+
+    std::vector<crypto::hash> span;
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(1), 100, span));
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(2), 100, span));
+    ASSERT_EQ(Reservation::waiting, scheduler.reserveSpan(makePeer(3), 100, span));
+
+    bool feeding = false;
+    std::list<cryptonote::block_complete_entry> blocks;
+    BlockDownloadScheduler::PeerId deliverer;
+    ASSERT_EQ(BlockDownloadScheduler::Delivery::accepted, scheduler.deliverSpan(makePeer(1), makeBlocks("first")));
+    ASSERT_TRUE(scheduler.takeReady(feeding, blocks, deliverer));
+
+    ASSERT_EQ(std::vector<BlockDownloadScheduler::PeerId>{makePeer(3)}, scheduler.takeWaitingPeers());
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(3), 100, span));
+    ASSERT_EQ(std::vector<crypto::hash>(ids.begin() + 4, ids.end()), span);
+  }
+
+  TEST_F(BlockDownloadSchedulerTest, returnsSpansOfReleasedPeer) {
+    ASSERT_TRUE(scheduler.addChain(makePeer(9), 10, ids));
+
+    std::vector<crypto::hash> span;
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(1), 100, span));
+    scheduler.releasePeer(makePeer(1));
+
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(2), 100, span));
+    ASSERT_EQ(std::vector<crypto::hash>(ids.begin(), ids.begin() + 2), span);
+    ASSERT_EQ(BlockDownloadScheduler::Delivery::notScheduled, scheduler.deliverSpan(makePeer(1), makeBlocks("first")));
+  }
+
+  TEST(BlockDownloadScheduler, reassignsSpansOfStalledPeers) {
+    BlockDownloadScheduler scheduler(2, 1, std::chrono::seconds(0));
+    ASSERT_TRUE(scheduler.addChain(makePeer(9), 10, makeIds(4, 1)));
+
+    std::vector<crypto::hash> span;
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(1), 100, span));
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(2), 100, span));
+
+    ASSERT_EQ(BlockDownloadScheduler::Delivery::late, scheduler.deliverSpan(makePeer(1), makeBlocks("stalled")));
+    ASSERT_EQ(BlockDownloadScheduler::Delivery::accepted, scheduler.deliverSpan(makePeer(2), makeBlocks("first")));
+  }
+
+  TEST_F(BlockDownloadSchedulerTest, retriesTakenSpanFromOtherPeers) {
+    ASSERT_TRUE(scheduler.addChain(makePeer(9), 10, ids));
+
+    std::vector<crypto::hash> span;
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(1), 100, span));
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(2), 100, span));
+
+    bool feeding = false;
+    std::list<cryptonote::block_complete_entry> blocks;
+    BlockDownloadScheduler::PeerId deliverer;
+    ASSERT_EQ(BlockDownloadScheduler::Delivery::accepted, scheduler.deliverSpan(makePeer(1), makeBlocks("invalid")));
+    ASSERT_TRUE(scheduler.takeReady(feeding, blocks, deliverer));
+    scheduler.retryTaken();
+
+    bool otherFeeding = false;
+    ASSERT_FALSE(scheduler.takeReady(otherFeeding, blocks, deliverer));
+    ASSERT_EQ(Reservation::unreachable, scheduler.reserveSpan(makePeer(1), 100, span));
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(3), 100, span));
+    ASSERT_EQ(std::vector<crypto::hash>(ids.begin(), ids.begin() + 2), span);
+    ASSERT_TRUE(scheduler.hasSpan(makePeer(2)));
+  }
+
+  TEST_F(BlockDownloadSchedulerTest, extendsScheduledChain) {
+    ASSERT_TRUE(scheduler.addChain(makePeer(9), 10, std::vector<crypto::hash>(ids.begin(), ids.begin() + 3)));
+    ASSERT_TRUE(scheduler.addChain(makePeer(9), 11, std::vector<crypto::hash>(ids.begin() + 1, ids.end())));
+
+    std::vector<crypto::hash> span;
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(1), 100, span));
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(2), 100, span));
+    ASSERT_EQ(std::vector<crypto::hash>(ids.begin() + 2, ids.begin() + 4), span);
+  }
+
+  TEST_F(BlockDownloadSchedulerTest, rejectsConflictingChain) {
+    ASSERT_TRUE(scheduler.addChain(makePeer(9), 10, ids));
+
+    ASSERT_FALSE(scheduler.addChain(makePeer(9), 12, makeIds(4, 2)));
+    ASSERT_FALSE(scheduler.addChain(makePeer(9), 20, makeIds(4, 1)));
+  }
+
+  TEST_F(BlockDownloadSchedulerTest, ignoresSpansRequestedBeforeReset) {
+    ASSERT_TRUE(scheduler.addChain(makePeer(9), 10, ids));
+
+    std::vector<crypto::hash> span;
+    ASSERT_EQ(Reservation::reserved, scheduler.reserveSpan(makePeer(1), 100, span));
+    scheduler.reset();
+
+    ASSERT_FALSE(scheduler.isActive());
+    ASSERT_TRUE(scheduler.hasSpan(makePeer(1)));
+    ASSERT_EQ(BlockDownloadScheduler::Delivery::late, scheduler.deliverSpan(makePeer(1), makeBlocks("first")));
+  }
+}
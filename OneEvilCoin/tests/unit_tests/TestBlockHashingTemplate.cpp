@@ -0,0 +1,122 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "cryptonote_core/BlockHashingTemplate.h"
+#include "cryptonote_core/cryptonote_format_utils.h"
+
+namespace {
+  using CryptoNote::BlockHashingTemplate;
+
+  cryptonote::Block makeBlock(uint8_t majorVersion) {
+    cryptonote::Block block;
+    block.majorVersion = majorVersion;
+    block.minorVersion = 0;
+    block.nonce = 0;
+    // large enough to take several varint bytes
+    block.timestamp = 1408106672;
+    memset(&block.prevId, 0x5a, sizeof(block.prevId));
+
+    block.minerTx.version = 1;
+    block.minerTx.unlockTime = 10;
+    block.minerTx.vin.push_back(cryptonote::TransactionInputGenerate{ 9 });
+
+    if (majorVersion == cryptonote::BLOCK_MAJOR_VERSION_2) {
+      block.parentBlock.majorVersion = cryptonote::BLOCK_MAJOR_VERSION_1;
+      block.parentBlock.minorVersion = 0;
+      memset(&block.parentBlock.prevId, 0xa5, sizeof(block.parentBlock.prevId));
+      block.parentBlock.numberOfTransactions = 1;
+      block.parentBlock.minerTx = block.minerTx;
+    }
+
+    return block;
+  }
+
+  void checkMatchesLongHash(uint8_t majorVersion) {
+    cryptonote::Block block = makeBlock(majorVersion);
+    BlockHashingTemplate hashingTemplate;
+    ASSERT_TRUE(hashingTemplate.init(block));
+
+    crypto::cn_context context;
+    for (uint32_t nonce : { 0u, 1u, 0x807F00ABu, 0xFFFFFFFFu }) {
+      block.nonce = nonce;
+      crypto::hash expected;
+      ASSERT_TRUE(cryptonote::get_block_longhash(context, block, expected));
+
+      crypto::hash actual;
+      hashingTemplate.hash(context, nonce, actual);
+      ASSERT_EQ(expected, actual);
+    }
+  }
+
+  TEST(BlockHashingTemplate, matchesLongHashForVersion1) {
+    checkMatchesLongHash(cryptonote::BLOCK_MAJOR_VERSION_1);
+  }
+
+  TEST(BlockHashingTemplate, matchesLongHashForMergeMinedVersion2) {
+    checkMatchesLongHash(cryptonote::BLOCK_MAJOR_VERSION_2);
+  }
+
+  void checkMultiMatchesLongHash(uint8_t majorVersion, size_t ways) {
+    cryptonote::Block block = makeBlock(majorVersion);
+    BlockHashingTemplate hashingTemplate;
+    ASSERT_TRUE(hashingTemplate.init(block));
+
+    crypto::cn_multi_context multiContext(ways);
+    uint32_t nonces[] = { 7, 0x807F00AB, 0, 0xFFFFFFFF };
+    crypto::hash hashes[crypto::SLOW_HASH_MAX_WAYS];
+    hashingTemplate.hash(multiContext, nonces, hashes);
+
+    crypto::cn_context context;
+    for (size_t i = 0; i < ways; ++i) {
+      block.nonce = nonces[i];
+      crypto::hash expected;
+      ASSERT_TRUE(cryptonote::get_block_longhash(context, block, expected));
+      ASSERT_EQ(expected, hashes[i]);
+    }
+  }
+
+  TEST(BlockHashingTemplate, multiWayHashMatchesLongHash) {
+    checkMultiMatchesLongHash(cryptonote::BLOCK_MAJOR_VERSION_1, 2);
+    checkMultiMatchesLongHash(cryptonote::BLOCK_MAJOR_VERSION_2, 4);
+  }
+
+  TEST(BlockHashingTemplate, ignoresNonceOfSourceBlock) {
+    cryptonote::Block block = makeBlock(cryptonote::BLOCK_MAJOR_VERSION_1);
+    block.nonce = 12345;
+    BlockHashingTemplate hashingTemplate;
+    ASSERT_TRUE(hashingTemplate.init(block));
+
+    crypto::cn_context context;
+    block.nonce = 777;
+    crypto::hash expected;
+    ASSERT_TRUE(cryptonote::get_block_longhash(context, block, expected));
+
+    crypto::hash actual;
+    hashingTemplate.hash(context, 777, actual);
+    ASSERT_EQ(expected, actual);
+  }
+
+  TEST(BlockHashingTemplate, failsForUnknownVersion) {
+    cryptonote::Block block = makeBlock(cryptonote::BLOCK_MAJOR_VERSION_1);
+    block.majorVersion = cryptonote::BLOCK_MAJOR_VERSION_2 + 1;
+    BlockHashingTemplate hashingTemplate;
+    ASSERT_FALSE(hashingTemplate.init(block));
+    ASSERT_FALSE(hashingTemplate.isInitialized());
+  }
+}
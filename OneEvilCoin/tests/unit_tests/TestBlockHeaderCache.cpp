@@ -0,0 +1,63 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "cryptonote_core/BlockHeaderCache.h"
+
+namespace {
+  using CryptoNote::BlockHeaderCache;
+
+  void pushBlocks(BlockHeaderCache& headers, size_t count, uint64_t firstTimestamp, uint64_t timestampStep) {
+    for (size_t i = 0; i < count; ++i) {
+      uint64_t height = headers.size();
+      headers.push(firstTimestamp + i * timestampStep, 100 * (height + 1), 1000 + height, 10 * (height + 1));
+    }
+  }
+
+  TEST(BlockHeaderCache, pushAndPopKeepColumnsInSync) {
+    BlockHeaderCache headers;
+    ASSERT_TRUE(headers.empty());
+
+    pushBlocks(headers, 3, 1000, 60);
+    ASSERT_EQ(3, headers.size());
+    ASSERT_EQ(1120, headers.timestamp(2));
+    ASSERT_EQ(300, headers.cumulativeDifficulty(2));
+    ASSERT_EQ(1002, headers.blockCumulativeSize(2));
+    ASSERT_EQ(30, headers.alreadyGeneratedCoins(2));
+
+    headers.pop();
+    ASSERT_EQ(2, headers.size());
+    ASSERT_EQ(1060, headers.timestamp(1));
+    ASSERT_EQ(200, headers.cumulativeDifficulty(1));
+
+    headers.clear();
+    ASSERT_TRUE(headers.empty());
+  }
+
+  TEST(BlockHeaderCache, timestampLowerBound) {
+    BlockHeaderCache headers;
+    pushBlocks(headers, 10, 1000, 60);
+
+    ASSERT_EQ(0, headers.timestampLowerBound(0, 0));
+    ASSERT_EQ(2, headers.timestampLowerBound(0, 1120));
+    ASSERT_EQ(3, headers.timestampLowerBound(0, 1121));
+    ASSERT_EQ(5, headers.timestampLowerBound(5, 1000));
+    ASSERT_EQ(headers.size(), headers.timestampLowerBound(0, 2000));
+    ASSERT_EQ(headers.size(), headers.timestampLowerBound(headers.size(), 0));
+  }
+}
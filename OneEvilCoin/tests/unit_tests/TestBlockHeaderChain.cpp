@@ -0,0 +1,170 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#include "gtest/gtest.h"
+
+#include "string_tools.h"
+
+#include "cryptonote_core/BlockHeaderChain.h"
+#include "cryptonote_core/cryptonote_format_utils.h"
+
+using namespace CryptoNote;
+using namespace cryptonote;
+
+namespace {
+  const uint64_t NOW = 1000000;
+
+  crypto::hash makeHash(uint8_t fill) {
+    crypto::hash hash;
+    memset(&hash, fill, sizeof(hash));
+    return hash;
+  }
+
+  Block makeHeader(uint64_t height, const crypto::hash& prevId, uint64_t timestamp) {
+    Block header = boost::value_initialized<Block>();
+    header.majorVersion = BLOCK_MAJOR_VERSION_1;
+    header.timestamp = timestamp;
+    header.prevId = prevId;
+    TransactionInputGenerate input;
+    input.height = static_cast<size_t>(height);
+    header.minerTx.vin.push_back(input);
+    return header;
+  }
+
+  class BlockHeaderChainTest : public ::testing::Test {
+  public:
+    BlockHeaderChainTest() : m_currency(CurrencyBuilder().timestampCheckWindow(3).currency()), m_chain(m_currency) {
+    }
+
+  protected:
+    // headers from the chain height on, each one a second after the previous one
+    std::vector<Block> makeHeaders(const crypto::hash& prevId, size_t count, uint64_t timestamp) {
+      std::vector<Block> headers;
+      crypto::hash id = prevId;
+      for (size_t i = 0; i < count; ++i) {
+        headers.push_back(makeHeader(m_chain.height() + i, id, timestamp + i));
+        id = get_block_hash(headers.back());
+      }
+
+      return headers;
+    }
+
+    // checks and appends the headers as a whole, the way the blockchain does
+    bool append(const std::vector<Block>& headers, const std::vector<crypto::hash>& longHashes) {
+      std::vector<difficulty_type> difficulties;
+      size_t count = m_chain.check(headers, m_checkpoints, NOW, difficulties);
+      return m_chain.append(headers, difficulties, longHashes, m_checkpoints) && count == headers.size();
+    }
+
+    std::vector<crypto::hash> idsOf(const std::vector<Block>& headers) {
+      std::vector<crypto::hash> ids;
+      for (const Block& header : headers) {
+        ids.push_back(get_block_hash(header));
+      }
+
+      return ids;
+    }
+
+    Currency m_currency;
+    checkpoints m_checkpoints;
+    BlockHeaderChain m_chain;
+  };
+
+  TEST_F(BlockHeaderChainTest, appendsLinkedHeaders) {
+    m_chain.reset(1, makeHash(1), { 100 }, { 1 });
+    std::vector<Block> headers = makeHeaders(makeHash(1), 3, 200);
+
+    ASSERT_TRUE(append(headers, std::vector<crypto::hash>(3, makeHash(0))));
+    ASSERT_EQ(4, m_chain.height());
+    ASSERT_EQ(3, m_chain.countChecked(1, idsOf(headers)));
+    ASSERT_EQ(1, m_chain.countChecked(2, { idsOf(headers)[1], makeHash(2) }));
+  }
+
+  TEST_F(BlockHeaderChainTest, rejectsHeaderNotContinuingChain) {
+    m_chain.reset(1, makeHash(1), { 100 }, { 1 });
+
+    ASSERT_FALSE(append({ makeHeader(1, makeHash(2), 200) }, { makeHash(0) }));
+    ASSERT_FALSE(append({ makeHeader(2, makeHash(1), 200) }, { makeHash(0) }));
+    ASSERT_EQ(1, m_chain.height());
+  }
+
+  TEST_F(BlockHeaderChainTest, checksHeadersWithoutProofOfWorkUpToFirstInvalidOne) {
+    m_chain.reset(1, makeHash(1), { 100 }, { 1 });
+    std::vector<Block> headers = makeHeaders(makeHash(1), 3, 200);
+    headers.push_back(makeHeader(4, makeHash(2), 300));
+    std::vector<difficulty_type> difficulties;
+
+    ASSERT_EQ(3, m_chain.check(headers, m_checkpoints, NOW, difficulties));
+    ASSERT_EQ(3, difficulties.size());
+    ASSERT_EQ(1, m_chain.height());
+
+    ASSERT_TRUE(m_chain.append(headers, difficulties, std::vector<crypto::hash>(4, makeHash(0)), m_checkpoints));
+    ASSERT_EQ(4, m_chain.height());
+  }
+
+  TEST_F(BlockHeaderChainTest, appendsHeadersUpToFirstWithoutProofOfWork) {
+    m_chain.reset(3, makeHash(1), { 100, 200, 201 }, { 1, 1001, 2001 });
+    std::vector<Block> headers = makeHeaders(makeHash(1), 2, 300);
+    std::vector<difficulty_type> difficulties;
+    ASSERT_EQ(2, m_chain.check(headers, m_checkpoints, NOW, difficulties));
+
+    ASSERT_FALSE(m_chain.append(headers, difficulties, { makeHash(0), makeHash(0xff) }, m_checkpoints));
+    ASSERT_EQ(4, m_chain.height());
+    ASSERT_EQ(1, m_chain.countChecked(3, idsOf(headers)));
+  }
+
+  TEST_F(BlockHeaderChainTest, rejectsTimestampBelowMedian) {
+    m_chain.reset(3, makeHash(1), { 100, 200, 300 }, { 1, 2, 3 });
+
+    ASSERT_FALSE(append({ makeHeader(3, makeHash(1), 150) }, { makeHash(0) }));
+    ASSERT_TRUE(append({ makeHeader(3, makeHash(1), 250) }, { makeHash(0) }));
+  }
+
+  TEST_F(BlockHeaderChainTest, rejectsTimestampTooFarInFuture) {
+    m_chain.reset(1, makeHash(1), { 100 }, { 1 });
+    uint64_t timestamp = NOW + m_currency.blockFutureTimeLimit() + 1;
+
+    ASSERT_FALSE(append({ makeHeader(1, makeHash(1), timestamp) }, { makeHash(0) }));
+  }
+
+  TEST_F(BlockHeaderChainTest, checksProofOfWorkAgainstChainDifficulty) {
+    // a second between blocks of difficulty 1000 makes the next difficulty high enough to fail the largest hash
+    m_chain.reset(3, makeHash(1), { 100, 200, 201 }, { 1, 1001, 2001 });
+
+    ASSERT_FALSE(append({ makeHeader(3, makeHash(1), 300) }, { makeHash(0xff) }));
+    ASSERT_TRUE(append({ makeHeader(3, makeHash(1), 300) }, { makeHash(0) }));
+  }
+
+  TEST_F(BlockHeaderChainTest, comparesHeadersInCheckpointZoneWithCheckpoints) {
+    m_chain.reset(3, makeHash(1), { 100, 200, 201 }, { 1, 1001, 2001 });
+    Block header = makeHeader(3, makeHash(1), 300);
+    ASSERT_TRUE(m_checkpoints.add_checkpoint(3, epee::string_tools::pod_to_hex(get_block_hash(header))));
+
+    ASSERT_FALSE(append({ makeHeader(3, makeHash(1), 301) }, { makeHash(0) }));
+    ASSERT_TRUE(append({ header }, { makeHash(0xff) }));
+  }
+
+  TEST_F(BlockHeaderChainTest, forgetsIdsOfAddedBlocks) {
+    m_chain.reset(1, makeHash(1), { 100 }, { 1 });
+    std::vector<Block> headers = makeHeaders(makeHash(1), 3, 200);
+    ASSERT_TRUE(append(headers, std::vector<crypto::hash>(3, makeHash(0))));
+
+    m_chain.forgetBelow(3);
+    ASSERT_EQ(0, m_chain.countChecked(1, idsOf(headers)));
+    ASSERT_EQ(1, m_chain.countChecked(3, { idsOf(headers)[2] }));
+    ASSERT_EQ(4, m_chain.height());
+  }
+}
@@ -0,0 +1,95 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "cryptonote_core/BlockTemplateCache.h"
+#include "cryptonote_core/account.h"
+#include "cryptonote_core/cryptonote_format_utils.h"
+
+using namespace CryptoNote;
+
+namespace {
+  class BlockTemplateCacheTest : public ::testing::Test {
+  public:
+    BlockTemplateCacheTest() :
+      builds(0),
+      cache([this](cryptonote::Block& block, const cryptonote::AccountPublicAddress& address, cryptonote::difficulty_type& difficulty,
+          uint64_t& height, const cryptonote::blobdata& extraNonce) {
+        ++builds;
+        block = cryptonote::Block();
+        block.majorVersion = cryptonote::BLOCK_MAJOR_VERSION_1;
+        block.prevId = tip;
+        block.minerTx.vin.push_back(cryptonote::TransactionInputGenerate{ 10 });
+        cryptonote::add_tx_pub_key_to_extra(block.minerTx, address.m_spendPublicKey);
+        cryptonote::add_extra_nonce_to_tx_extra(block.minerTx.extra, extraNonce);
+        difficulty = 100;
+        height = 10;
+        return true;
+      }, std::chrono::seconds(60)) {
+      account.generate();
+      tip = crypto::cn_fast_hash("tip", 3);
+    }
+
+  protected:
+    size_t builds;
+    crypto::hash tip;
+    cryptonote::account_base account;
+    BlockTemplateCache cache;
+  };
+
+  TEST_F(BlockTemplateCacheTest, buildsOncePerVersion) {
+    const cryptonote::AccountPublicAddress& address = account.get_keys().m_account_address;
+    BlockTemplateInstance first;
+    BlockTemplateInstance second;
+    ASSERT_TRUE(cache.getTemplate(address, 8, 1, first));
+    ASSERT_TRUE(cache.getTemplate(address, 8, 1, second));
+    ASSERT_EQ(1, builds);
+    ASSERT_EQ(1, first.version);
+
+    ASSERT_TRUE(cache.getTemplate(address, 8, 2, second));
+    ASSERT_EQ(2, builds);
+    ASSERT_TRUE(cache.getTemplate(address, 4, 2, second));
+    ASSERT_EQ(3, builds);
+  }
+
+  TEST_F(BlockTemplateCacheTest, issuesDistinctInstances) {
+    const cryptonote::AccountPublicAddress& address = account.get_keys().m_account_address;
+    BlockTemplateInstance first;
+    BlockTemplateInstance second;
+    ASSERT_TRUE(cache.getTemplate(address, 8, 1, first));
+    ASSERT_TRUE(cache.getTemplate(address, 8, 1, second));
+
+    ASSERT_NE(first.blob, second.blob);
+    ASSERT_EQ(first.reservedOffset, second.reservedOffset);
+    ASSERT_EQ(first.blob.substr(first.reservedOffset), second.blob.substr(second.reservedOffset));
+
+    cryptonote::Block block;
+    ASSERT_TRUE(cryptonote::parse_and_validate_block_from_blob(first.blob, block));
+    std::vector<cryptonote::tx_extra_field> fields;
+    ASSERT_TRUE(cryptonote::parse_tx_extra(block.minerTx.extra, fields));
+    cryptonote::tx_extra_nonce nonce;
+    ASSERT_TRUE(cryptonote::find_tx_extra_field_by_type(fields, nonce));
+    ASSERT_EQ(BlockTemplateCache::INSTANCE_TAG_SIZE + 8, nonce.nonce.size());
+    ASSERT_EQ(first.blob.substr(first.reservedOffset - BlockTemplateCache::INSTANCE_TAG_SIZE, nonce.nonce.size()), nonce.nonce);
+  }
+
+  TEST_F(BlockTemplateCacheTest, rejectsTooBigReserve) {
+    BlockTemplateInstance instance;
+    ASSERT_FALSE(cache.getTemplate(account.get_keys().m_account_address, TX_EXTRA_NONCE_MAX_COUNT, 1, instance));
+  }
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <thread>
+
+#include "cryptonote_core/BlockTemplateNotifier.h"
+
+using namespace CryptoNote;
+
+namespace {
+  TEST(BlockTemplateNotifier, changesOnBlocksAndRemovedTransactions) {
+    BlockTemplateNotifier notifier(0);
+    uint64_t version = notifier.version();
+
+    notifier.blockchainUpdated();
+    ASSERT_EQ(version + 1, notifier.version());
+
+    notifier.transactionsRemoved();
+    ASSERT_EQ(version + 2, notifier.version());
+  }
+
+  TEST(BlockTemplateNotifier, accumulatesFeesUpToThreshold) {
+    BlockTemplateNotifier notifier(100);
+    uint64_t version = notifier.version();
+
+    ASSERT_FALSE(notifier.transactionAdded(60));
+    ASSERT_EQ(version, notifier.version());
+    ASSERT_TRUE(notifier.transactionAdded(40));
+    ASSERT_EQ(version + 1, notifier.version());
+
+    // a new block drops the fees seen so far
+    ASSERT_FALSE(notifier.transactionAdded(60));
+    notifier.blockchainUpdated();
+    ASSERT_FALSE(notifier.transactionAdded(60));
+    ASSERT_EQ(version + 2, notifier.version());
+  }
+
+  TEST(BlockTemplateNotifier, zeroThresholdIgnoresFees) {
+    BlockTemplateNotifier notifier(0);
+    uint64_t version = notifier.version();
+    ASSERT_FALSE(notifier.transactionAdded(UINT64_MAX));
+    ASSERT_EQ(version, notifier.version());
+  }
+
+  TEST(BlockTemplateNotifier, waitReturnsOnChange) {
+    BlockTemplateNotifier notifier(0);
+    uint64_t version = notifier.version();
+
+    std::thread updater([&notifier] {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      notifier.blockchainUpdated();
+    });
+
+    uint64_t changedVersion = notifier.waitForChange(version, std::chrono::seconds(10));
+    updater.join();
+    ASSERT_EQ(version + 1, changedVersion);
+  }
+
+  TEST(BlockTemplateNotifier, waitTimesOut) {
+    BlockTemplateNotifier notifier(0);
+    uint64_t version = notifier.version();
+    ASSERT_EQ(version, notifier.waitForChange(version, std::chrono::milliseconds(10)));
+  }
+
+  TEST(BlockTemplateNotifier, waitReturnsAtOnceForStaleVersion) {
+    BlockTemplateNotifier notifier(0);
+    uint64_t version = notifier.version();
+    ASSERT_EQ(version, notifier.waitForChange(version - 1, std::chrono::seconds(10)));
+  }
+}
@@ -0,0 +1,196 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <boost/filesystem.hpp>
+
+#include "cryptonote_core/account.h"
+#include "cryptonote_core/blockchain_storage.h"
+#include "cryptonote_core/Currency.h"
+#include "cryptonote_core/ITimeProvider.h"
+#include "cryptonote_core/tx_pool.h"
+#include "cryptonote_protocol/cryptonote_protocol_defs.h"
+
+#include "../TestGenerator/TestGenerator.h"
+
+using namespace cryptonote;
+
+namespace {
+  class Node {
+  public:
+    Node(const Currency& currency) : m_pool(currency, m_storage, m_timeProvider), m_storage(currency, m_pool) {
+    }
+
+    blockchain_storage& storage() {
+      return m_storage;
+    }
+
+  private:
+    CryptoNote::RealTimeProvider m_timeProvider;
+    tx_memory_pool m_pool;
+    blockchain_storage m_storage;
+  };
+
+  class BlockchainCacheJournal : public ::testing::Test {
+  public:
+    BlockchainCacheJournal() : m_currency(CurrencyBuilder().currency()), m_generator(m_currency) {
+      m_miner.generate();
+      std::vector<size_t> blockSizes;
+      m_generator.addBlock(m_currency.genesisBlock(), 0, 0, blockSizes, 0);
+    }
+
+    void SetUp() override {
+      m_dataDir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+      boost::filesystem::create_directory(m_dataDir);
+    }
+
+    void TearDown() override {
+      boost::system::error_code ec;
+      boost::filesystem::remove_all(m_dataDir, ec);
+    }
+
+  protected:
+    std::vector<Block> addBlocks(blockchain_storage& storage, const Block& prev, size_t count) {
+      std::vector<Block> blocks;
+      const Block* last = &prev;
+      for (size_t i = 0; i < count; ++i) {
+        Block block;
+        EXPECT_TRUE(m_generator.constructBlock(block, *last, m_miner));
+        block_verification_context bvc = boost::value_initialized<block_verification_context>();
+        EXPECT_TRUE(storage.add_new_block(block, bvc));
+        EXPECT_FALSE(bvc.m_verifivation_failed);
+        blocks.push_back(block);
+        last = &blocks.back();
+      }
+
+      return blocks;
+    }
+
+    Currency m_currency;
+    test_generator m_generator;
+    account_base m_miner;
+    boost::filesystem::path m_dataDir;
+  };
+
+  TEST_F(BlockchainCacheJournal, replaysBlocksPushedAfterSnapshot) {
+    std::vector<Block> chain;
+    {
+      Node node(m_currency);
+      ASSERT_TRUE(node.storage().init(m_dataDir.string(), true));
+      chain = addBlocks(node.storage(), m_currency.genesisBlock(), 3);
+      ASSERT_TRUE(node.storage().storeCache());
+      auto tail = addBlocks(node.storage(), chain.back(), 2);
+      chain.insert(chain.end(), tail.begin(), tail.end());
+      ASSERT_TRUE(node.storage().deinit());
+    }
+
+    Node node(m_currency);
+    ASSERT_TRUE(node.storage().init(m_dataDir.string(), true));
+    ASSERT_EQ(chain.size() + 1, node.storage().get_current_blockchain_height());
+    ASSERT_EQ(get_block_hash(chain.back()), node.storage().get_tail_id());
+    ASSERT_TRUE(node.storage().have_tx(get_transaction_hash(chain.back().minerTx)));
+    ASSERT_EQ(chain.back().timestamp, node.storage().getBlockTimestamp(chain.size()));
+  }
+
+  TEST_F(BlockchainCacheJournal, rollsBackBlocksPoppedAfterSnapshot) {
+    std::vector<Block> mainChain;
+    std::vector<Block> altChain;
+    {
+      Node node(m_currency);
+      ASSERT_TRUE(node.storage().init(m_dataDir.string(), true));
+      mainChain = addBlocks(node.storage(), m_currency.genesisBlock(), 4);
+      ASSERT_TRUE(node.storage().storeCache());
+
+      // A longer chain forking off the second block pops the last two blocks of the snapshot
+      altChain = addBlocks(node.storage(), mainChain[1], 3);
+      ASSERT_EQ(get_block_hash(altChain.back()), node.storage().get_tail_id());
+      ASSERT_TRUE(node.storage().deinit());
+    }
+
+    Node node(m_currency);
+    ASSERT_TRUE(node.storage().init(m_dataDir.string(), true));
+    ASSERT_EQ(6, node.storage().get_current_blockchain_height());
+    ASSERT_EQ(get_block_hash(altChain.back()), node.storage().get_tail_id());
+    ASSERT_FALSE(node.storage().have_block(get_block_hash(mainChain[2])));
+    ASSERT_FALSE(node.storage().have_tx(get_transaction_hash(mainChain[3].minerTx)));
+    ASSERT_TRUE(node.storage().have_tx(get_transaction_hash(altChain[0].minerTx)));
+    ASSERT_EQ(get_block_hash(altChain[0]), node.storage().get_block_id_by_height(3));
+  }
+
+  TEST_F(BlockchainCacheJournal, rollsBackBlocksPoppedAfterLaterSnapshot) {
+    std::vector<Block> altChain;
+    std::vector<Block> secondAltChain;
+    {
+      Node node(m_currency);
+      ASSERT_TRUE(node.storage().init(m_dataDir.string(), true));
+      std::vector<Block> mainChain = addBlocks(node.storage(), m_currency.genesisBlock(), 4);
+      ASSERT_TRUE(node.storage().storeCache());
+      altChain = addBlocks(node.storage(), mainChain[1], 3);
+
+      // The second snapshot drops the journal of the first one
+      ASSERT_TRUE(node.storage().storeCache());
+      secondAltChain = addBlocks(node.storage(), altChain[0], 3);
+      ASSERT_TRUE(node.storage().deinit());
+    }
+
+    Node node(m_currency);
+    ASSERT_TRUE(node.storage().init(m_dataDir.string(), true));
+    ASSERT_EQ(7, node.storage().get_current_blockchain_height());
+    ASSERT_EQ(get_block_hash(secondAltChain.back()), node.storage().get_tail_id());
+    ASSERT_FALSE(node.storage().have_block(get_block_hash(altChain[2])));
+    ASSERT_FALSE(node.storage().have_tx(get_transaction_hash(altChain[1].minerTx)));
+    ASSERT_TRUE(node.storage().have_tx(get_transaction_hash(secondAltChain[0].minerTx)));
+  }
+
+  TEST_F(BlockchainCacheJournal, servesRawBlobsWithoutLoadingBlocks) {
+    std::vector<Block> chain;
+    {
+      Node node(m_currency);
+      ASSERT_TRUE(node.storage().init(m_dataDir.string(), true));
+      chain = addBlocks(node.storage(), m_currency.genesisBlock(), 5);
+      ASSERT_TRUE(node.storage().storeCache());
+      ASSERT_TRUE(node.storage().deinit());
+    }
+
+    // The blob index comes from the snapshot, and the reopened block storage has nothing cached
+    Node node(m_currency);
+    ASSERT_TRUE(node.storage().init(m_dataDir.string(), true));
+    uint64_t loads = node.storage().getBlockEntryLoads();
+
+    std::list<crypto::hash> transactionIds;
+    for (size_t i = 0; i < chain.size(); ++i) {
+      block_complete_entry rawBlock;
+      ASSERT_TRUE(node.storage().getRawBlock(i + 1, rawBlock));
+      ASSERT_EQ(block_to_blob(chain[i]), rawBlock.block);
+      ASSERT_TRUE(rawBlock.txs.empty());
+      transactionIds.push_back(get_transaction_hash(chain[i].minerTx));
+    }
+
+    std::list<blobdata> transactions;
+    std::list<crypto::hash> missed;
+    node.storage().getRawTransactions(transactionIds, transactions, missed);
+    ASSERT_TRUE(missed.empty());
+    ASSERT_EQ(chain.size(), transactions.size());
+    auto transaction = transactions.begin();
+    for (size_t i = 0; i < chain.size(); ++i, ++transaction) {
+      ASSERT_EQ(tx_to_blob(chain[i].minerTx), *transaction);
+    }
+
+    ASSERT_EQ(loads, node.storage().getBlockEntryLoads());
+  }
+}
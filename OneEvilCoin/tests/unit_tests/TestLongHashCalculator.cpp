@@ -0,0 +1,104 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <thread>
+
+#include "cryptonote_core/cryptonote_format_utils.h"
+#include "cryptonote_core/LongHashCalculator.h"
+
+using namespace CryptoNote;
+using namespace cryptonote;
+
+namespace {
+  std::vector<Block> makeBlocks(size_t count) {
+    std::vector<Block> blocks;
+    for (size_t i = 0; i < count; ++i) {
+      Block block = boost::value_initialized<Block>();
+      block.majorVersion = BLOCK_MAJOR_VERSION_1;
+      block.timestamp = i;
+      TransactionInputGenerate input;
+      input.height = i;
+      block.minerTx.vin.push_back(input);
+      blocks.push_back(block);
+    }
+
+    return blocks;
+  }
+
+  TEST(LongHashCalculator, computesLongHashesOfSubmittedBlocks) {
+    LongHashCalculator calculator(2, 100);
+    std::vector<Block> blocks = makeBlocks(5);
+    calculator.submit(blocks);
+
+    crypto::cn_context context;
+    for (const Block& block : blocks) {
+      crypto::hash expected;
+      ASSERT_TRUE(get_block_longhash(context, block, expected));
+
+      crypto::hash longHash;
+      ASSERT_TRUE(calculator.get(get_block_hash(block), longHash));
+      ASSERT_EQ(expected, longHash);
+      ASSERT_TRUE(calculator.take(get_block_hash(block), longHash));
+      ASSERT_EQ(expected, longHash);
+      ASSERT_FALSE(calculator.take(get_block_hash(block), longHash));
+    }
+  }
+
+  TEST(LongHashCalculator, dropsOldestHashesBeyondLimit) {
+    LongHashCalculator calculator(1, 2);
+    std::vector<Block> blocks = makeBlocks(4);
+    calculator.submit(blocks);
+
+    crypto::hash longHash;
+    ASSERT_TRUE(calculator.get(get_block_hash(blocks[3]), longHash));
+    ASSERT_FALSE(calculator.get(get_block_hash(blocks[0]), longHash));
+    ASSERT_TRUE(calculator.get(get_block_hash(blocks[2]), longHash));
+  }
+
+  TEST(LongHashCalculator, knowsOnlySubmittedBlocks) {
+    LongHashCalculator calculator(1, 100);
+    std::vector<Block> blocks = makeBlocks(2);
+    calculator.submit({ blocks[0] });
+
+    crypto::hash longHash;
+    ASSERT_FALSE(calculator.get(get_block_hash(blocks[1]), longHash));
+    ASSERT_TRUE(calculator.get(get_block_hash(blocks[0]), longHash));
+  }
+
+  TEST(LongHashCalculator, startsWorkersOnSubmitAndStopsThemWhenIdle) {
+    LongHashCalculator calculator(2, 100, std::chrono::milliseconds(10));
+    ASSERT_EQ(0, calculator.workerCount());
+
+    std::vector<Block> blocks = makeBlocks(3);
+    calculator.submit({ blocks[0], blocks[1] });
+    ASSERT_GE(2, calculator.workerCount());
+
+    crypto::hash longHash;
+    ASSERT_TRUE(calculator.get(get_block_hash(blocks[1]), longHash));
+    for (size_t i = 0; i < 500 && calculator.workerCount() != 0; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_EQ(0, calculator.workerCount());
+
+    calculator.submit({ blocks[2] });
+    ASSERT_TRUE(calculator.get(get_block_hash(blocks[2]), longHash));
+  }
+}
@@ -0,0 +1,59 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "cryptonote_core/MinerThreadPlacement.h"
+
+using namespace CryptoNote;
+
+namespace {
+  TEST(MinerThreadPlacement, spreadsOverPhysicalCoresBeforeSiblings) {
+    // two packages with two cores each, every core has two SMT siblings
+    std::vector<LogicalCpu> cpus = {
+      { 0, 0, 0 }, { 1, 1, 0 }, { 2, 0, 1 }, { 3, 1, 1 },
+      { 4, 0, 0 }, { 5, 1, 0 }, { 6, 0, 1 }, { 7, 1, 1 }
+    };
+
+    std::vector<uint32_t> expected = { 0, 2, 1, 3, 4, 6, 5, 7 };
+    ASSERT_EQ(expected, spreadOverPhysicalCores(cpus));
+  }
+
+  TEST(MinerThreadPlacement, keepsOrderWithoutTopology) {
+    std::vector<LogicalCpu> cpus = { { 0, 0, 0 }, { 1, 1, 0 }, { 2, 2, 0 } };
+    std::vector<uint32_t> expected = { 0, 1, 2 };
+    ASSERT_EQ(expected, spreadOverPhysicalCores(cpus));
+  }
+
+  TEST(MinerThreadPlacement, parsesCpuLists) {
+    std::vector<uint32_t> cpus;
+    ASSERT_TRUE(parseCpuList("0-3,8,10", cpus));
+    std::vector<uint32_t> expected = { 0, 1, 2, 3, 8, 10 };
+    ASSERT_EQ(expected, cpus);
+
+    ASSERT_FALSE(parseCpuList("", cpus));
+    ASSERT_FALSE(parseCpuList("3-1", cpus));
+    ASSERT_FALSE(parseCpuList("a,1", cpus));
+  }
+
+  TEST(MinerThreadPlacement, parsesPriorities) {
+    MinerThreadPriority priority;
+    ASSERT_TRUE(parseMinerThreadPriority("idle", priority));
+    ASSERT_EQ(MinerThreadPriority::IDLE, priority);
+    ASSERT_FALSE(parseMinerThreadPriority("high", priority));
+  }
+}
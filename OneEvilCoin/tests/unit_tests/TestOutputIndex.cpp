@@ -0,0 +1,90 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "cryptonote_core/OutputIndex.h"
+
+namespace {
+  using CryptoNote::OutputIndex;
+
+  crypto::public_key key(uint8_t seed) {
+    crypto::public_key result;
+    memset(&result, seed, sizeof(result));
+    return result;
+  }
+
+  TEST(OutputIndex, pushReturnsGlobalIndexPerAmount) {
+    OutputIndex outputs;
+    ASSERT_EQ(nullptr, outputs.find(10));
+
+    ASSERT_EQ(0, outputs.push(10, 1, 0, 0, key(1), 0));
+    ASSERT_EQ(0, outputs.push(20, 1, 0, 1, key(1), 0));
+    ASSERT_EQ(1, outputs.push(10, 2, 1, 3, key(2), 0));
+
+    const OutputIndex::AmountOutputs* amountOutputs = outputs.find(10);
+    ASSERT_NE(nullptr, amountOutputs);
+    ASSERT_EQ(2, amountOutputs->outputs.size());
+    ASSERT_EQ(2, amountOutputs->outputs[1].block);
+    ASSERT_EQ(1, amountOutputs->outputs[1].transaction);
+    ASSERT_EQ(3, amountOutputs->outputs[1].output);
+  }
+
+  TEST(OutputIndex, keysAreKeptInSyncWithOutputs) {
+    OutputIndex outputs;
+    outputs.push(10, 1, 0, 0, key(1), 0);
+    outputs.push(10, 2, 0, 0, key(2), 100);
+
+    const OutputIndex::AmountOutputs* amountOutputs = outputs.find(10);
+    ASSERT_EQ(2, amountOutputs->keys.size());
+    ASSERT_EQ(key(2), amountOutputs->keys[1].key);
+    ASSERT_EQ(100, amountOutputs->keys[1].unlockTime);
+
+    outputs.pop(10);
+    ASSERT_EQ(1, amountOutputs->keys.size());
+    ASSERT_EQ(key(1), amountOutputs->keys.back().key);
+  }
+
+  TEST(OutputIndex, popRemovesEmptyAmounts) {
+    OutputIndex outputs;
+    outputs.push(10, 1, 0, 0, key(1), 0);
+    outputs.push(10, 2, 0, 0, key(2), 0);
+
+    outputs.pop(10);
+    ASSERT_EQ(1, outputs.find(10)->outputs.size());
+    ASSERT_EQ(1, outputs.find(10)->outputs.back().block);
+
+    outputs.pop(10);
+    ASSERT_EQ(nullptr, outputs.find(10));
+    ASSERT_TRUE(outputs.begin() == outputs.end());
+  }
+
+  TEST(OutputIndex, countUpToBlock) {
+    OutputIndex outputs;
+    outputs.push(10, 3, 0, 0, key(3), 0);
+    outputs.push(10, 3, 1, 0, key(3), 0);
+    outputs.push(10, 5, 0, 0, key(5), 0);
+    outputs.push(10, 8, 0, 0, key(8), 0);
+
+    ASSERT_EQ(0, outputs.countUpToBlock(10, 2));
+    ASSERT_EQ(2, outputs.countUpToBlock(10, 3));
+    ASSERT_EQ(2, outputs.countUpToBlock(10, 4));
+    ASSERT_EQ(3, outputs.countUpToBlock(10, 7));
+    ASSERT_EQ(4, outputs.countUpToBlock(10, 100));
+    ASSERT_EQ(0, outputs.countUpToBlock(20, 100));
+  }
+}
@@ -0,0 +1,110 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <thread>
+
+#include "crypto/crypto.h"
+#include "cryptonote_core/RingSignatureVerifier.h"
+
+namespace {
+  using CryptoNote::RingSignatureVerifier;
+
+  RingSignatureVerifier::Check makeCheck(size_t ringSize) {
+    RingSignatureVerifier::Check check;
+    check.prefixHash = crypto::rand<crypto::hash>();
+
+    std::vector<crypto::secret_key> secretKeys(ringSize);
+    check.keys.resize(ringSize);
+    for (size_t i = 0; i < ringSize; ++i) {
+      crypto::generate_keys(check.keys[i], secretKeys[i]);
+    }
+
+    size_t realIndex = ringSize / 2;
+    crypto::generate_key_image(check.keys[realIndex], secretKeys[realIndex], check.keyImage);
+
+    std::vector<const crypto::public_key*> keys;
+    for (const crypto::public_key& key : check.keys) {
+      keys.push_back(&key);
+    }
+
+    check.signatures.resize(ringSize);
+    crypto::generate_ring_signature(check.prefixHash, check.keyImage, keys, secretKeys[realIndex], realIndex, check.signatures.data());
+    return check;
+  }
+
+  std::vector<RingSignatureVerifier::Check> makeChecks(size_t count) {
+    std::vector<RingSignatureVerifier::Check> checks;
+    for (size_t i = 0; i < count; ++i) {
+      checks.push_back(makeCheck(1 + i % 4));
+    }
+
+    return checks;
+  }
+
+  TEST(RingSignatureVerifier, acceptsValidSignatures) {
+    RingSignatureVerifier verifier(3);
+    ASSERT_TRUE(verifier.verify(std::vector<RingSignatureVerifier::Check>()));
+    ASSERT_TRUE(verifier.verify(makeChecks(20)));
+  }
+
+  TEST(RingSignatureVerifier, rejectsBatchWithInvalidSignature) {
+    RingSignatureVerifier verifier(3);
+    auto checks = makeChecks(20);
+    checks[13].prefixHash = crypto::rand<crypto::hash>();
+    ASSERT_FALSE(verifier.verify(checks));
+
+    // the pool is reusable after a failed batch
+    checks[13] = makeCheck(2);
+    ASSERT_TRUE(verifier.verify(checks));
+  }
+
+  TEST(RingSignatureVerifier, verifiesWithoutWorkers) {
+    RingSignatureVerifier verifier(0);
+    auto checks = makeChecks(5);
+    ASSERT_TRUE(verifier.verify(checks));
+
+    checks[4].signatures.pop_back();
+    ASSERT_FALSE(verifier.verify(checks));
+  }
+
+  TEST(RingSignatureVerifier, verifiesBatchesOfConcurrentCallers) {
+    RingSignatureVerifier verifier(2);
+    auto validChecks = makeChecks(12);
+    auto invalidChecks = makeChecks(12);
+    invalidChecks[7].prefixHash = crypto::rand<crypto::hash>();
+
+    std::vector<std::thread> callers;
+    std::vector<char> results(8);
+    for (size_t i = 0; i < results.size(); ++i) {
+      callers.emplace_back([&, i] {
+        for (int round = 0; round < 5; ++round) {
+          results[i] = verifier.verify(i % 2 == 0 ? validChecks : invalidChecks);
+        }
+      });
+    }
+
+    for (std::thread& caller : callers) {
+      caller.join();
+    }
+
+    for (size_t i = 0; i < results.size(); ++i) {
+      ASSERT_EQ(i % 2 == 0, results[i] != 0);
+    }
+  }
+}
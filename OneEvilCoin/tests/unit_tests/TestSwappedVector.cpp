@@ -0,0 +1,105 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#include "gtest/gtest.h"
+#include "gtest/gtest.h"
+
+#include <boost/filesystem.hpp>
+
+#include "cryptonote_core/SwappedVector.h"
+#include "serialization/string.h"
+
+namespace {
+  class SwappedVectorTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() override {
+      m_directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+      boost::filesystem::create_directory(m_directory);
+    }
+
+    virtual void TearDown() override {
+      boost::system::error_code ec;
+      boost::filesystem::remove_all(m_directory, ec);
+    }
+
+    bool open(SwappedVector<std::string>& vector, size_t poolSize) {
+      return vector.open((m_directory / "items.bin").string(), (m_directory / "indexes.bin").string(), poolSize);
+    }
+
+    boost::filesystem::path m_directory;
+  };
+
+  TEST_F(SwappedVectorTest, keepsItemsEvictedFromCacheAliveForReaders) {
+    SwappedVector<std::string> vector;
+    ASSERT_TRUE(open(vector, 1));
+    vector.push_back("first");
+    vector.push_back("second");
+
+    SwappedVector<std::string>::ItemPtr first = vector[0];
+    ASSERT_EQ("second", *vector[1]);
+    ASSERT_EQ("first", *first);
+    ASSERT_EQ("first", *vector[0]);
+  }
+
+  TEST_F(SwappedVectorTest, readsItemsAfterReopening) {
+    {
+      SwappedVector<std::string> vector;
+      ASSERT_TRUE(open(vector, 1));
+      for (size_t i = 0; i < 100; ++i) {
+        vector.push_back(std::string(i + 1, static_cast<char>('a' + i % 26)));
+      }
+    }
+
+    SwappedVector<std::string> vector;
+    ASSERT_TRUE(open(vector, 4));
+    ASSERT_EQ(100, vector.size());
+    for (size_t i = 0; i < 100; ++i) {
+      ASSERT_EQ(std::string(i + 1, static_cast<char>('a' + i % 26)), *vector[i]);
+    }
+
+    vector.pop_back();
+    vector.push_back("last");
+    ASSERT_EQ("last", *vector.back());
+  }
+
+  TEST_F(SwappedVectorTest, appendsPastReservedCapacityAfterReopening) {
+    const size_t itemSize = 4096;
+    {
+      SwappedVector<std::string> vector;
+      ASSERT_TRUE(open(vector, 1));
+      for (size_t i = 0; i < 300; ++i) {
+        vector.push_back(std::string(itemSize, static_cast<char>('a' + i % 26)));
+      }
+
+      ASSERT_LT(300 * (itemSize + 2), boost::filesystem::file_size(m_directory / "items.bin"));
+    }
+
+    SwappedVector<std::string> vector;
+    ASSERT_TRUE(open(vector, 1));
+    ASSERT_EQ(300, vector.size());
+    for (size_t i = 300; i < 600; ++i) {
+      vector.push_back(std::string(itemSize, static_cast<char>('a' + i % 26)));
+    }
+
+    for (size_t i = 0; i < 600; ++i) {
+      ASSERT_EQ(std::string(itemSize, static_cast<char>('a' + i % 26)), *vector[i]);
+    }
+
+    SwappedVector<std::string>::ItemSpan span = vector.itemSpan(599);
+    ASSERT_EQ(itemSize + 2, span.size);
+    ASSERT_EQ('a' + 599 % 26, span.data[span.size - 1]);
+  }
+}
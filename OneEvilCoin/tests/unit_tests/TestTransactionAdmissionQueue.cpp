@@ -0,0 +1,164 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "cryptonote_core/TransactionAdmissionQueue.h"
+
+using namespace CryptoNote;
+
+namespace {
+  const TransactionAdmissionQueue::PeerId peer1 = {{1}};
+  const TransactionAdmissionQueue::PeerId peer2 = {{2}};
+
+  class Gate {
+  public:
+    Gate() : m_open(false) {}
+
+    void wait() {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      while (!m_open) {
+        m_opened.wait(lock);
+      }
+    }
+
+    void open() {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_open = true;
+      m_opened.notify_all();
+    }
+
+  private:
+    std::mutex m_mutex;
+    std::condition_variable m_opened;
+    bool m_open;
+  };
+
+  // opens the gate when a failed assertion leaves the test, so the queue destructor doesn't wait for a blocked worker
+  class GateOpener {
+  public:
+    explicit GateOpener(Gate& gate) : m_gate(gate) {}
+    ~GateOpener() { m_gate.open(); }
+
+  private:
+    Gate& m_gate;
+  };
+
+  bool waitForCount(const std::atomic<size_t>& counter, size_t count) {
+    for (size_t i = 0; i < 1000 && counter.load() < count; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    return counter.load() == count;
+  }
+
+  TEST(TransactionAdmissionQueue, runsPushedBatches) {
+    std::atomic<size_t> processed(0);
+    TransactionAdmissionQueue queue(2, 100, 100);
+
+    for (size_t i = 0; i < 100; ++i) {
+      ASSERT_TRUE(queue.push(peer1, [&processed] { ++processed; }));
+    }
+
+    ASSERT_TRUE(waitForCount(processed, 100));
+  }
+
+  TEST(TransactionAdmissionQueue, dropsWaitingBatchesOnStop) {
+    Gate started;
+    Gate gate;
+    std::atomic<size_t> processed(0);
+    TransactionAdmissionQueue queue(1, 100, 100);
+    GateOpener opener(gate);
+
+    ASSERT_TRUE(queue.push(peer1, [&] { started.open(); gate.wait(); ++processed; }));
+    started.wait();
+    for (size_t i = 0; i < 10; ++i) {
+      ASSERT_TRUE(queue.push(peer1, [&processed] { ++processed; }));
+    }
+
+    std::thread stopper([&queue] { queue.stop(); });
+    while (queue.push(peer2, [] {})) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    gate.open();
+    stopper.join();
+    ASSERT_EQ(1, processed.load());
+  }
+
+  TEST(TransactionAdmissionQueue, rejectsBatchesAfterStop) {
+    std::atomic<size_t> processed(0);
+    TransactionAdmissionQueue queue(1, 4, 4);
+    queue.stop();
+
+    ASSERT_FALSE(queue.push(peer1, [&processed] { ++processed; }));
+    ASSERT_EQ(0, processed.load());
+  }
+
+  TEST(TransactionAdmissionQueue, rejectsBatchesOfBusyPeerOnly) {
+    Gate gate;
+    std::atomic<size_t> processed(0);
+    TransactionAdmissionQueue queue(1, 10, 2);
+    GateOpener opener(gate);
+
+    ASSERT_TRUE(queue.push(peer1, [&] { gate.wait(); ++processed; }));
+    ASSERT_TRUE(queue.push(peer1, [&processed] { ++processed; }));
+    ASSERT_FALSE(queue.push(peer1, [&processed] { ++processed; }));
+    ASSERT_TRUE(queue.push(peer2, [&processed] { ++processed; }));
+
+    gate.open();
+    ASSERT_TRUE(waitForCount(processed, 3));
+  }
+
+  TEST(TransactionAdmissionQueue, rejectsBatchesWhenFullWithoutBlocking) {
+    Gate started;
+    Gate gate;
+    std::atomic<size_t> processed(0);
+    TransactionAdmissionQueue queue(1, 1, 10);
+    GateOpener opener(gate);
+
+    ASSERT_TRUE(queue.push(peer1, [&] { started.open(); gate.wait(); ++processed; }));
+    started.wait();
+    ASSERT_TRUE(queue.push(peer1, [&processed] { ++processed; }));
+    ASSERT_FALSE(queue.push(peer2, [&processed] { ++processed; }));
+
+    gate.open();
+    ASSERT_TRUE(waitForCount(processed, 2));
+  }
+
+  TEST(TransactionAdmissionQueue, releasesPeerLimitWhenBatchThrows) {
+    std::atomic<size_t> processed(0);
+    TransactionAdmissionQueue queue(1, 10, 1);
+
+    ASSERT_TRUE(queue.push(peer1, [&processed] { ++processed; throw std::runtime_error("bad batch"); }));
+    ASSERT_TRUE(waitForCount(processed, 1));
+
+    // the worker survived and the peer can push again once the failed batch is released
+    for (size_t i = 0; i < 1000 && !queue.push(peer1, [&processed] { ++processed; }); ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_TRUE(waitForCount(processed, 2));
+  }
+}
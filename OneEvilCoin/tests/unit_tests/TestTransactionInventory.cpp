@@ -0,0 +1,119 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <thread>
+
+#include "cryptonote_core/TransactionInventory.h"
+
+using namespace CryptoNote;
+
+namespace {
+  crypto::hash makeId(uint8_t n) {
+    crypto::hash id = crypto::hash();
+    reinterpret_cast<uint8_t*>(&id)[0] = n;
+    return id;
+  }
+
+  TransactionInventory::PeerId makePeer(uint8_t n) {
+    TransactionInventory::PeerId peer = TransactionInventory::PeerId();
+    peer.data[0] = n;
+    return peer;
+  }
+
+  TEST(TransactionInventory, doesNotAnnounceKnownTransactions) {
+    TransactionInventory inventory(100, 100, std::chrono::seconds(10), 100);
+    inventory.addKnown(makePeer(1), { makeId(1) });
+    inventory.queue(makePeer(1), { makeId(1), makeId(2) });
+    inventory.queue(makePeer(1), { makeId(2), makeId(3) });
+
+    ASSERT_EQ(std::vector<crypto::hash>({ makeId(2), makeId(3) }), inventory.takeQueued(makePeer(1), 10));
+    ASSERT_TRUE(inventory.takeQueued(makePeer(1), 10).empty());
+  }
+
+  TEST(TransactionInventory, takesAtMostMaxCountAnnouncements) {
+    TransactionInventory inventory(100, 100, std::chrono::seconds(10), 100);
+    inventory.queue(makePeer(1), { makeId(1), makeId(2), makeId(3) });
+
+    ASSERT_EQ(std::vector<crypto::hash>({ makeId(1), makeId(2) }), inventory.takeQueued(makePeer(1), 2));
+    ASSERT_EQ(std::vector<crypto::hash>({ makeId(3) }), inventory.takeQueued(makePeer(1), 2));
+  }
+
+  TEST(TransactionInventory, forgetsOldestKnownTransactionsBeyondLimit) {
+    TransactionInventory inventory(2, 100, std::chrono::seconds(10), 100);
+    inventory.addKnown(makePeer(1), { makeId(1), makeId(2), makeId(3) });
+    inventory.queue(makePeer(1), { makeId(1), makeId(3) });
+
+    ASSERT_EQ(std::vector<crypto::hash>({ makeId(1) }), inventory.takeQueued(makePeer(1), 10));
+  }
+
+  TEST(TransactionInventory, requestsTransactionOnlyOnce) {
+    TransactionInventory inventory(100, 100, std::chrono::seconds(10), 100);
+
+    ASSERT_EQ(std::vector<crypto::hash>({ makeId(1) }), inventory.startRequests(makePeer(1), { makeId(1) }));
+    ASSERT_EQ(std::vector<crypto::hash>({ makeId(2) }), inventory.startRequests(makePeer(1), { makeId(1), makeId(2) }));
+
+    inventory.finishRequests({ makeId(1) });
+    ASSERT_EQ(std::vector<crypto::hash>({ makeId(1) }), inventory.startRequests(makePeer(1), { makeId(1) }));
+  }
+
+  TEST(TransactionInventory, requestsTransactionAgainAfterTimeout) {
+    TransactionInventory inventory(100, 100, std::chrono::seconds(0), 100);
+
+    ASSERT_EQ(std::vector<crypto::hash>({ makeId(1) }), inventory.startRequests(makePeer(1), { makeId(1) }));
+    ASSERT_EQ(std::vector<crypto::hash>({ makeId(1) }), inventory.startRequests(makePeer(1), { makeId(1) }));
+  }
+
+  TEST(TransactionInventory, dropsOldestAnnouncementsBeyondQueueLimit) {
+    TransactionInventory inventory(100, 2, std::chrono::seconds(10), 100);
+    inventory.queue(makePeer(1), { makeId(1), makeId(2), makeId(3) });
+
+    ASSERT_EQ(std::vector<crypto::hash>({ makeId(2), makeId(3) }), inventory.takeQueued(makePeer(1), 10));
+  }
+
+  TEST(TransactionInventory, requestsExpiredTransactionFromNextAnnouncers) {
+    TransactionInventory inventory(100, 100, std::chrono::seconds(1), 100);
+    for (uint8_t peer = 1; peer <= 3; ++peer) {
+      inventory.addKnown(makePeer(peer), { makeId(1) });
+    }
+
+    ASSERT_EQ(std::vector<crypto::hash>({ makeId(1) }), inventory.startRequests(makePeer(1), { makeId(1) }));
+    ASSERT_TRUE(inventory.startRequests(makePeer(2), { makeId(1) }).empty());
+    ASSERT_TRUE(inventory.startRequests(makePeer(3), { makeId(1) }).empty());
+    ASSERT_TRUE(inventory.expireRequests().empty());
+    inventory.removePeer(makePeer(2));
+
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    auto requests = inventory.expireRequests();
+    ASSERT_EQ(1, requests.size());
+    ASSERT_EQ(std::vector<crypto::hash>({ makeId(1) }), requests[makePeer(3)]);
+
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    ASSERT_TRUE(inventory.expireRequests().empty());
+    ASSERT_EQ(std::vector<crypto::hash>({ makeId(1) }), inventory.startRequests(makePeer(1), { makeId(1) }));
+  }
+
+  TEST(TransactionInventory, limitsTransactionsServedToPeer) {
+    TransactionInventory inventory(100, 100, std::chrono::seconds(10), 10);
+
+    ASSERT_EQ(15, inventory.takeServed(makePeer(1), 15));
+    ASSERT_EQ(5, inventory.takeServed(makePeer(1), 15));
+    ASSERT_EQ(0, inventory.takeServed(makePeer(1), 15));
+    ASSERT_EQ(15, inventory.takeServed(makePeer(2), 15));
+  }
+}
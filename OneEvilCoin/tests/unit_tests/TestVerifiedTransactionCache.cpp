@@ -0,0 +1,68 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "cryptonote_core/VerifiedTransactionCache.h"
+
+namespace {
+  using CryptoNote::BlockInfo;
+  using CryptoNote::VerifiedTransactionCache;
+
+  crypto::hash makeHash(uint8_t seed) {
+    crypto::hash result;
+    memset(&result, seed, sizeof(result));
+    return result;
+  }
+
+  BlockInfo makeBlock(uint64_t height) {
+    BlockInfo block;
+    block.height = height;
+    block.id = makeHash(static_cast<uint8_t>(height));
+    return block;
+  }
+
+  TEST(VerifiedTransactionCache, findReturnsMaxUsedBlock) {
+    VerifiedTransactionCache cache(10);
+    BlockInfo block;
+    ASSERT_FALSE(cache.find(makeHash(1), block));
+
+    cache.add(makeHash(1), makeBlock(5));
+    ASSERT_TRUE(cache.find(makeHash(1), block));
+    ASSERT_EQ(5, block.height);
+    ASSERT_EQ(makeHash(5), block.id);
+
+    cache.add(makeHash(1), makeBlock(7));
+    ASSERT_TRUE(cache.find(makeHash(1), block));
+    ASSERT_EQ(7, block.height);
+
+    cache.clear();
+    ASSERT_FALSE(cache.find(makeHash(1), block));
+  }
+
+  TEST(VerifiedTransactionCache, evictsOldestTransactions) {
+    VerifiedTransactionCache cache(3);
+    for (uint8_t i = 1; i <= 4; ++i) {
+      cache.add(makeHash(i), makeBlock(i));
+    }
+
+    BlockInfo block;
+    ASSERT_FALSE(cache.find(makeHash(1), block));
+    ASSERT_TRUE(cache.find(makeHash(2), block));
+    ASSERT_TRUE(cache.find(makeHash(4), block));
+  }
+}
@@ -25,6 +25,7 @@
 #include "include_base_utils.h"
 #include "string_tools.h"
 #include "net/abstract_tcp_server2.h"
+#include "net/levin_protocol_handler_async.h"
 
 namespace
 {
@@ -68,6 +69,54 @@ namespace
   };
 
   typedef epee::net_utils::boosted_tcp_server<test_protocol_handler> test_tcp_server;
+
+  const uint32_t relay_server_port = 5627;
+
+  struct relay_connection_context : public epee::net_utils::connection_context_base
+  {
+  };
+
+  struct relay_commands_handler : public epee::levin::levin_commands_handler<relay_connection_context>
+  {
+    relay_commands_handler()
+      : m_connected(false)
+    {
+    }
+
+    virtual int invoke(int command, const std::string& in_buff, std::string& buff_out, relay_connection_context& context)
+    {
+      return LEVIN_OK;
+    }
+
+    virtual int notify(int command, const std::string& in_buff, relay_connection_context& context)
+    {
+      return LEVIN_OK;
+    }
+
+    virtual void on_connection_new(relay_connection_context& context)
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_connection_id = context.m_connection_id;
+      m_connected = true;
+      m_cond.notify_one();
+    }
+
+    bool wait_connection(boost::uuids::uuid& connection_id)
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      if (!m_cond.wait_for(lock, std::chrono::seconds(5), [this] { return m_connected; }))
+        return false;
+      connection_id = m_connection_id;
+      return true;
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_connected;
+    boost::uuids::uuid m_connection_id;
+  };
+
+  typedef epee::net_utils::boosted_tcp_server<epee::levin::async_protocol_handler<relay_connection_context>> relay_tcp_server;
 }
 
 TEST(boosted_tcp_server, worker_threads_are_exception_resistant)
@@ -98,12 +147,15 @@ TEST(boosted_tcp_server, worker_threads_are_exception_resistant)
 
   {
     std::unique_lock<std::mutex> lock(mtx);
-    ASSERT_NE(std::cv_status::timeout, cond.wait_for(lock, std::chrono::seconds(5)));
+    ASSERT_TRUE(cond.wait_for(lock, std::chrono::seconds(5), [&counter] { return 4 <= counter; }));
     ASSERT_EQ(4, counter);
   }
 
   // Check if threads are alive
-  counter = 0;
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    counter = 0;
+  }
   //auto counter_incrementer = [&counter]() { counter.fetch_add(1); epee::misc_utils::sleep_no_w(counter.load() * 10); };
   ASSERT_TRUE(srv.async_call(counter_incrementer));
   ASSERT_TRUE(srv.async_call(counter_incrementer));
@@ -112,7 +164,7 @@ TEST(boosted_tcp_server, worker_threads_are_exception_resistant)
 
   {
     std::unique_lock<std::mutex> lock(mtx);
-    ASSERT_NE(std::cv_status::timeout, cond.wait_for(lock, std::chrono::seconds(5)));
+    ASSERT_TRUE(cond.wait_for(lock, std::chrono::seconds(5), [&counter] { return 4 <= counter; }));
     ASSERT_EQ(4, counter);
   }
 
@@ -120,3 +172,40 @@ TEST(boosted_tcp_server, worker_threads_are_exception_resistant)
   ASSERT_TRUE(srv.timed_wait_server_stop(5 * 1000));
   ASSERT_TRUE(srv.deinit_server());
 }
+
+TEST(boosted_tcp_server, bursty_relays_to_slow_peer_fit_send_queue)
+{
+  relay_commands_handler commands_handler;
+  relay_tcp_server srv;
+  srv.get_config_object().m_pcommands_handler = &commands_handler;
+  ASSERT_TRUE(srv.init_server(relay_server_port, test_server_host));
+  ASSERT_TRUE(srv.run_server(2, false));
+
+  boost::asio::io_service io_service;
+  boost::asio::ip::tcp::socket peer(io_service);
+  peer.connect(boost::asio::ip::tcp::endpoint(boost::asio::ip::address::from_string(test_server_host), relay_server_port));
+  boost::uuids::uuid connection_id;
+  ASSERT_TRUE(commands_handler.wait_connection(connection_id));
+
+  // a block followed by transaction relays, too big for the socket buffers, so they pile up while the peer doesn't read
+  const size_t body_size = 256 * 1024;
+  size_t expected_size = 0;
+  for (size_t i = 0; i < ABSTRACT_SERVER_SEND_QUE_MAX_COUNT; ++i)
+  {
+    epee::net_utils::shared_buffer body = std::make_shared<const std::string>(i == 0 ? 4 * body_size : body_size, 'x');
+    ASSERT_EQ(1, srv.get_config_object().notify(i == 0 ? 1 : 2, body, connection_id));
+    expected_size += sizeof(epee::levin::bucket_head2) + body->size();
+  }
+
+  // every message takes one queue item, so the connection is still open and delivers all of them
+  std::vector<char> received(expected_size);
+  boost::system::error_code ec;
+  boost::asio::read(peer, boost::asio::buffer(received), ec);
+  ASSERT_FALSE(ec);
+  ASSERT_EQ(1, srv.get_config_object().get_connections_count());
+
+  peer.close();
+  srv.send_stop_signal();
+  ASSERT_TRUE(srv.timed_wait_server_stop(5 * 1000));
+  ASSERT_TRUE(srv.deinit_server());
+}
@@ -17,6 +17,7 @@
 
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -118,6 +119,7 @@ namespace
       : m_io_service(io_service)
       , m_protocol_handler(this, protocol_config, m_context)
       , m_send_return(true)
+      , m_shared_send(false)
     {
     }
 
@@ -136,6 +138,21 @@ namespace
       return m_send_return;
     }
 
+    virtual bool do_send_shared(const void* head, size_t head_cb, const epee::net_utils::shared_buffer& body)
+    {
+      if (!m_shared_send)
+      {
+        return epee::net_utils::i_service_endpoint::do_send_shared(head, head_cb, body);
+      }
+
+      m_send_counter.inc();
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_last_send_data.append(reinterpret_cast<const char*>(head), head_cb);
+      m_last_send_data.append(*body);
+      m_shared_bodies.push_back(body);
+      return m_send_return;
+    }
+
     virtual bool close()                              { /*std::cout << "test_connection::close()" << std::endl; */return true; }
     virtual bool call_run_once_service_io()           { std::cout << "test_connection::call_run_once_service_io()" << std::endl; return true; }
     virtual bool request_callback()                   { std::cout << "test_connection::request_callback()" << std::endl; return true; }
@@ -151,6 +168,10 @@ namespace
     bool send_return() const { return m_send_return; }
     void send_return(bool v) { m_send_return = v; }
 
+    // Keep references to sent bodies like connection<> does, instead of falling back to two do_send calls
+    void shared_send(bool v) { m_shared_send = v; }
+    const std::vector<epee::net_utils::shared_buffer>& shared_bodies() const { return m_shared_bodies; }
+
   public:
     test_levin_protocol_handler m_protocol_handler;
 
@@ -162,8 +183,10 @@ namespace
     std::mutex m_mutex;
 
     std::string m_last_send_data;
+    std::vector<epee::net_utils::shared_buffer> m_shared_bodies;
 
     bool m_send_return;
+    bool m_shared_send;
   };
 
   class async_protocol_handler_test : public ::testing::Test
@@ -397,6 +420,63 @@ TEST_F(positive_test_connection_to_levin_protocol_handler_calls, handler_process
   ASSERT_TRUE(conn->last_send_data().empty());
 }
 
+TEST_F(positive_test_connection_to_levin_protocol_handler_calls, handler_sends_shared_notify_buffer_after_head)
+{
+  // Setup
+  const int expected_command = 3416093;
+
+  test_connection_ptr conn = create_connection();
+
+  epee::net_utils::shared_buffer in_data = std::make_shared<const std::string>(256, 'n');
+
+  // Test
+  ASSERT_EQ(1, m_handler_config.notify(expected_command, in_data, conn->m_protocol_handler.get_connection_id()));
+  ASSERT_EQ(1, m_handler_config.notify(expected_command, in_data, conn->m_protocol_handler.get_connection_id()));
+
+  // Check both messages are framed from the same buffer
+  std::string send_data = conn->last_send_data();
+  ASSERT_EQ(2 * (sizeof(epee::levin::bucket_head2) + in_data->size()), send_data.size());
+
+  epee::levin::bucket_head2 head = *reinterpret_cast<const epee::levin::bucket_head2*>(send_data.data());
+  ASSERT_EQ(LEVIN_SIGNATURE, head.m_signature);
+  ASSERT_EQ(expected_command, head.m_command);
+  ASSERT_EQ(in_data->size(), head.m_cb);
+  ASSERT_FALSE(head.m_have_to_return_data);
+  ASSERT_EQ(*in_data, send_data.substr(sizeof(head), in_data->size()));
+  ASSERT_EQ(*in_data, send_data.substr(2 * sizeof(head) + in_data->size()));
+}
+
+TEST_F(positive_test_connection_to_levin_protocol_handler_calls, handler_queues_notify_buffer_by_reference)
+{
+  // Setup
+  const int expected_command = 3416093;
+
+  test_connection_ptr conn1 = create_connection();
+  test_connection_ptr conn2 = create_connection();
+  conn1->shared_send(true);
+  conn2->shared_send(true);
+
+  epee::net_utils::shared_buffer in_data = std::make_shared<const std::string>(256, 'n');
+
+  // Test
+  ASSERT_EQ(1, conn1->m_protocol_handler.notify(expected_command, in_data));
+  ASSERT_EQ(1, conn2->m_protocol_handler.notify(expected_command, in_data));
+
+  // Check both connections hold the caller's buffer rather than a copy of it
+  ASSERT_EQ(1, conn1->shared_bodies().size());
+  ASSERT_EQ(1, conn2->shared_bodies().size());
+  ASSERT_EQ(in_data.get(), conn1->shared_bodies().front().get());
+  ASSERT_EQ(in_data.get(), conn2->shared_bodies().front().get());
+  ASSERT_EQ(3, in_data.use_count());
+
+  std::string send_data = conn1->last_send_data();
+  ASSERT_EQ(sizeof(epee::levin::bucket_head2) + in_data->size(), send_data.size());
+  epee::levin::bucket_head2 head = *reinterpret_cast<const epee::levin::bucket_head2*>(send_data.data());
+  ASSERT_EQ(expected_command, head.m_command);
+  ASSERT_EQ(in_data->size(), head.m_cb);
+  ASSERT_EQ(*in_data, send_data.substr(sizeof(head)));
+}
+
 TEST_F(positive_test_connection_to_levin_protocol_handler_calls, handler_processes_qued_callback)
 {
   test_connection_ptr conn = create_connection();
@@ -0,0 +1,79 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+
+#include "syncobj.h"
+
+TEST(shared_critical_section, sharedLockIsRecursive) {
+  epee::shared_critical_section section;
+  SHARED_CRITICAL_REGION_BEGIN(section);
+  {
+    SHARED_CRITICAL_REGION_LOCAL(section);
+  }
+  CRITICAL_REGION_END();
+}
+
+TEST(shared_critical_section, exclusiveOwnerCanTakeSharedAndExclusiveLock) {
+  epee::shared_critical_section section;
+  EXCLUSIVE_CRITICAL_REGION_BEGIN(section);
+  {
+    SHARED_CRITICAL_REGION_LOCAL(section);
+  }
+  {
+    CRITICAL_REGION_LOCAL(section);
+  }
+  CRITICAL_REGION_END();
+}
+
+TEST(shared_critical_section, readersDoNotBlockEachOther) {
+  epee::shared_critical_section section;
+  SHARED_CRITICAL_REGION_LOCAL(section);
+
+  auto reader = std::async(std::launch::async, [&section] {
+    SHARED_CRITICAL_REGION_LOCAL(section);
+    return true;
+  });
+
+  ASSERT_EQ(std::future_status::ready, reader.wait_for(std::chrono::seconds(5)));
+  ASSERT_TRUE(reader.get());
+}
+
+TEST(shared_critical_section, writerWaitsForReaders) {
+  epee::shared_critical_section section;
+  std::atomic<bool> writerEntered(false);
+  std::future<void> writer;
+
+  {
+    SHARED_CRITICAL_REGION_LOCAL(section);
+    writer = std::async(std::launch::async, [&section, &writerEntered] {
+      EXCLUSIVE_CRITICAL_REGION_LOCAL(section);
+      writerEntered = true;
+    });
+
+    ASSERT_EQ(std::future_status::timeout, writer.wait_for(std::chrono::milliseconds(100)));
+    ASSERT_FALSE(writerEntered);
+  }
+
+  ASSERT_EQ(std::future_status::ready, writer.wait_for(std::chrono::seconds(5)));
+  ASSERT_TRUE(writerEntered);
+}
@@ -72,7 +72,8 @@ public:
   INodeFunctorialStub(TestBlockchainGenerator& generator)
     : INodeNonTrivialRefreshStub(generator)
     , queryBlocksFunctor([](const std::list<crypto::hash>&, uint64_t, std::list<CryptoNote::BlockCompleteEntry>&, uint64_t&, const Callback&)->bool {return true; })
-    , getPoolSymmetricDifferenceFunctor([](const std::vector<crypto::hash>&, crypto::hash, bool&, std::vector<cryptonote::Transaction>&, std::vector<crypto::hash>&, const Callback&)->bool {return true; }) {
+    , getPoolSymmetricDifferenceFunctor([](const std::vector<crypto::hash>&, crypto::hash, bool&, std::vector<cryptonote::Transaction>&, std::vector<crypto::hash>&, const Callback&)->bool {return true; })
+    , getPoolChangesFunctor([](crypto::hash, uint64_t, bool&, bool&, uint64_t&, std::vector<cryptonote::Transaction>&, std::vector<crypto::hash>&, const Callback&)->bool {return true; }) {
   }
 
   virtual void queryBlocks(std::list<crypto::hash>&& knownBlockIds, uint64_t timestamp, std::list<CryptoNote::BlockCompleteEntry>& newBlocks, uint64_t& startHeight, const Callback& callback) override {
@@ -89,7 +90,15 @@ public:
   }
 
   std::function<bool(const std::list<crypto::hash>&, uint64_t, std::list<CryptoNote::BlockCompleteEntry>&, uint64_t&, const Callback&)> queryBlocksFunctor;
+  virtual void getPoolChanges(crypto::hash knownBlockId, uint64_t knownPoolVersion, bool& isBcActual, bool& isPoolVersionActual, uint64_t& poolVersion,
+    std::vector<cryptonote::Transaction>& newTxs, std::vector<crypto::hash>& deletedTxIds, const Callback& callback) override {
+    if (getPoolChangesFunctor(knownBlockId, knownPoolVersion, isBcActual, isPoolVersionActual, poolVersion, newTxs, deletedTxIds, callback)) {
+      INodeNonTrivialRefreshStub::getPoolChanges(knownBlockId, knownPoolVersion, isBcActual, isPoolVersionActual, poolVersion, newTxs, deletedTxIds, callback);
+    }
+  }
+
   std::function<bool(const std::vector<crypto::hash>&, crypto::hash, bool&, std::vector<cryptonote::Transaction>&, std::vector<crypto::hash>&, const Callback&)> getPoolSymmetricDifferenceFunctor;
+  std::function<bool(crypto::hash, uint64_t, bool&, bool&, uint64_t&, std::vector<cryptonote::Transaction>&, std::vector<crypto::hash>&, const Callback&)> getPoolChangesFunctor;
 
 };
 
@@ -697,6 +706,80 @@ TEST_F(BcSTest, poolSynchronizationCheckActual) {
   EXPECT_EQ(2, requestsCount);
 }
 
+TEST_F(BcSTest, poolSynchronizationUsesChangesSinceKnownVersion) {
+  auto knownTxPtr = CryptoNote::createTransaction();
+  auto newTxPtr = CryptoNote::createTransaction();
+  auto knownTx = ::createTx(*knownTxPtr.get());
+  auto newTx = ::createTx(*newTxPtr.get());
+  auto knownTxHash = cryptonote::get_transaction_hash(knownTx);
+  auto unknownTxHash = cryptonote::get_transaction_hash(newTx);
+
+  FunctorialPoolConsumerStub c1(m_currency.genesisBlockHash());
+  c1.getKnownPoolTxIdsFunctor = [&](std::vector<crypto::hash>& ids) { ids.assign({ knownTxHash }); };
+
+  std::vector<cryptonote::Transaction> responseNewPool;
+  std::vector<crypto::hash> responseDeletedPool;
+  c1.onPoolUpdatedFunctor = [&](const std::vector<cryptonote::Transaction>& new_txs, const std::vector<crypto::hash>& deleted)->std::error_code {
+    responseNewPool.assign(new_txs.begin(), new_txs.end());
+    responseDeletedPool.assign(deleted.begin(), deleted.end());
+    return std::error_code();
+  };
+
+  m_sync.addConsumer(&c1);
+
+  const uint64_t firstVersion = 10;
+  std::vector<uint64_t> askedVersions;
+  m_node.getPoolChangesFunctor = [&](crypto::hash, uint64_t knownPoolVersion, bool& isBcActual, bool& isPoolVersionActual, uint64_t& poolVersion,
+    std::vector<cryptonote::Transaction>& newTxs, std::vector<crypto::hash>& deletedTxIds, const INode::Callback& callback) {
+    askedVersions.push_back(knownPoolVersion);
+    isBcActual = true;
+    isPoolVersionActual = knownPoolVersion == firstVersion;
+    poolVersion = firstVersion + askedVersions.size() - 1;
+    if (isPoolVersionActual) {
+      // the consumer already has knownTx and never had unknownTx
+      newTxs.assign({ knownTx, newTx });
+      deletedTxIds.assign({ knownTxHash, unknownTxHash });
+    }
+
+    callback(std::error_code());
+    return false;
+  };
+
+  int fullRequestsCount = 0;
+  m_node.getPoolSymmetricDifferenceFunctor = [&](const std::vector<crypto::hash>& known, crypto::hash last, bool& is_actual, std::vector<cryptonote::Transaction>& new_txs, std::vector<crypto::hash>& deleted, const INode::Callback& callback) {
+    is_actual = true;
+    fullRequestsCount++;
+    callback(std::error_code());
+    return false;
+  };
+
+  IBlockchainSynchronizerFunctorialObserver o1;
+  EventWaiter e;
+  o1.syncFunc = std::move([&e](std::error_code) {
+    e.notify();
+  });
+
+  m_sync.addObserver(&o1);
+  m_sync.start();
+  e.wait();
+
+  // the first synchronization takes the full difference and remembers the version it was taken at
+  ASSERT_EQ(2, fullRequestsCount);
+  ASSERT_EQ(1, askedVersions.size());
+
+  m_node.notifyAboutPool();
+  e.wait();
+  m_sync.stop();
+  m_sync.removeObserver(&o1);
+  o1.syncFunc = [](std::error_code) {};
+
+  EXPECT_EQ(2, fullRequestsCount);
+  ASSERT_EQ(2, askedVersions.size());
+  EXPECT_EQ(firstVersion, askedVersions[1]);
+  EXPECT_EQ(std::vector<cryptonote::Transaction>({ newTx }), responseNewPool);
+  EXPECT_EQ(std::vector<crypto::hash>({ knownTxHash }), responseDeletedPool);
+}
+
 TEST_F(BcSTest, poolSynchronizationCheckError) {
   addConsumers(1);
 
@@ -42,3 +42,52 @@ TEST(protocol_pack, protocol_pack_command)
     ASSERT_TRUE(r.total_height == 3);
   }
 }
+
+namespace
+{
+  struct legacy_core_sync_data
+  {
+    uint64_t current_height;
+    crypto::hash top_id;
+
+    BEGIN_KV_SERIALIZE_MAP()
+      KV_SERIALIZE(current_height)
+      KV_SERIALIZE_VAL_POD_AS_BLOB(top_id)
+    END_KV_SERIALIZE_MAP()
+  };
+}
+
+TEST(protocol_pack, sync_data_of_old_peers_has_no_version)
+{
+  legacy_core_sync_data old_data = boost::value_initialized<legacy_core_sync_data>();
+  old_data.current_height = 5;
+  std::string buff;
+  ASSERT_TRUE(epee::serialization::store_t_to_binary(old_data, buff));
+
+  boost::value_initialized<cryptonote::CORE_SYNC_DATA> data;
+  epee::serialization::load_t_from_binary(static_cast<cryptonote::CORE_SYNC_DATA&>(data), buff);
+  ASSERT_EQ(5, static_cast<cryptonote::CORE_SYNC_DATA&>(data).current_height);
+  ASSERT_EQ(0, static_cast<cryptonote::CORE_SYNC_DATA&>(data).version);
+}
+
+TEST(protocol_pack, compact_block_carries_no_transactions)
+{
+  cryptonote::NOTIFY_NEW_BLOCK::request full_block = boost::value_initialized<cryptonote::NOTIFY_NEW_BLOCK::request>();
+  full_block.b.block = std::string(100, 'b');
+  full_block.b.txs.resize(10, std::string(1000, 't'));
+
+  cryptonote::NOTIFY_NEW_COMPACT_BLOCK::request compact_block = boost::value_initialized<cryptonote::NOTIFY_NEW_COMPACT_BLOCK::request>();
+  compact_block.block = full_block.b.block;
+  compact_block.hop = 2;
+
+  std::string full_buff;
+  std::string compact_buff;
+  ASSERT_TRUE(epee::serialization::store_t_to_binary(full_block, full_buff));
+  ASSERT_TRUE(epee::serialization::store_t_to_binary(compact_block, compact_buff));
+  ASSERT_LT(compact_buff.size() + 10000, full_buff.size());
+
+  cryptonote::NOTIFY_NEW_COMPACT_BLOCK::request loaded;
+  ASSERT_TRUE(epee::serialization::load_t_from_binary(loaded, compact_buff));
+  ASSERT_EQ(compact_block.block, loaded.block);
+  ASSERT_EQ(2, loaded.hop);
+}
@@ -41,6 +41,36 @@ class TransactionValidator : public CryptoNote::ITransactionValidator {
   }
 };
 
+class CountingTransactionValidator : public TransactionValidator {
+public:
+  CountingTransactionValidator() : readinessChecks(0), ready(true) {}
+
+  size_t readinessChecks;
+  bool ready;
+
+  virtual bool checkTransactionInputs(const cryptonote::Transaction& tx, BlockInfo& maxUsedBlock, BlockInfo& lastFailed) {
+    ++readinessChecks;
+    return ready;
+  }
+};
+
+// a block spending the key images of the transaction is added while its inputs are checked
+class BlockSpendingTransactionValidator : public TransactionValidator {
+public:
+  BlockSpendingTransactionValidator() : spent(false) {}
+
+  bool spent;
+
+  virtual bool checkTransactionInputs(const cryptonote::Transaction& tx, BlockInfo& maxUsedBlock) {
+    spent = true;
+    return true;
+  }
+
+  virtual bool haveSpentKeyImages(const cryptonote::Transaction& tx) {
+    return spent;
+  }
+};
+
 class FakeTimeProvider : public ITimeProvider {
 public:
   FakeTimeProvider(time_t currentTime = time(nullptr))
@@ -237,6 +267,21 @@ TEST(tx_pool, double_spend_tx)
 }
 
 
+TEST(tx_pool, rejects_tx_spent_by_block_during_input_checks)
+{
+  Currency currency = CurrencyBuilder().currency();
+  TestPool<BlockSpendingTransactionValidator, RealTimeProvider> pool(currency);
+  Transaction tx;
+  GenerateTransaction(currency, tx, currency.minimumFee(), 1);
+
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+
+  ASSERT_FALSE(pool.add_tx(tx, tvc, false));
+  ASSERT_TRUE(tvc.m_verifivation_failed);
+  ASSERT_FALSE(tvc.m_should_be_relayed);
+  ASSERT_EQ(0, pool.get_transactions_count());
+}
+
 TEST(tx_pool, fillblock_same_fee)
 {
   cryptonote::Currency currency = cryptonote::CurrencyBuilder().currency();
@@ -423,3 +468,177 @@ TEST(tx_pool, add_tx_after_cleanup)
   ASSERT_EQ(1, pool.get_transactions_count());
 
 }
+
+TEST(tx_pool, fillblock_checks_transactions_once_per_tip)
+{
+  cryptonote::Currency currency = cryptonote::CurrencyBuilder().currency();
+  TestPool<CountingTransactionValidator, RealTimeProvider> pool(currency);
+  const uint64_t fee = currency.minimumFee();
+
+  for (int i = 0; i < 5; ++i) {
+    Transaction tx;
+    GenerateTransaction(currency, tx, fee, 1);
+
+    tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+    ASSERT_TRUE(pool.add_tx(tx, tvc, false));
+  }
+
+  Block bl;
+  InitBlock(bl);
+  size_t totalSize = 0;
+  uint64_t txFee = 0;
+  uint64_t median = 100000;
+
+  ASSERT_TRUE(pool.fill_block_template(bl, median, textMaxCumulativeSize, 0, totalSize, txFee));
+  ASSERT_EQ(5, bl.txHashes.size());
+  ASSERT_EQ(5, pool.validator.readinessChecks);
+
+  ASSERT_TRUE(pool.fill_block_template(bl, median, textMaxCumulativeSize, 0, totalSize, txFee));
+  ASSERT_EQ(5, bl.txHashes.size());
+  ASSERT_EQ(5, pool.validator.readinessChecks);
+
+  // a new block invalidates the cached readiness
+  Transaction taken;
+  size_t blobSize;
+  ASSERT_TRUE(pool.take_tx(bl.txHashes.front(), taken, blobSize, txFee));
+  ASSERT_TRUE(pool.on_blockchain_inc(1, crypto::cn_fast_hash("tip", 3)));
+
+  ASSERT_TRUE(pool.fill_block_template(bl, median, textMaxCumulativeSize, 0, totalSize, txFee));
+  ASSERT_EQ(4, bl.txHashes.size());
+  ASSERT_EQ(9, pool.validator.readinessChecks);
+}
+
+TEST(tx_pool, fillblock_rechecks_not_ready_transactions_as_time_passes)
+{
+  cryptonote::Currency currency = cryptonote::CurrencyBuilder().currency();
+  TestPool<CountingTransactionValidator, FakeTimeProvider> pool(currency);
+
+  Transaction tx;
+  GenerateTransaction(currency, tx, currency.minimumFee(), 1);
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool.add_tx(tx, tvc, false));
+
+  Block bl;
+  InitBlock(bl);
+  size_t totalSize = 0;
+  uint64_t txFee = 0;
+  uint64_t median = 100000;
+
+  // spends an output with a time based unlock
+  pool.validator.ready = false;
+  ASSERT_TRUE(pool.fill_block_template(bl, median, textMaxCumulativeSize, 0, totalSize, txFee));
+  ASSERT_EQ(0, bl.txHashes.size());
+  size_t checks = pool.validator.readinessChecks;
+
+  pool.validator.ready = true;
+  ASSERT_TRUE(pool.fill_block_template(bl, median, textMaxCumulativeSize, 0, totalSize, txFee));
+  ASSERT_EQ(0, bl.txHashes.size());
+  ASSERT_EQ(checks, pool.validator.readinessChecks);
+
+  // the output unlocks without a new block
+  pool.timeProvider.timeNow += parameters::CRYPTONOTE_MEMPOOL_READINESS_TIME_STEP;
+  ASSERT_TRUE(pool.fill_block_template(bl, median, textMaxCumulativeSize, 0, totalSize, txFee));
+  ASSERT_EQ(1, bl.txHashes.size());
+  ASSERT_EQ(checks + 1, pool.validator.readinessChecks);
+}
+
+TEST(tx_pool, evicts_cheapest_transactions_when_full)
+{
+  cryptonote::Currency currency = cryptonote::CurrencyBuilder().currency();
+  TestPool<TransactionValidator, RealTimeProvider> pool(currency);
+  const uint64_t fee = currency.minimumFee();
+
+  std::vector<crypto::hash> ids;
+  for (int i = 1; i <= 3; ++i) {
+    Transaction tx;
+    GenerateTransaction(currency, tx, fee * i, 1);
+
+    tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+    ASSERT_TRUE(pool.add_tx(tx, tvc, false));
+    ASSERT_TRUE(tvc.m_added_to_pool);
+    ids.push_back(get_transaction_hash(tx));
+  }
+
+  size_t usage = pool.get_memory_usage();
+  ASSERT_LT(0, usage);
+
+  // room for about two transactions, the cheapest one has to go
+  pool.set_max_memory_usage(usage * 3 / 4);
+
+  Transaction expensive;
+  GenerateTransaction(currency, expensive, fee * 4, 1);
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool.add_tx(expensive, tvc, false));
+  ASSERT_TRUE(tvc.m_added_to_pool);
+
+  ASSERT_EQ(2, pool.get_evicted_transactions_count());
+  ASSERT_FALSE(pool.have_tx(ids[0]));
+  ASSERT_FALSE(pool.have_tx(ids[1]));
+  ASSERT_TRUE(pool.have_tx(ids[2]));
+  ASSERT_TRUE(pool.have_tx(get_transaction_hash(expensive)));
+  ASSERT_LE(pool.get_memory_usage(), usage * 3 / 4);
+
+  // a transaction cheaper than everything left is rejected
+  Transaction cheap;
+  GenerateTransaction(currency, cheap, fee, 1);
+  tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool.add_tx(cheap, tvc, false));
+  ASSERT_FALSE(tvc.m_added_to_pool);
+  ASSERT_FALSE(tvc.m_verifivation_failed);
+  ASSERT_FALSE(pool.have_tx(get_transaction_hash(cheap)));
+  ASSERT_EQ(2, pool.get_transactions_count());
+}
+
+TEST(tx_pool, reports_changes_since_known_version)
+{
+  cryptonote::Currency currency = cryptonote::CurrencyBuilder().currency();
+  TestPool<TransactionValidator, RealTimeProvider> pool(currency);
+  const uint64_t fee = currency.minimumFee();
+
+  std::vector<crypto::hash> newIds;
+  std::vector<crypto::hash> deletedIds;
+  uint64_t startVersion = 0;
+  // a version the pool never had can't be answered, but the current one is returned
+  ASSERT_FALSE(pool.get_changes(0, newIds, deletedIds, startVersion));
+  ASSERT_TRUE(pool.get_changes(startVersion, newIds, deletedIds, startVersion));
+  ASSERT_TRUE(newIds.empty());
+
+  std::vector<Transaction> txs(3);
+  for (auto& tx : txs) {
+    GenerateTransaction(currency, tx, fee, 1);
+    tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+    ASSERT_TRUE(pool.add_tx(tx, tvc, false));
+  }
+
+  uint64_t version = 0;
+  ASSERT_TRUE(pool.get_changes(startVersion, newIds, deletedIds, version));
+  ASSERT_EQ(3, newIds.size());
+  ASSERT_TRUE(deletedIds.empty());
+
+  // a transaction known at the version and taken after it is reported as deleted
+  Transaction taken;
+  size_t blobSize;
+  uint64_t takenFee;
+  ASSERT_TRUE(pool.take_tx(get_transaction_hash(txs[0]), taken, blobSize, takenFee));
+
+  newIds.clear();
+  uint64_t newVersion = 0;
+  ASSERT_TRUE(pool.get_changes(version, newIds, deletedIds, newVersion));
+  ASSERT_TRUE(newIds.empty());
+  ASSERT_EQ(1, deletedIds.size());
+  ASSERT_EQ(get_transaction_hash(txs[0]), deletedIds.front());
+  ASSERT_LT(version, newVersion);
+
+  // a transaction added and taken between the versions is not reported at all
+  deletedIds.clear();
+  ASSERT_TRUE(pool.take_tx(get_transaction_hash(txs[1]), taken, blobSize, takenFee));
+  ASSERT_TRUE(pool.get_changes(startVersion, newIds, deletedIds, newVersion));
+  ASSERT_EQ(1, newIds.size());
+  ASSERT_EQ(get_transaction_hash(txs[2]), newIds.front());
+  ASSERT_TRUE(deletedIds.empty());
+
+  // a new chain tip changes readiness, so older versions can't be answered any more
+  ASSERT_TRUE(pool.on_blockchain_inc(1, crypto::cn_fast_hash("tip", 3)));
+  ASSERT_FALSE(pool.get_changes(newVersion, newIds, deletedIds, version));
+  ASSERT_LT(newVersion, version);
+}